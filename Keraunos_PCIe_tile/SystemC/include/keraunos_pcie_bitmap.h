@@ -0,0 +1,143 @@
+#ifndef KERAUNOS_PCIE_BITMAP_H
+#define KERAUNOS_PCIE_BITMAP_H
+
+// Two-level bitmap (header-only, no SystemC dependency)
+
+#include "keraunos_pcie_checkpoint.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace keraunos {
+namespace pcie {
+
+/**
+ * Hierarchical Bitmap
+ * - Leaf level: one bit per index, packed in 64-bit words
+ * - Summary level: one bit per non-zero leaf word
+ * find_next() scans at most one leaf word, the summary words and one more
+ * leaf word, so locating the next set bit among 2048 (PCIe MSI-X maximum)
+ * costs a few ctz operations instead of a linear walk.
+ */
+class HierarchicalBitmap {
+public:
+    static constexpr size_t NPOS = ~static_cast<size_t>(0);
+
+    explicit HierarchicalBitmap(size_t bits = 0) { resize(bits); }
+
+    // Resize and clear every bit
+    void resize(size_t bits) {
+        bits_ = bits;
+        words_.assign((bits + 63) / 64, 0);
+        summary_.assign((words_.size() + 63) / 64, 0);
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return bits_; }
+    [[nodiscard]] size_t word_count() const noexcept { return words_.size(); }
+
+    [[nodiscard]] bool test(size_t index) const noexcept {
+        return (words_[index >> 6] >> (index & 63)) & 1ULL;
+    }
+
+    void set(size_t index) noexcept {
+        words_[index >> 6] |= (1ULL << (index & 63));
+        summary_[index >> 12] |= (1ULL << ((index >> 6) & 63));
+    }
+
+    void clear(size_t index) noexcept {
+        uint64_t& word = words_[index >> 6];
+        word &= ~(1ULL << (index & 63));
+        if (word == 0) {
+            summary_[index >> 12] &= ~(1ULL << ((index >> 6) & 63));
+        }
+    }
+
+    void assign(size_t index, bool value) noexcept {
+        if (value) set(index); else clear(index);
+    }
+
+    // Raw 64-bit leaf word access (bits beyond size() are always zero)
+    [[nodiscard]] uint64_t word(size_t w) const noexcept { return words_[w]; }
+
+    void set_word(size_t w, uint64_t value) noexcept {
+        value &= tail_mask(w);
+        words_[w] = value;
+        uint64_t bit = 1ULL << (w & 63);
+        summary_[w >> 6] = value ? (summary_[w >> 6] | bit) : (summary_[w >> 6] & ~bit);
+    }
+
+    void set_all() noexcept {
+        for (size_t w = 0; w < words_.size(); w++) {
+            set_word(w, ~0ULL);
+        }
+    }
+
+    void clear_all() noexcept {
+        for (auto& w : words_) w = 0;
+        for (auto& s : summary_) s = 0;
+    }
+
+    // Checkpoint of the leaf words; the summary is rebuilt on restore
+    void save_state(CheckpointWriter& out) const {
+        out.put<uint32_t>(static_cast<uint32_t>(bits_));
+        out.put_bytes(words_.data(), words_.size() * sizeof(uint64_t));
+    }
+
+    bool restore_state(CheckpointReader& in) {
+        if (in.get<uint32_t>() != bits_) in.fail();
+        for (size_t w = 0; w < words_.size() && in.ok(); w++) {
+            set_word(w, in.get<uint64_t>());
+        }
+        return in.ok();
+    }
+
+    [[nodiscard]] bool any() const noexcept {
+        for (uint64_t s : summary_) {
+            if (s) return true;
+        }
+        return false;
+    }
+
+    // First set bit at or after 'from', or NPOS
+    [[nodiscard]] size_t find_next(size_t from) const noexcept {
+        if (from >= bits_) {
+            return NPOS;
+        }
+        size_t w = from >> 6;
+        uint64_t bits = words_[w] & (~0ULL << (from & 63));
+        if (bits) {
+            return (w << 6) + __builtin_ctzll(bits);
+        }
+
+        // Next non-empty leaf word via the summary level
+        size_t next_word = w + 1;
+        if (next_word >= words_.size()) {
+            return NPOS;
+        }
+        size_t s = next_word >> 6;
+        uint64_t summary = summary_[s] & (~0ULL << (next_word & 63));
+        while (!summary) {
+            if (++s >= summary_.size()) {
+                return NPOS;
+            }
+            summary = summary_[s];
+        }
+        size_t found = (s << 6) + __builtin_ctzll(summary);
+        return (found << 6) + __builtin_ctzll(words_[found]);
+    }
+
+private:
+    size_t bits_ = 0;
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> summary_;
+
+    uint64_t tail_mask(size_t w) const noexcept {
+        size_t remaining = bits_ - (w << 6);
+        return (remaining >= 64) ? ~0ULL : ((1ULL << remaining) - 1);
+    }
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_BITMAP_H
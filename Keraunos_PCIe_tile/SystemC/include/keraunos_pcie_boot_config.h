@@ -0,0 +1,85 @@
+#ifndef KERAUNOS_PCIE_BOOT_CONFIG_H
+#define KERAUNOS_PCIE_BOOT_CONFIG_H
+
+// Declarative post-boot tile state, parsed from an INI file
+
+#include "keraunos_pcie_common.h"
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace keraunos {
+namespace pcie {
+
+/**
+ * Boot Configuration
+ * The state firmware leaves the tile in after its SMN boot sequence, for
+ * KeraunosPcieTile::set_boot_config() / apply_boot_config() to write
+ * straight into the components. Text form (';' or '#' starts a comment):
+ *
+ *   [tile]
+ *   system_ready = 1
+ *   outbound_app_enable = 1
+ *   inbound_app_enable = 1
+ *   device_type = rp               ; ep | rp
+ *   bus_num = 5
+ *   dev_num = 1
+ *   bus_master_enable = 1
+ *   msix_enable = 1
+ *   msix_mask = 0
+ *
+ *   [tlb.app_in0_0]                ; sys_in0, app_in0_0..app_in0_3, app_in1,
+ *   0 = 0x80000000, 0x100          ; sys_out0, app_out0, app_out1
+ *                                  ; entry = address[, ATTR[31:0]], made valid
+ *   [msix.pf0]                     ; pf0..pf7
+ *   0 = 0x18800000, 0x5678         ; vector = address, data[, masked]
+ *
+ * Anything not mentioned keeps its reset value.
+ */
+struct BootConfig {
+    enum class Tlb : uint8_t {
+        SysIn0, AppIn0_0, AppIn0_1, AppIn0_2, AppIn0_3, AppIn1, SysOut0, AppOut0, AppOut1
+    };
+    struct TlbWindow {
+        Tlb tlb;
+        uint8_t index;
+        uint64_t addr;              // Unshifted; ADDR[63:12] are kept
+        uint32_t attr;
+    };
+    struct MsixVector {
+        uint8_t pf;
+        uint16_t index;
+        uint64_t address;
+        uint32_t data;
+        bool masked;
+    };
+
+    std::optional<bool> system_ready;
+    std::optional<bool> outbound_app_enable;
+    std::optional<bool> inbound_app_enable;
+    std::optional<bool> device_type_rp;
+    std::optional<uint8_t> bus_num;
+    std::optional<uint8_t> dev_num;
+    std::optional<bool> bus_master_enable;
+    std::optional<bool> msix_enable;
+    std::optional<bool> msix_mask;
+    std::vector<TlbWindow> tlb_windows;
+    std::vector<MsixVector> msix_vectors;
+};
+
+// On failure 'error' names the offending line; 'config' is then partial
+bool parse_boot_config(std::istream& in, BootConfig& config, std::string& error);
+bool load_boot_config(const std::string& path, BootConfig& config, std::string& error);
+
+// The parser bounds MSI-X vectors by the largest relay; this checks them
+// against the relay actually built. On failure 'error' names the first
+// vector outside it
+bool check_boot_config(const BootConfig& config, uint8_t num_pfs, uint16_t vectors_per_pf,
+                       std::string& error);
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_BOOT_CONFIG_H
@@ -0,0 +1,92 @@
+#ifndef KERAUNOS_PCIE_CHECKPOINT_H
+#define KERAUNOS_PCIE_CHECKPOINT_H
+
+// Binary checkpoint streams (header-only, no SystemC dependency)
+// Used by KeraunosPcieTile::save_state()/restore_state() and the
+// components' save_state()/restore_state()
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+namespace keraunos {
+namespace pcie {
+
+// Section tags (values are part of the on-disk format)
+constexpr uint32_t checkpoint_tag(char a, char b, char c, char d) noexcept {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) |
+           static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16 |
+           static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24;
+}
+
+/**
+ * Checkpoint Writer
+ * Raw host-endian fields, no padding: a checkpoint restores on the host
+ * type that wrote it. Stream errors are sticky and reported by ok().
+ */
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(std::ostream& out) : out_(out) {}
+
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() takes plain values");
+        out_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void put_flag(bool value) { put<uint8_t>(value ? 1 : 0); }
+    void put_bytes(const void* data, size_t length) {
+        out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(length));
+    }
+    void begin_section(uint32_t tag) { put(tag); }
+
+    [[nodiscard]] bool ok() const { return static_cast<bool>(out_); }
+
+private:
+    std::ostream& out_;
+};
+
+/**
+ * Checkpoint Reader
+ * Mirrors CheckpointWriter. The first short read, tag mismatch or value a
+ * component rejects (fail()) makes ok() false for good; getters then
+ * return zeroes, so restore code can read a whole section and check once.
+ */
+class CheckpointReader {
+public:
+    explicit CheckpointReader(std::istream& in) : in_(in) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "get() returns plain values");
+        T value{};
+        get_bytes(&value, sizeof(T));
+        return ok_ ? value : T{};
+    }
+    bool get_flag() { return get<uint8_t>() != 0; }
+    void get_bytes(void* data, size_t length) {
+        if (ok_) {
+            in_.read(static_cast<char*>(data), static_cast<std::streamsize>(length));
+            ok_ = static_cast<size_t>(in_.gcount()) == length;
+        }
+    }
+    // Fails the reader unless the next section is 'tag'
+    bool expect_section(uint32_t tag) {
+        if (get<uint32_t>() != tag) ok_ = false;
+        return ok_;
+    }
+
+    void fail() noexcept { ok_ = false; }
+    [[nodiscard]] bool ok() const noexcept { return ok_; }
+
+private:
+    std::istream& in_;
+    bool ok_ = true;
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_CHECKPOINT_H
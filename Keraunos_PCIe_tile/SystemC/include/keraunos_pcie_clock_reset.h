@@ -3,8 +3,8 @@
 
 // REFACTORED: C++ class
 
+#include "keraunos_pcie_checkpoint.h"
 #include "keraunos_pcie_common.h"
-#include <systemc>
 #include <cstdint>
 
 namespace keraunos {
@@ -24,6 +24,8 @@ public:
     [[nodiscard]] bool get_force_to_ref_clk_n() const noexcept { return force_to_ref_clk_n_; }
     [[nodiscard]] bool get_pcie_clock() const noexcept { return pcie_clock_; }
     [[nodiscard]] bool get_ref_clock() const noexcept { return ref_clock_; }
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
     bool cold_reset_n_, warm_reset_n_, isolate_req_;
@@ -1,10 +1,8 @@
 #ifndef KERAUNOS_PCIE_COMMON_H
 #define KERAUNOS_PCIE_COMMON_H
 
-#include <systemc>
-#include <tlm>
+#include "keraunos_pcie_transaction.h"
 #include <cstdint>
-#include <sc_dt.h>
 
 namespace keraunos {
 namespace pcie {
@@ -37,6 +35,12 @@ constexpr uint64_t SOC_CLOCK_FREQ = 400000000ULL;        // 400 MHz
 constexpr uint64_t AHB_CLOCK_FREQ = 500000000ULL;        // 500 MHz
 constexpr uint64_t REF_CLOCK_FREQ = 100000000ULL;        // 100 MHz
 
+// Outstanding-transaction watchdog resolution (timer wheel tick)
+constexpr uint64_t WATCHDOG_TICK_PS = 1000ULL;           // 1 ns
+
+// MSI interrupt moderation interval resolution
+constexpr uint64_t MSI_MODERATION_TICK_PS = 1000ULL;     // 1 ns
+
 // Reset types
 enum class ResetType {
     COLD_RESET,      // Management Reset + Main Reset
@@ -61,6 +65,16 @@ constexpr uint64_t TLB_APP_OUTBOUND_BASE = 0x18900000ULL;// 1MB: 0x18900000-0x18
 // TLB Sys0 Outbound data path (via SMN-IO)
 constexpr uint64_t TLB_SYS_OUTBOUND_BASE = 0x18400000ULL;// 1MB: 0x18400000-0x184FFFFF
 
+// MSI relay function layout: one 16KB CSR window (and one MSI input slot in the
+// NOC-IO MSI window) per physical function; offset bits [17:14] select the PF,
+// windows 8-15 of the 256KB config range are reserved
+constexpr uint8_t MSI_RELAY_NUM_PFS = 8;
+constexpr uint32_t MSI_RELAY_PF_WINDOW = 0x4000;         // 16KB per PF
+constexpr uint32_t MSI_RELAY_PF_SHIFT = 14;
+constexpr uint16_t MSI_RELAY_MAX_VECTORS = 2048;         // PCIe MSI-X Table Size limit
+constexpr uint16_t MSI_EGRESS_DEFAULT_DEPTH = 16;        // MSI writes queued or in flight
+constexpr uint16_t MSI_EGRESS_DEFAULT_OUTSTANDING = 4;   // MSI writes in flight on the NOC
+
 // System Ready register address (special routing)
 constexpr uint64_t SYSTEM_READY_ADDR = 0xE000000000000000ULL;  // AxADDR[63:60] = 0xE, [59:7] = 0
 
@@ -69,26 +83,9 @@ struct OutstandingRequest {
     uint64_t id;
     uint64_t addr;
     bool is_read;
-    sc_core::sc_time timestamp;
+    SimTime timestamp;
     
-    OutstandingRequest() : id(0), addr(0), is_read(false), timestamp(sc_core::SC_ZERO_TIME) {}
-};
-
-// AxUSER TLM extension — carries sideband (AxUSER) info through TLM transactions.
-// Used by outbound TLBs to pass TLB ATTR to NOC-PCIE for BME qualification.
-struct AxUserExtension : public tlm::tlm_extension<AxUserExtension> {
-    sc_dt::sc_bv<256> axuser;
-
-    AxUserExtension() : axuser(0) {}
-
-    tlm::tlm_extension_base* clone() const override {
-        auto* e = new AxUserExtension;
-        e->axuser = axuser;
-        return e;
-    }
-    void copy_from(const tlm::tlm_extension_base& other) override {
-        axuser = static_cast<const AxUserExtension&>(other).axuser;
-    }
+    OutstandingRequest() : id(0), addr(0), is_read(false), timestamp(0) {}
 };
 
 // Address masking helpers for 52-bit addresses
@@ -99,11 +96,11 @@ constexpr uint64_t ADDR_52BIT_MASK = 0x000FFFFFFFFFFFFFULL;  // 52-bit mask
     return addr & ADDR_52BIT_MASK;
 }
 
-inline void set_52bit_address(tlm::tlm_generic_payload& trans, const uint64_t addr) noexcept {
+inline void set_52bit_address(Transaction& trans, const uint64_t addr) noexcept {
     trans.set_address(mask_52bit_address(addr));
 }
 
-[[nodiscard]] inline uint64_t get_52bit_address(const tlm::tlm_generic_payload& trans) noexcept {
+[[nodiscard]] inline uint64_t get_52bit_address(const Transaction& trans) noexcept {
     return mask_52bit_address(trans.get_address());
 }
 
@@ -3,12 +3,10 @@
 
 // REFACTORED: C++ class with callback for value change notification
 
-#include <scml2.h>
-#include <scml2/memory.h>
-#include <systemc>
-#include <tlm>
-#include <sc_dt.h>
+#include "keraunos_pcie_sparse_regs.h"
+#include "keraunos_pcie_transaction.h"
 #include <functional>
+#include <memory>
 #include <cstdint>
 
 namespace keraunos {
@@ -23,7 +21,7 @@ public:
     ~ConfigRegBlock() = default;
     
     // Function interface (replaces apb_socket)
-    void process_apb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_apb_access(Transaction& trans, SimTime& delay);
     
     // Status register outputs (const noexcept for performance, [[nodiscard]] to catch unused returns)
     [[nodiscard]] bool get_system_ready() const noexcept { return system_ready_; }
@@ -33,9 +31,17 @@ public:
     // Control input (noexcept - no exceptions thrown)
     void set_isolate_req(const bool isolate) noexcept;
     
+    // Direct register programming (boot configuration): same effect as the
+    // SMN writes to the status and enable registers
+    void set_control(bool system_ready, bool outbound_app_enable, bool inbound_app_enable);
+    // Registers back to their reset values (O(1)); fires the callback
+    void reset();
+    
     // Callback for when config registers change
     using ConfigChangeCallback = std::function<void()>;
     void set_change_callback(ConfigChangeCallback callback) { change_callback_ = callback; }
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
     bool system_ready_;
@@ -43,14 +49,15 @@ private:
     bool pcie_inbound_app_enable_;
     bool isolate_req_;
     
-    // SCML2 memory for config space with persistent storage
-    scml2::memory<uint8_t> config_memory_;
+    // Sparse store for config space with persistent storage
+    SparseRegisterStore config_memory_;
     
     // Callback for config changes
     ConfigChangeCallback change_callback_;
     
-    void process_read(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_write(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_read(Transaction& trans, SimTime& delay);
+    void process_write(Transaction& trans, SimTime& delay);
+    static const std::shared_ptr<const SparseRegisterStore>& reset_image();
     
     static const uint32_t SYSTEM_READY_OFFSET = 0x0FFFC;
     static const uint32_t PCIE_ENABLE_OFFSET = 0x0FFF8;
@@ -0,0 +1,159 @@
+#ifndef KERAUNOS_PCIE_COW_ARRAY_H
+#define KERAUNOS_PCIE_COW_ARRAY_H
+
+// Paged copy-on-write array over a shared reset image (header-only, no
+// SystemC dependency)
+
+#include "keraunos_pcie_checkpoint.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace keraunos {
+namespace pcie {
+
+/**
+ * Copy-on-Write Array
+ * - Fixed-size array whose reset contents come from an immutable image
+ *   shared by every instance built from it (one image per configuration,
+ *   e.g. per TLB type), so N tiles hold one copy of their reset state
+ * - Split into ~4KB pages; the first mutate() of an element gives its page
+ *   a private copy, all other pages keep reading the image
+ * - Private pages carry the epoch they were copied in; reset() only bumps
+ *   the epoch, so it is O(1) and stale pages read as the image until they
+ *   are next mutated (their buffers are reused, not freed)
+ * Reads cost one page-table load and an epoch compare over a plain
+ * std::vector.
+ */
+template <typename T>
+class CowArray {
+public:
+    using Image = std::vector<T>;
+
+    static constexpr unsigned PAGE_BITS = [] {
+        unsigned bits = 0;
+        while ((size_t(2) << bits) * sizeof(T) <= 4096) bits++;
+        return bits;
+    }();
+    static constexpr size_t PAGE_ELEMS = size_t(1) << PAGE_BITS;
+
+    static std::shared_ptr<const Image> make_image(Image contents) {
+        return std::make_shared<const Image>(std::move(contents));
+    }
+
+    // Image of 'size' value-initialised elements, built once per size
+    static std::shared_ptr<const Image> default_image(size_t size) {
+        static std::map<size_t, std::shared_ptr<const Image>> images;
+        std::shared_ptr<const Image>& image = images[size];
+        if (!image) image = make_image(Image(size));
+        return image;
+    }
+
+    explicit CowArray(std::shared_ptr<const Image> image)
+        : image_(std::move(image))
+        , pages_((image_->size() + PAGE_ELEMS - 1) >> PAGE_BITS)
+    {
+    }
+
+    explicit CowArray(size_t size) : CowArray(default_image(size)) {}
+
+    CowArray(CowArray&&) noexcept = default;
+    CowArray& operator=(CowArray&&) noexcept = default;
+
+    [[nodiscard]] size_t size() const noexcept { return image_->size(); }
+
+    [[nodiscard]] const T& operator[](size_t index) const noexcept {
+        const size_t page = index >> PAGE_BITS;
+        const T* base = pages_[page].epoch == epoch_ ? pages_[page].data.get()
+                                                     : image_->data() + (page << PAGE_BITS);
+        return base[index & (PAGE_ELEMS - 1)];
+    }
+
+    // Writable element; copies its page out of the image on first use in
+    // the current epoch
+    T& mutate(size_t index) {
+        const size_t page = index >> PAGE_BITS;
+        Page& entry = pages_[page];
+        if (entry.epoch != epoch_) {
+            const size_t count = page_elems(page);
+            if (!entry.data) entry.data.reset(new T[count]);
+            const T* source = image_->data() + (page << PAGE_BITS);
+            std::copy(source, source + count, entry.data.get());
+            entry.epoch = epoch_;
+        }
+        return entry.data[index & (PAGE_ELEMS - 1)];
+    }
+
+    // Back to the image contents
+    void reset() noexcept {
+        if (++epoch_ == 0) {
+            // Wrapped: no page may keep a stamp that matches again
+            for (Page& entry : pages_) entry.epoch = 0;
+            epoch_ = 1;
+        }
+    }
+
+    // True once the element's page has been copied out of the image in the
+    // current epoch
+    [[nodiscard]] bool is_private(size_t index) const noexcept {
+        return pages_[index >> PAGE_BITS].epoch == epoch_;
+    }
+
+    // Checkpoint of the private pages (plain element types only); restore
+    // over the same image
+    void save_state(CheckpointWriter& out) const {
+        static_assert(std::is_trivially_copyable<T>::value, "elements are written raw");
+        out.put<uint32_t>(static_cast<uint32_t>(size()));
+        out.put<uint32_t>(static_cast<uint32_t>(get_private_pages()));
+        for (size_t p = 0; p < pages_.size(); p++) {
+            if (pages_[p].epoch != epoch_) continue;
+            out.put<uint32_t>(static_cast<uint32_t>(p));
+            out.put_bytes(pages_[p].data.get(), page_elems(p) * sizeof(T));
+        }
+    }
+
+    bool restore_state(CheckpointReader& in) {
+        static_assert(std::is_trivially_copyable<T>::value, "elements are read raw");
+        if (in.get<uint32_t>() != size()) in.fail();
+        const uint32_t count = in.get<uint32_t>();
+        reset();
+        for (uint32_t n = 0; n < count && in.ok(); n++) {
+            const uint32_t page = in.get<uint32_t>();
+            if (page >= pages_.size()) {
+                in.fail();
+                break;
+            }
+            in.get_bytes(&mutate(static_cast<size_t>(page) << PAGE_BITS), page_elems(page) * sizeof(T));
+        }
+        return in.ok();
+    }
+
+    [[nodiscard]] size_t get_private_pages() const noexcept {
+        size_t count = 0;
+        for (const Page& entry : pages_) count += entry.epoch == epoch_ ? 1 : 0;
+        return count;
+    }
+
+private:
+    struct Page {
+        std::unique_ptr<T[]> data;  // Private copy, kept across resets
+        uint32_t epoch = 0;         // Epoch data was copied in; 0: never
+    };
+
+    std::shared_ptr<const Image> image_;
+    std::vector<Page> pages_;
+    uint32_t epoch_ = 1;
+
+    [[nodiscard]] size_t page_elems(size_t page) const noexcept {
+        return std::min(PAGE_ELEMS, size() - (page << PAGE_BITS));
+    }
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_COW_ARRAY_H
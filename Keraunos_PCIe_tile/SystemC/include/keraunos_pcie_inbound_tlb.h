@@ -1,13 +1,11 @@
 #ifndef KERAUNOS_PCIE_INBOUND_TLB_H
 #define KERAUNOS_PCIE_INBOUND_TLB_H
 
-// REFACTORED: C++ classes with function callbacks and SCML2 memory
+// REFACTORED: C++ classes with function callbacks and sparse register storage
 
 #include "keraunos_pcie_tlb_common.h"
-#include <scml2.h>
-#include <scml2/memory.h>
-#include <systemc>
-#include <tlm>
+#include "keraunos_pcie_trace.h"
+#include "keraunos_pcie_sparse_regs.h"
 #include <functional>
 #include <vector>
 
@@ -19,21 +17,26 @@ public:
     TLBSysIn0();
     ~TLBSysIn0() = default;
     
-    using TransportCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&)>;
+    using TransportCallback = std::function<void(Transaction&, SimTime&)>;
     
-    void process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_config_access(Transaction& trans, SimTime& delay);
+    void process_inbound_traffic(Transaction& trans, SimTime& delay);
     void set_translated_output(TransportCallback cb) { translated_output_ = cb; }
     void set_system_ready(bool val) { system_ready_ = val; }
     bool lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t& axuser);
     void configure_entry(uint8_t index, const TlbEntry& entry);
     TlbEntry get_entry(uint8_t index) const;
+    void set_tracer(Tracer* tracer) { tracer_ = tracer ? tracer : &Tracer::disabled(); }
+    void reset();
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
-    std::vector<TlbEntry> entries_;
+    TlbTable entries_;
+    Tracer* tracer_;
     bool system_ready_;
     TransportCallback translated_output_;
-    scml2::memory<uint8_t> tlb_memory_;  // SCML2 memory for config
+    SparseRegisterStore tlb_memory_;
     uint8_t calculate_index(uint64_t addr) const;
 };
 
@@ -42,20 +45,25 @@ public:
     explicit TLBAppIn0(uint8_t instance_id = 0);
     ~TLBAppIn0() = default;
     
-    using TransportCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&)>;
+    using TransportCallback = std::function<void(Transaction&, SimTime&)>;
     
-    void process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_config_access(Transaction& trans, SimTime& delay);
+    void process_inbound_traffic(Transaction& trans, SimTime& delay);
     void set_translated_output(TransportCallback cb) { translated_output_ = cb; }
     bool lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t& axuser);
     void configure_entry(uint8_t index, const TlbEntry& entry);
     TlbEntry get_entry(uint8_t index) const;
+    void set_tracer(Tracer* tracer) { tracer_ = tracer ? tracer : &Tracer::disabled(); }
+    void reset();
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
     const uint8_t instance_id_;
-    std::vector<TlbEntry> entries_;
+    TlbTable entries_;
+    Tracer* tracer_;
     TransportCallback translated_output_;
-    scml2::memory<uint8_t> tlb_memory_;  // SCML2 memory
+    SparseRegisterStore tlb_memory_;
     uint8_t calculate_index(uint64_t addr) const;
 };
 
@@ -64,19 +72,24 @@ public:
     TLBAppIn1();
     ~TLBAppIn1() = default;
     
-    using TransportCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&)>;
+    using TransportCallback = std::function<void(Transaction&, SimTime&)>;
     
-    void process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_config_access(Transaction& trans, SimTime& delay);
+    void process_inbound_traffic(Transaction& trans, SimTime& delay);
     void set_translated_output(TransportCallback cb) { translated_output_ = cb; }
     bool lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t& axuser);
     void configure_entry(uint8_t index, const TlbEntry& entry);
     TlbEntry get_entry(uint8_t index) const;
+    void set_tracer(Tracer* tracer) { tracer_ = tracer ? tracer : &Tracer::disabled(); }
+    void reset();
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
-    std::vector<TlbEntry> entries_;
+    TlbTable entries_;
+    Tracer* tracer_;
     TransportCallback translated_output_;
-    scml2::memory<uint8_t> tlb_memory_;  // SCML2 memory
+    SparseRegisterStore tlb_memory_;
     uint8_t calculate_index(uint64_t addr) const;
 };
 
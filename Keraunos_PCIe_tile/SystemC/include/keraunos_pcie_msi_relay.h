@@ -4,10 +4,14 @@
 // REFACTORED: Converted from sc_module to pure C++ class
 // Original backed up in SystemC/backup_original/
 
-#include <systemc>
-#include <tlm>
-#include <sc_dt.h>
+#include "keraunos_pcie_common.h"
+#include "keraunos_pcie_bitmap.h"
+#include "keraunos_pcie_checkpoint.h"
+#include "keraunos_pcie_cow_array.h"
 #include <vector>
+#include <queue>
+#include <deque>
+#include <utility>
 #include <functional>
 #include <cstdint>
 
@@ -17,64 +21,208 @@ namespace pcie {
 /**
  * MSI Relay Unit (Refactored to C++ Class)
  * No sc_module, no TLM sockets - function-based communication only
+ *
+ * Multi-function: one MSI-X table + PBA per PF, up to 2048 vectors each.
+ * CSR offset bits [17:14] select the PF window; within a window:
+ *   0x0000 MSI receiver, 0x0004 outstanding, 0x0008 table page select,
+ *   0x000C coalesced-request count (write clears),
+ *   0x0010 egress control: [15:0] FIFO depth, [31:16] outstanding limit
+ *          (relay-wide, visible in every PF window),
+ *   0x1000 PBA (one dword per 32 vectors),
+ *   0x1800-0x1FFF moderation aperture (one dword per vector),
+ *   0x2000-0x3FFF table aperture.
+ * The 8KB table aperture shows 512 entries; the page select register picks
+ * which 512-entry page of a larger table (and of the moderation array) it maps.
+ *
+ * Moderation (per vector): [23:0] minimum interval between MSIs in ticks,
+ * [31:24] coalescing count. After an MSI the vector is held off for the
+ * interval; requests arriving meanwhile fold into the next MSI, which is
+ * sent when the interval expires or, if the count is non-zero, as soon as
+ * that many requests have accumulated. The count only ends a holdoff early:
+ * interval 0 disables moderation whatever the count, and every PBA set
+ * sends an MSI (so a vector is never held without a release time).
+ *
+ * Egress: generated MSI writes enter a FIFO and stay in it until their
+ * downstream write completes (annotated delay). At most 'outstanding limit'
+ * are in flight; the rest wait. While the FIFO is full the MSI receiver
+ * pushes back on vectors not already pending (write rejected with
+ * Response::GenericError, PBA untouched) and further deliverable vectors
+ * stay pending in the PBA. A queued MSI commits its coalescing and holdoff
+ * once its write is accepted; a rejected write leaves the requests pending.
+ * MSI_OUTSTANDING reports FIFO occupancy (queued + in flight).
+ *
+ * Tables are structure-of-arrays; PBA, mask, address-valid and deliverable
+ * state are hierarchical bitmaps, so the next deliverable vector is found
+ * without scanning the table.
  */
 class MsiRelayUnit {
 public:
-    explicit MsiRelayUnit(uint8_t num_vectors = 16);
+    explicit MsiRelayUnit(uint16_t vectors_per_pf = 16, uint8_t num_pfs = 1);
     ~MsiRelayUnit() = default;
     
     // Function interfaces (replace sockets)
-    void process_csr_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_msi_input(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_csr_access(Transaction& trans, SimTime& delay);
+    void process_msi_input(Transaction& trans, SimTime& delay);
     
-    using TransportCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&)>;
+    using TransportCallback = std::function<void(Transaction&, SimTime&)>;
     void set_msi_output_callback(TransportCallback callback);
     
-    // Control signal interfaces
+    // Fired when a vector newly becomes deliverable (PBA set, unmask, address
+    // programmed, enable/function-mask change) or a pending vector's table
+    // entry is rewritten. The owner schedules process_pending_msis() from it
+    // instead of polling.
+    using NotifyCallback = std::function<void()>;
+    void set_deliverable_callback(NotifyCallback callback) { deliverable_callback_ = callback; }
+    
+    // Control signal interfaces (single-argument forms apply to every PF)
     void set_msix_enable(bool enable);
     void set_msix_mask(bool mask);
+    void set_msix_enable(uint8_t pf, bool enable);
+    void set_msix_mask(uint8_t pf, bool mask);
     void set_interrupt_pending(uint16_t setip_bits);
     
     // Register access
-    void write_msi_receiver(uint32_t data);
+    // Ok when the request is taken. AddressError for a PF or vector index
+    // outside the relay. GenericError (not taken, retry) while the egress
+    // FIFO is full, unless the vector is already pending (the request folds
+    // into its PBA bit)
+    Response write_msi_receiver(uint32_t data, uint8_t pf = 0);
     uint32_t read_msi_outstanding() const;
-    uint32_t read_msix_pba() const;
-    void write_msix_table(uint8_t index, uint64_t address, uint32_t data, bool mask);
-    void read_msix_table(uint8_t index, uint64_t& address, uint32_t& data, bool& mask) const;
+    uint32_t read_msix_pba(uint8_t pf = 0, uint16_t dword = 0) const;
+    void write_msix_table(uint16_t index, uint64_t address, uint32_t data, bool mask, uint8_t pf = 0);
+    void read_msix_table(uint16_t index, uint64_t& address, uint32_t& data, bool& mask, uint8_t pf = 0) const;
+    
+    // Interrupt moderation (min_interval 0 = off, coalesce_count ignored)
+    void set_moderation(uint16_t index, uint32_t min_interval, uint8_t coalesce_count, uint8_t pf = 0);
+    [[nodiscard]] uint32_t read_moderation(uint16_t index, uint8_t pf = 0) const;
+    [[nodiscard]] uint64_t get_coalesced_count(uint8_t pf) const noexcept;
+    [[nodiscard]] uint64_t get_coalesced_count() const noexcept;
+    
+    // Egress FIFO
+    void set_egress_limits(uint16_t depth, uint16_t max_outstanding);
+    [[nodiscard]] uint16_t get_egress_depth() const noexcept { return egress_depth_; }
+    [[nodiscard]] uint16_t get_max_outstanding() const noexcept { return max_outstanding_; }
+    [[nodiscard]] size_t get_egress_occupancy() const noexcept { return egress_.size() + in_flight_.size(); }
+    [[nodiscard]] size_t get_in_flight() const noexcept { return in_flight_.size(); }
+    [[nodiscard]] uint64_t get_backpressure_count() const noexcept { return backpressure_count_; }
     
     // Processing (replaces SC_THREAD)
-    void process_pending_msis();
+    // Retires completed MSI writes, releases expired holdoffs, then moves
+    // deliverable vectors (PF by PF, lowest index first) through the egress
+    // FIFO. now_tick is the moderation / completion time base.
+    void process_pending_msis(uint64_t now_tick = 0);
+    // Earliest tick at which a holdoff expires or an in-flight MSI write
+    // completes (NO_WAKEUP if none); the owner schedules
+    // process_pending_msis() for then
+    static constexpr uint64_t NO_WAKEUP = ~0ULL;
+    [[nodiscard]] uint64_t get_next_wakeup_tick() const;
+    [[nodiscard]] bool has_deliverable() const noexcept { return deliverable_pfs_ != 0; }
+    // process_pending_msis() activations since reset (not checkpointed)
+    [[nodiscard]] uint64_t get_delivery_pass_count() const noexcept { return delivery_pass_count_; }
+    [[nodiscard]] bool is_pending(uint8_t pf, uint16_t index) const;
+    
+    [[nodiscard]] uint8_t get_num_pfs() const noexcept { return num_pfs_; }
+    [[nodiscard]] uint16_t get_vectors_per_pf() const noexcept { return vectors_per_pf_; }
+    
+    // Power-on state: tables, PBA, moderation, enables and the egress FIFO
+    // back to reset values. The tables reset by epoch (O(1)), the bitmaps by
+    // word; egress limits are kept (platform configuration).
+    void reset();
+    
+    // Checkpoint: tables, PBA/moderation state, pending holdoffs and the
+    // egress FIFO. Restore into a unit built with the same geometry; the
+    // owner reschedules process_pending_msis() from has_deliverable() and
+    // get_next_wakeup_tick() afterwards.
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
-    const uint8_t num_vectors_;
+    const uint16_t vectors_per_pf_;
+    const uint8_t num_pfs_;
+    
+    // Per-PF MSI-X state, table stored as structure-of-arrays. The arrays
+    // start out as views of one shared all-zero image and copy a page on
+    // first write, so untouched vectors cost nothing per tile.
+    struct FunctionState {
+        CowArray<uint64_t> address;
+        CowArray<uint32_t> data;
+        HierarchicalBitmap pba;
+        HierarchicalBitmap masked;       // Vector Control mask bit
+        HierarchicalBitmap valid_addr;   // address != 0
+        // Moderation state, also structure-of-arrays
+        CowArray<uint32_t> min_interval;
+        CowArray<uint8_t> coalesce_count;
+        CowArray<uint16_t> request_count;      // Requests folded into the pending MSI
+        CowArray<uint64_t> holdoff_until;
+        HierarchicalBitmap held;          // Inside min_interval since the last MSI
+        HierarchicalBitmap count_ready;   // request_count reached coalesce_count
+        HierarchicalBitmap queued;        // MSI in the egress FIFO, not yet issued
+        // deliverable = pba & ~masked & valid_addr & ~queued & (~held | count_ready),
+        // gated by enable/function mask
+        HierarchicalBitmap deliverable;
+        bool msix_enable;
+        bool msix_mask;
+        uint16_t table_page;
+        uint64_t coalesced;
+        explicit FunctionState(uint16_t vectors);
+    };
     
-    struct MsixTableEntry {
+    std::vector<FunctionState> functions_;
+    // Pending holdoff releases: (release tick, pf << 16 | vector), min first.
+    // Superseded entries are skipped when popped.
+    using Release = std::pair<uint64_t, uint32_t>;
+    std::priority_queue<Release, std::vector<Release>, std::greater<Release>> releases_;
+    uint64_t now_tick_;
+    
+    // Egress FIFO: MSI writes waiting to issue, plus completion ticks of
+    // writes in flight (both count towards egress_depth_)
+    struct EgressEntry {
         uint64_t address;
         uint32_t data;
-        bool mask;
-        MsixTableEntry() : address(0), data(0), mask(true) {}
+        uint8_t pf;
+        uint16_t index;
+        uint16_t requests;   // Receiver writes this MSI carries
     };
-    
-    std::vector<MsixTableEntry> msix_table_;
-    uint16_t msix_pba_;
-    uint32_t msi_outstanding_;
-    bool msix_enable_;
-    bool msix_mask_;
+    std::deque<EgressEntry> egress_;
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> in_flight_;
+    uint16_t egress_depth_;
+    uint16_t max_outstanding_;
+    uint64_t backpressure_count_;
+    uint64_t delivery_pass_count_;
+    bool delivering_;   // Inside process_pending_msis: no deliverable callbacks
+    uint32_t deliverable_pfs_;      // Bit per PF with a non-empty deliverable bitmap
     uint16_t setip_;
     TransportCallback msi_output_callback_;
+    NotifyCallback deliverable_callback_;
     
-    void set_pba_bit(uint8_t index);
-    void clear_pba_bit(uint8_t index);
-    bool is_msi_allowed(uint8_t index) const;
-    void send_msi(uint8_t index);
-    void process_csr_read(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_csr_write(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void update_vector_state(uint8_t pf, uint16_t index);
+    void update_deliverable_bit(uint8_t pf, uint16_t index);
+    void update_deliverable_function(uint8_t pf);
+    void set_pba_bit(uint8_t pf, uint16_t index);
+    void clear_pba_bit(uint8_t pf, uint16_t index);
+    void release_holdoffs(uint64_t now_tick);
+    void start_holdoff(uint8_t pf, uint16_t index, uint16_t requests);
+    bool is_msi_allowed(uint8_t pf, uint16_t index) const;
+    void enqueue_msi(uint8_t pf, uint16_t index);
+    void issue_egress();
+    void send_msi(const EgressEntry& entry);
+    // Offsets within the PF window already decoded by process_csr_access()
+    void process_csr_read(Transaction& trans, uint8_t pf, uint32_t local);
+    void process_csr_write(Transaction& trans, uint8_t pf, uint32_t local);
     
     static const uint32_t MSI_RECEIVER_OFFSET = 0x0000;
     static const uint32_t MSI_OUTSTANDING_OFFSET = 0x0004;
+    static const uint32_t MSIX_TABLE_PAGE_OFFSET = 0x0008;
+    static const uint32_t MSI_COALESCED_OFFSET = 0x000C;
+    static const uint32_t MSI_EGRESS_CTRL_OFFSET = 0x0010;
     static const uint32_t MSIX_PBA_OFFSET = 0x1000;
+    static const uint32_t MSIX_MODERATION_BASE_OFFSET = 0x1800;
+    static const uint32_t MSIX_MODERATION_ENTRY_SIZE = 4;
+    static const uint32_t MSIX_MODERATION_INTERVAL_MASK = 0x00FFFFFF;
+    static const uint32_t MSIX_MODERATION_COUNT_SHIFT = 24;
     static const uint32_t MSIX_TABLE_BASE_OFFSET = 0x2000;
     static const uint32_t MSIX_TABLE_ENTRY_SIZE = 16;
+    static const uint32_t MSIX_TABLE_PAGE_ENTRIES = (MSI_RELAY_PF_WINDOW - MSIX_TABLE_BASE_OFFSET) / MSIX_TABLE_ENTRY_SIZE;
 };
 
 } // namespace pcie
@@ -3,9 +3,8 @@
 
 // REFACTORED: C++ class with function callbacks
 
+#include "keraunos_pcie_checkpoint.h"
 #include "keraunos_pcie_common.h"
-#include <systemc>
-#include <tlm>
 #include <functional>
 #include <map>
 #include <cstdint>
@@ -19,13 +18,13 @@ public:
     ~NocIoSwitch() = default;
     
     // Function interfaces
-    using TransportCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&)>;
+    using TransportCallback = std::function<void(Transaction&, SimTime&)>;
     
     // Inbound from NOC-N or NOC-PCIE switch
-    void route_from_noc(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void route_from_noc(Transaction& trans, SimTime& delay);
     
     // Inbound from TLB (after translation, going to external NOC-N)
-    void route_from_tlb(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void route_from_tlb(Transaction& trans, SimTime& delay);
     
     // Set callbacks for routing destinations
     void set_noc_n_output(TransportCallback cb) { noc_n_output_ = cb; }
@@ -36,6 +35,11 @@ public:
     void set_isolate_req(const bool val) noexcept { isolate_req_ = val; }
     [[nodiscard]] bool get_timeout_read() const noexcept { return timeout_read_; }
     [[nodiscard]] bool get_timeout_write() const noexcept { return timeout_write_; }
+    // Driven by the tile watchdog when a downstream access misses its deadline
+    void set_timeout_read(const bool val) noexcept { timeout_read_ = val; }
+    void set_timeout_write(const bool val) noexcept { timeout_write_ = val; }
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
     bool isolate_req_, timeout_read_, timeout_write_;
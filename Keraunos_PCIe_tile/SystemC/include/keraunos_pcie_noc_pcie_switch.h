@@ -3,9 +3,9 @@
 
 // REFACTORED: C++ class with function callbacks
 
+#include "keraunos_pcie_checkpoint.h"
 #include "keraunos_pcie_common.h"
-#include <systemc>
-#include <tlm>
+#include "keraunos_pcie_trace.h"
 #include <functional>
 #include <map>
 
@@ -17,16 +17,15 @@ public:
     NocPcieSwitch();
     ~NocPcieSwitch() = default;
     
-    using TransportCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&)>;
+    using TransportCallback = std::function<void(Transaction&, SimTime&)>;
     
     // Inbound from PCIe Controller
-    void route_from_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void route_from_pcie(Transaction& trans, SimTime& delay);
     
     // Outbound from TLBs or switches back to PCIe
-    void route_to_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void route_to_pcie(Transaction& trans, SimTime& delay);
     // Overload with AxUSER for BME qualification (Table 33, Section 2.5.8.1)
-    void route_to_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay,
-                       const sc_dt::sc_bv<256>& axuser);
+    void route_to_pcie(Transaction& trans, SimTime& delay, const AxUser& axuser);
     
     // Set callbacks for routing
     void set_tlb_app_inbound0_output(TransportCallback cb) { tlb_app_inbound0_ = cb; }
@@ -52,6 +51,9 @@ public:
     [[nodiscard]] bool get_bus_master_enable() const noexcept { return bus_master_enable_; }
     [[nodiscard]] bool get_controller_is_ep() const noexcept { return controller_is_ep_; }
     [[nodiscard]] uint32_t get_status_reg_value() const noexcept { return system_ready_ ? 1 : 0; }
+    void set_tracer(Tracer* tracer) { tracer_ = tracer ? tracer : &Tracer::disabled(); }
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
     bool isolate_req_, pcie_outbound_enable_, pcie_inbound_enable_, system_ready_;
@@ -62,11 +64,12 @@ private:
     TransportCallback noc_io_, smn_io_, pcie_controller_, msi_relay_, config_reg_;
     std::map<uint64_t, OutstandingRequest> outstanding_requests_;
     uint64_t next_request_id_;
+    Tracer* tracer_;
     
     NocPcieRoute route_address(uint64_t addr, bool is_read) const;
     bool is_status_register_access(uint64_t addr, bool is_read) const;
     // BME exemption check per Table 34: CfgRd/Wr, Msg/MsgD, and DBI are not affected by BME
-    bool is_bme_exempt(const sc_dt::sc_bv<256>& axuser) const;
+    bool is_bme_exempt(const AxUser& axuser) const;
 };
 
 } // namespace pcie
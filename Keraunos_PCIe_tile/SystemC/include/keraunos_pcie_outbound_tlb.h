@@ -1,13 +1,11 @@
 #ifndef KERAUNOS_PCIE_OUTBOUND_TLB_H
 #define KERAUNOS_PCIE_OUTBOUND_TLB_H
 
-// REFACTORED: C++ classes with function callbacks and SCML2 memory
+// REFACTORED: C++ classes with function callbacks and sparse register storage
 
 #include "keraunos_pcie_tlb_common.h"
-#include <scml2.h>
-#include <scml2/memory.h>
-#include <systemc>
-#include <tlm>
+#include "keraunos_pcie_trace.h"
+#include "keraunos_pcie_sparse_regs.h"
 #include <functional>
 #include <vector>
 
@@ -20,19 +18,24 @@ public:
     ~TLBSysOut0() = default;
     
     // 3-arg callback: carries AxUSER (TLB ATTR) for downstream BME qualification
-    using TransportWithAttrCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&, const sc_dt::sc_bv<256>&)>;
+    using TransportWithAttrCallback = std::function<void(Transaction&, SimTime&, const AxUser&)>;
     
-    void process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_outbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_config_access(Transaction& trans, SimTime& delay);
+    void process_outbound_traffic(Transaction& trans, SimTime& delay);
     void set_translated_output(TransportWithAttrCallback cb) { translated_output_ = cb; }
-    bool lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256>& attr);
+    bool lookup(uint64_t pa, uint64_t& translated_addr, AxUser& attr);
     void configure_entry(uint8_t index, const TlbEntry& entry);
     TlbEntry get_entry(uint8_t index) const;
+    void set_tracer(Tracer* tracer) { tracer_ = tracer ? tracer : &Tracer::disabled(); }
+    void reset();
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
-    std::vector<TlbEntry> entries_;
+    TlbTable entries_;
+    Tracer* tracer_;
     TransportWithAttrCallback translated_output_;
-    scml2::memory<uint8_t> tlb_memory_;  // SCML2 memory
+    SparseRegisterStore tlb_memory_;
     uint8_t calculate_index(uint64_t addr) const;
 };
 
@@ -42,19 +45,24 @@ public:
     ~TLBAppOut0() = default;
     
     // 3-arg callback: carries AxUSER (TLB ATTR) for downstream BME qualification
-    using TransportWithAttrCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&, const sc_dt::sc_bv<256>&)>;
+    using TransportWithAttrCallback = std::function<void(Transaction&, SimTime&, const AxUser&)>;
     
-    void process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_outbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_config_access(Transaction& trans, SimTime& delay);
+    void process_outbound_traffic(Transaction& trans, SimTime& delay);
     void set_translated_output(TransportWithAttrCallback cb) { translated_output_ = cb; }
-    bool lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256>& attr);
+    bool lookup(uint64_t pa, uint64_t& translated_addr, AxUser& attr);
     void configure_entry(uint8_t index, const TlbEntry& entry);
     TlbEntry get_entry(uint8_t index) const;
+    void set_tracer(Tracer* tracer) { tracer_ = tracer ? tracer : &Tracer::disabled(); }
+    void reset();
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
-    std::vector<TlbEntry> entries_;
+    TlbTable entries_;
+    Tracer* tracer_;
     TransportWithAttrCallback translated_output_;
-    scml2::memory<uint8_t> tlb_memory_;  // SCML2 memory
+    SparseRegisterStore tlb_memory_;
     uint8_t calculate_index(uint64_t addr) const;
 };
 
@@ -64,19 +72,24 @@ public:
     ~TLBAppOut1() = default;
     
     // 3-arg callback: carries AxUSER (TLB ATTR) for downstream BME qualification
-    using TransportWithAttrCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&, const sc_dt::sc_bv<256>&)>;
+    using TransportWithAttrCallback = std::function<void(Transaction&, SimTime&, const AxUser&)>;
     
-    void process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_outbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_config_access(Transaction& trans, SimTime& delay);
+    void process_outbound_traffic(Transaction& trans, SimTime& delay);
     void set_translated_output(TransportWithAttrCallback cb) { translated_output_ = cb; }
-    bool lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256>& attr);
+    bool lookup(uint64_t pa, uint64_t& translated_addr, AxUser& attr);
     void configure_entry(uint8_t index, const TlbEntry& entry);
     TlbEntry get_entry(uint8_t index) const;
+    void set_tracer(Tracer* tracer) { tracer_ = tracer ? tracer : &Tracer::disabled(); }
+    void reset();
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
-    std::vector<TlbEntry> entries_;
+    TlbTable entries_;
+    Tracer* tracer_;
     TransportWithAttrCallback translated_output_;
-    scml2::memory<uint8_t> tlb_memory_;  // SCML2 memory
+    SparseRegisterStore tlb_memory_;
     uint8_t calculate_index(uint64_t addr) const;
 };
 
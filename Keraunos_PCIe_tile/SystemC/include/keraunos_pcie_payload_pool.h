@@ -0,0 +1,100 @@
+#ifndef KERAUNOS_PCIE_PAYLOAD_POOL_H
+#define KERAUNOS_PCIE_PAYLOAD_POOL_H
+
+// Memory-managed TLM payload pool (header-only, C++14)
+// Shared by tile-internal initiators (MSI relay) and the testbench generators
+
+#include <systemc>
+#include <tlm>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace keraunos {
+namespace pcie {
+
+/**
+ * Payload Pool
+ * - Recycles tlm_generic_payload objects and their data buffers
+ * - Reference counted through the standard tlm_mm_interface:
+ *     trans = pool.acquire(...);   // ref_count == 1
+ *     trans->acquire();            // extra owners (e.g. AT phases) add refs
+ *     trans->release();            // last release hands it back via free()
+ * - Data buffers live inside each pooled payload and keep their capacity,
+ *   so steady-state traffic performs no heap allocation
+ * Payloads remain owned by the pool; destroying the pool frees them all.
+ */
+class PayloadPool : public tlm::tlm_mm_interface {
+public:
+    static const unsigned int DEFAULT_BUFFER_SIZE = 64;  // Covers every register/MSI access
+
+    explicit PayloadPool(size_t initial_payloads = 0) {
+        for (size_t i = 0; i < initial_payloads; i++) {
+            free_list_.push_back(allocate());
+        }
+    }
+    ~PayloadPool() override = default;
+
+    PayloadPool(const PayloadPool&) = delete;
+    PayloadPool& operator=(const PayloadPool&) = delete;
+
+    // Acquire a payload with a data buffer of 'length' bytes (ref_count == 1)
+    tlm::tlm_generic_payload* acquire(tlm::tlm_command cmd, uint64_t addr, unsigned int length) {
+        PooledPayload* trans;
+        if (!free_list_.empty()) {
+            trans = free_list_.back();
+            free_list_.pop_back();
+        } else {
+            trans = allocate();
+        }
+        if (trans->buffer.size() < length) {
+            trans->buffer.resize(length);
+        }
+
+        trans->set_command(cmd);
+        trans->set_address(addr);
+        trans->set_data_ptr(trans->buffer.data());
+        trans->set_data_length(length);
+        trans->set_streaming_width(length);
+        trans->set_byte_enable_ptr(nullptr);
+        trans->set_byte_enable_length(0);
+        trans->set_dmi_allowed(false);
+        trans->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+        trans->acquire();
+        in_use_++;
+        return trans;
+    }
+
+    // tlm_mm_interface: called by tlm_generic_payload::release() at ref_count 0
+    void free(tlm::tlm_generic_payload* trans) override {
+        trans->reset();  // Drops auto extensions
+        free_list_.push_back(static_cast<PooledPayload*>(trans));
+        in_use_--;
+    }
+
+    size_t get_allocated() const noexcept { return storage_.size(); }
+    size_t get_in_use() const noexcept { return in_use_; }
+    size_t get_available() const noexcept { return free_list_.size(); }
+
+private:
+    struct PooledPayload : public tlm::tlm_generic_payload {
+        explicit PooledPayload(tlm::tlm_mm_interface* mm)
+            : tlm::tlm_generic_payload(mm), buffer(DEFAULT_BUFFER_SIZE, 0) {}
+        std::vector<uint8_t> buffer;
+    };
+
+    PooledPayload* allocate() {
+        storage_.emplace_back(new PooledPayload(this));
+        return storage_.back().get();
+    }
+
+    std::vector<std::unique_ptr<PooledPayload>> storage_;
+    std::vector<PooledPayload*> free_list_;
+    size_t in_use_ = 0;
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_PAYLOAD_POOL_H
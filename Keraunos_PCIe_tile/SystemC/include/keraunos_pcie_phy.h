@@ -1,12 +1,10 @@
 #ifndef KERAUNOS_PCIE_PHY_H
 #define KERAUNOS_PCIE_PHY_H
 
-// REFACTORED: C++ class with SCML2 memory
+// REFACTORED: C++ class with sparse register storage
 
-#include <scml2.h>
-#include <scml2/memory.h>
-#include <systemc>
-#include <tlm>
+#include "keraunos_pcie_sparse_regs.h"
+#include "keraunos_pcie_transaction.h"
 #include <cstdint>
 
 namespace keraunos {
@@ -17,16 +15,18 @@ public:
     PciePhy();
     ~PciePhy() = default;
     
-    void process_apb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
-    void process_ahb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void process_apb_access(Transaction& trans, SimTime& delay);
+    void process_ahb_access(Transaction& trans, SimTime& delay);
     void set_reset_n(bool val) { reset_n_ = val; phy_ready_ = val; }
     void set_ref_clock(bool val) { ref_clock_ = val; }
     
     bool get_phy_ready() const { return phy_ready_; }
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
     bool reset_n_, ref_clock_, phy_ready_;
-    scml2::memory<uint8_t> phy_memory_;  // SCML2 memory
+    SparseRegisterStore phy_memory_;
 };
 
 } // namespace pcie
@@ -0,0 +1,154 @@
+#ifndef KERAUNOS_PCIE_PROFILER_H
+#define KERAUNOS_PCIE_PROFILER_H
+
+// Host-cycle profiler for component entry points
+//
+// KERAUNOS_PROFILE(profiler, site) charges the host cycles spent until the
+// end of the enclosing scope to site. Time spent in nested profiled scopes
+// is subtracted, so each site reports exclusive cost. Compiled in only with
+// KERAUNOS_PCIE_PROFILE=1; a disabled profiler costs one branch per site.
+
+#include <array>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef KERAUNOS_PCIE_PROFILE
+#define KERAUNOS_PCIE_PROFILE 0
+#endif
+
+#if KERAUNOS_PCIE_PROFILE
+#define KERAUNOS_PROFILE_CONCAT_(a, b) a##b
+#define KERAUNOS_PROFILE_NAME_(n) KERAUNOS_PROFILE_CONCAT_(keraunos_profile_, n)
+#define KERAUNOS_PROFILE(profiler, site) \
+    ::keraunos::pcie::ProfileScope KERAUNOS_PROFILE_NAME_(__COUNTER__)((profiler), (site))
+#else
+#define KERAUNOS_PROFILE(profiler, site) \
+    do { (void)sizeof(::keraunos::pcie::ProfileScope((profiler), (site))); } while (0)
+#endif
+
+namespace keraunos {
+namespace pcie {
+
+// Profiled entry points
+enum class ProfileSite : uint8_t {
+    NocPcieRouteFromPcie, NocPcieRouteToPcie,
+    NocIoRouteFromNoc, NocIoRouteFromTlb, SmnIoRouteFromSmn,
+    TlbSysIn0Inbound, TlbAppIn0Inbound, TlbAppIn1Inbound,
+    TlbSysOut0Outbound, TlbAppOut0Outbound, TlbAppOut1Outbound,
+    TlbConfigAccess,
+    MsiRelayInput, MsiRelayCsrAccess, MsiRelayPending, MsiRelayControl,
+    SiiUpdate, SiiApbAccess, ConfigRegApbAccess,
+    SignalUpdateProcess,
+    Downstream,             // Initiator-socket targets outside the tile
+    Count
+};
+
+const char* profile_site_name(ProfileSite site);
+
+/**
+ * Profiler
+ * Keeps a stack of open scopes. On exit a scope's elapsed cycles are
+ * charged inclusively to its site, exclusively after removing the cycles
+ * of its nested scopes, and added to the parent's child total.
+ * Cycles come from the TSC on x86 hosts, steady_clock ticks elsewhere.
+ */
+class Profiler {
+public:
+    struct SiteStats {
+        uint64_t calls = 0;
+        uint64_t inclusive_cycles = 0;
+        uint64_t exclusive_cycles = 0;
+    };
+
+    Profiler() { stack_.reserve(32); }
+
+    void set_enabled(bool enable) noexcept { enabled_ = enable; }
+    [[nodiscard]] bool is_enabled() const noexcept { return enabled_; }
+
+    // Returns a token for exit(); scopes normally close LIFO, but a SystemC
+    // thread that wait()s inside a scope can be overtaken by another process
+    uint64_t enter(ProfileSite site) {
+        stack_.push_back({site, next_token_, read_cycles(), 0});
+        return next_token_++;
+    }
+    void exit(uint64_t token) noexcept {
+        uint64_t now = read_cycles();
+        size_t pos = stack_.size();
+        while (pos > 0 && stack_[pos - 1].token != token) pos--;
+        if (pos == 0) return;  // Dropped by reset()
+        Frame frame = stack_[pos - 1];
+        stack_.erase(stack_.begin() + static_cast<std::ptrdiff_t>(pos - 1));
+        uint64_t elapsed = now - frame.start;
+        SiteStats& stats = stats_[static_cast<size_t>(frame.site)];
+        stats.calls++;
+        stats.inclusive_cycles += elapsed;
+        stats.exclusive_cycles += (elapsed > frame.child_cycles) ? elapsed - frame.child_cycles : 0;
+        if (pos > 1) {
+            stack_[pos - 2].child_cycles += elapsed;
+        }
+    }
+
+    [[nodiscard]] const SiteStats& get_stats(ProfileSite site) const noexcept {
+        return stats_[static_cast<size_t>(site)];
+    }
+    [[nodiscard]] uint64_t get_total_exclusive_cycles() const noexcept;
+    void reset() noexcept;
+
+    // Ranked by exclusive cycles; sites never entered are omitted
+    void report(std::FILE* out, const char* title) const;
+
+    static uint64_t read_cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+private:
+    struct Frame {
+        ProfileSite site;
+        uint64_t token;
+        uint64_t start;
+        uint64_t child_cycles;
+    };
+
+    bool enabled_ = false;
+    uint64_t next_token_ = 0;
+    std::vector<Frame> stack_;
+    std::array<SiteStats, static_cast<size_t>(ProfileSite::Count)> stats_{};
+};
+
+/**
+ * Profile Scope (RAII)
+ * Samples enablement once on entry so a scope always closes what it opened.
+ */
+class ProfileScope {
+public:
+    ProfileScope(Profiler& profiler, ProfileSite site)
+        : profiler_(profiler.is_enabled() ? &profiler : nullptr)
+    {
+        if (profiler_) token_ = profiler_->enter(site);
+    }
+    ~ProfileScope() {
+        if (profiler_) profiler_->exit(token_);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* profiler_;
+    uint64_t token_ = 0;
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_PROFILER_H
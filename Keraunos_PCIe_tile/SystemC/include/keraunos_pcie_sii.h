@@ -1,15 +1,12 @@
 #ifndef KERAUNOS_PCIE_SII_H
 #define KERAUNOS_PCIE_SII_H
 
-// REFACTORED: C++ class with SCML2 memory and CII tracking logic.
+// REFACTORED: C++ class with sparse register storage and CII tracking logic.
 // CII tracking detects PCIe config space updates from the host, maintains
 // a cfg_modified bitmask, and generates a config_update interrupt.
 
-#include <scml2.h>
-#include <scml2/memory.h>
-#include <systemc>
-#include <tlm>
-#include <sc_dt.h>
+#include "keraunos_pcie_sparse_regs.h"
+#include "keraunos_pcie_transaction.h"
 #include <cstdint>
 #include <functional>
 
@@ -21,20 +18,31 @@ public:
     SiiBlock();
     ~SiiBlock() = default;
 
-    // TLM access from SMN-IO switch (APB register interface)
-    void process_apb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    // Access from SMN-IO switch (APB register interface)
+    void process_apb_access(Transaction& trans, SimTime& delay);
 
     // --- Input setters (called by tile SC_METHOD on signal change) ---
     void set_cii_hv(bool val) { cii_hv_ = val; }
-    void set_cii_hdr_type(sc_dt::sc_bv<5> val) { cii_hdr_type_ = val; }
-    void set_cii_hdr_addr(sc_dt::sc_bv<12> val) { cii_hdr_addr_ = val; }
+    void set_cii_hdr_type(uint8_t val) { cii_hdr_type_ = val & 0x1F; }      // [4:0]
+    void set_cii_hdr_addr(uint16_t val) { cii_hdr_addr_ = val & 0xFFF; }    // [11:0]
     void set_reset_n(bool val) { reset_n_ = val; }
 
+    // Direct register programming (boot configuration): same effect as APB
+    // writes to CORE_CONTROL / BUS_DEV_NUM, device type callback included
+    void set_device_type(bool is_rp);
+    void set_bus_dev_num(uint8_t bus, uint8_t dev);
+
     // Process all inputs and update outputs.
     // Must be called by the tile after all setters, before reading getters.
     // Implements:  CII tracking -> cfg_modified update -> interrupt generation
-    //              -> SCML memory sync (CDC equivalent)
+    //              -> register store sync (CDC equivalent)
     void update();
+    // Fields back to reset values; update() applies it once on entering
+    // reset. The APB register store keeps its contents, as it always has
+    // across the controller reset pin
+    void reset();
+    // reset() plus the register store (an epoch bump), for power-on
+    void power_on_reset();
 
     // --- Output getters (called by tile to drive output ports) ---
     bool get_config_int() const { return config_int_; }
@@ -49,12 +57,16 @@ public:
     using DeviceTypeCallback = std::function<void(bool is_rp)>;
     void set_device_type_callback(DeviceTypeCallback cb) { device_type_cb_ = cb; }
 
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
+
 private:
     // --- CII input state ---
     bool cii_hv_;
     bool reset_n_;
-    sc_dt::sc_bv<5> cii_hdr_type_;
-    sc_dt::sc_bv<12> cii_hdr_addr_;
+    bool in_reset_;                     // Reset state already applied
+    uint8_t cii_hdr_type_;              // [4:0]
+    uint16_t cii_hdr_addr_;             // [11:0]
 
     // --- Output state ---
     bool config_int_;                   // config_update interrupt (to SMC PLIC)
@@ -67,8 +79,8 @@ private:
     uint32_t cfg_modified_;             // Accumulated config-modified bitmask
     uint32_t cii_clear_;               // Pending RW1C clear bits from APB write
 
-    // --- SCML2 memory for APB register space (64KB) ---
-    scml2::memory<uint8_t> sii_memory_;
+    // --- Sparse store for APB register space (64KB) ---
+    SparseRegisterStore sii_memory_;
 
     // Register offsets within SII APB space
     static const uint32_t CORE_CONTROL_OFFSET = 0x0000;
@@ -3,9 +3,8 @@
 
 // REFACTORED: C++ class with function callbacks
 
+#include "keraunos_pcie_checkpoint.h"
 #include "keraunos_pcie_common.h"
-#include <systemc>
-#include <tlm>
 #include <functional>
 #include <map>
 
@@ -17,10 +16,10 @@ public:
     SmnIoSwitch();
     ~SmnIoSwitch() = default;
     
-    using TransportCallback = std::function<void(tlm::tlm_generic_payload&, sc_core::sc_time&)>;
+    using TransportCallback = std::function<void(Transaction&, SimTime&)>;
     
     // Inbound from SMN-N or NOC-PCIE switch
-    void route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void route_from_smn(Transaction& trans, SimTime& delay);
     
     // Set callbacks for routing
     void set_smn_n_output(TransportCallback cb) { smn_n_output_ = cb; }
@@ -39,13 +38,16 @@ public:
     void set_tlb_app_out1_cfg_output(TransportCallback cb) { tlb_app_out1_cfg_ = cb; }
     
     // Route from NOC-IO switch
-    void route_from_noc_io(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    void route_from_noc_io(Transaction& trans, SimTime& delay);
     void set_msi_relay_data_output(TransportCallback cb) { msi_relay_data_ = cb; }
     
     void set_isolate_req(const bool val) noexcept { isolate_req_ = val; }
     void set_isolation(bool isolate);
     [[nodiscard]] bool get_timeout() const noexcept { return timeout_; }
+    void set_timeout(const bool val) noexcept { timeout_ = val; }  // Driven by tile watchdog
     bool get_timeout_status() const;
+    void save_state(CheckpointWriter& out) const;
+    bool restore_state(CheckpointReader& in);
     
 private:
     bool isolate_req_, timeout_;
@@ -0,0 +1,124 @@
+#ifndef KERAUNOS_PCIE_SPAN_TRACE_H
+#define KERAUNOS_PCIE_SPAN_TRACE_H
+
+// Per-hop transaction spans in Chrome trace-event JSON (loads in Perfetto)
+//
+// KERAUNOS_SPAN(tracer, hop, trans, delay) opens a span that closes at the
+// end of the enclosing scope. Compiled in only with KERAUNOS_PCIE_TRACE=1;
+// a disabled tracer costs one branch per hop.
+
+#include "keraunos_pcie_common.h"
+#include "keraunos_pcie_trace.h"
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#if KERAUNOS_PCIE_TRACE
+#define KERAUNOS_SPAN_CONCAT_(a, b) a##b
+#define KERAUNOS_SPAN_NAME_(n) KERAUNOS_SPAN_CONCAT_(keraunos_span_, n)
+#define KERAUNOS_SPAN(tracer, hop, trans, delay) \
+    ::keraunos::pcie::SpanScope KERAUNOS_SPAN_NAME_(__COUNTER__)((tracer), (hop), (trans), (delay))
+#else
+#define KERAUNOS_SPAN(tracer, hop, trans, delay) \
+    do { (void)sizeof(::keraunos::pcie::SpanScope((tracer), (hop), (trans), (delay))); } while (0)
+#endif
+
+namespace keraunos {
+namespace pcie {
+
+// Hops a transaction can pass through inside the tile
+enum class SpanHop : uint8_t {
+    PcieControllerTarget, NocTarget, SmnTarget,
+    NocPcieSwitch, NocIoSwitch, SmnIoSwitch, RouteToPcie,
+    TlbSysIn0, TlbAppIn0, TlbAppIn1, TlbSysOut0, TlbAppOut0, TlbAppOut1,
+    MsiRelay, ConfigReg,
+    NocInitiator, SmnInitiator, PcieControllerInitiator,
+    Count
+};
+
+const char* span_hop_name(SpanHop hop);
+
+class SpanScope;
+
+/**
+ * Span Tracer
+ * Streams one complete ("X") event per hop on two tracks:
+ *   pid 1 - simulated time: set_clock() time + annotated delay at entry/exit
+ *   pid 2 - host wall time: steady_clock at entry/exit
+ * Events sit on the thread row of the transaction's root hop, so a
+ * transaction's hops nest under it; args.id is the correlation ID from
+ * Transaction::span_id.
+ */
+class SpanTracer {
+public:
+    SpanTracer() = default;
+    ~SpanTracer();
+
+    SpanTracer(const SpanTracer&) = delete;
+    SpanTracer& operator=(const SpanTracer&) = delete;
+
+    bool start(const std::string& path, const std::string& process_name);
+    void stop();
+    [[nodiscard]] bool is_enabled() const noexcept { return file_ != nullptr; }
+    [[nodiscard]] uint64_t get_span_count() const noexcept { return spans_; }
+    void set_clock(SimClock clock) noexcept { clock_ = clock ? clock : &no_clock; }
+
+private:
+    friend class SpanScope;
+
+    std::FILE* file_ = nullptr;
+    SimClock clock_ = &no_clock;
+    uint64_t next_id_ = 1;
+    uint64_t spans_ = 0;
+    std::chrono::steady_clock::time_point wall_origin_;
+
+    void begin(SpanScope& span);
+    void end(SpanScope& span);
+    void write_event(int pid, const SpanScope& span, double ts_us, double dur_us);
+    static SimTime no_clock() { return 0; }
+};
+
+/**
+ * Span Scope (RAII)
+ * The first traced hop of a transaction assigns its span ID and clears it
+ * again on exit, leaving the transaction as it arrived.
+ */
+class SpanScope {
+public:
+    SpanScope(SpanTracer& tracer, SpanHop hop, Transaction& trans, const SimTime& delay)
+        : tracer_(tracer.is_enabled() ? &tracer : nullptr)
+    {
+        if (tracer_) {
+            hop_ = hop;
+            trans_ = &trans;
+            delay_ = &delay;
+            tracer_->begin(*this);
+        }
+    }
+    ~SpanScope() {
+        if (tracer_) tracer_->end(*this);
+    }
+
+    SpanScope(const SpanScope&) = delete;
+    SpanScope& operator=(const SpanScope&) = delete;
+
+private:
+    friend class SpanTracer;
+
+    SpanTracer* tracer_;
+    SpanHop hop_ = SpanHop::Count;
+    Transaction* trans_ = nullptr;
+    const SimTime* delay_ = nullptr;
+    bool owned_ = false;   // Root span: assigned the ID
+    uint64_t id_ = 0;
+    uint32_t root_ = 0;
+    uint64_t address_ = 0;
+    uint64_t sim_start_ = 0;
+    std::chrono::steady_clock::time_point wall_start_;
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_SPAN_TRACE_H
@@ -0,0 +1,203 @@
+#ifndef KERAUNOS_PCIE_SPARSE_REGS_H
+#define KERAUNOS_PCIE_SPARSE_REGS_H
+
+// Page-sparse register backing store (header-only, no SystemC dependency)
+
+#include "keraunos_pcie_checkpoint.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace keraunos {
+namespace pcie {
+
+/**
+ * Sparse Register Store
+ * - Byte-addressed space of get_size() bytes split into power-of-two chunks
+ *   (256B by default, rounded down to a power of two, at most MAX_CHUNK_SIZE)
+ * - Every chunk starts out reading one shared, read-only zero page; a
+ *   chunk gets its own storage on the first write to it, so a 64KB APB
+ *   block that firmware touches in two registers costs two 256B chunks
+ *   plus the chunk table
+ * - Reads never allocate
+ * - Optionally built over a shared, immutable base image (the block's reset
+ *   values): untouched chunks read the image, and the first write to a
+ *   chunk copies it privately, so instances share their reset state
+ * - Private chunks are stamped with the epoch they were written in; reset()
+ *   bumps the epoch in O(1) and stale chunks read as the base again until
+ *   their next write, which reuses the buffer
+ * Replaces scml2::memory<uint8_t> for the tile's plain register spaces;
+ * accesses beyond get_size() are the caller's responsibility, as before.
+ */
+class SparseRegisterStore {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 256;
+    static constexpr size_t MAX_CHUNK_SIZE = 4096;
+
+    explicit SparseRegisterStore(size_t size, size_t chunk_size = DEFAULT_CHUNK_SIZE)
+        : size_(size)
+        , chunk_bits_(log2(chunk_size))
+        , chunks_((size + (size_t(1) << chunk_bits_) - 1) >> chunk_bits_)
+    {
+    }
+
+    // Copy-on-write view of 'image', which must not change afterwards
+    explicit SparseRegisterStore(std::shared_ptr<const SparseRegisterStore> image)
+        : size_(image->size_)
+        , chunk_bits_(image->chunk_bits_)
+        , chunks_(image->chunks_.size())
+        , base_(std::move(image))
+    {
+    }
+
+    ~SparseRegisterStore() {
+        for (Chunk& chunk : chunks_) delete[] chunk.data;
+    }
+
+    SparseRegisterStore(const SparseRegisterStore&) = delete;
+    SparseRegisterStore& operator=(const SparseRegisterStore&) = delete;
+
+    [[nodiscard]] size_t get_size() const noexcept { return size_; }
+    [[nodiscard]] size_t get_chunk_size() const noexcept { return size_t(1) << chunk_bits_; }
+    // Chunks holding private contents in the current epoch (not the zero
+    // page or the base image)
+    [[nodiscard]] size_t get_allocated_chunks() const noexcept {
+        size_t count = 0;
+        for (size_t i = 0; i < chunks_.size(); i++) count += is_private(i) ? 1 : 0;
+        return count;
+    }
+
+    [[nodiscard]] uint8_t operator[](size_t offset) const noexcept {
+        return chunk(offset >> chunk_bits_)[offset & chunk_mask()];
+    }
+
+    void set(size_t offset, uint8_t value) {
+        writable(offset >> chunk_bits_)[offset & chunk_mask()] = value;
+    }
+
+    void read(size_t offset, uint8_t* data, size_t length) const noexcept {
+        while (length) {
+            const size_t in_chunk = offset & chunk_mask();
+            const size_t n = std::min(length, get_chunk_size() - in_chunk);
+            std::memcpy(data, chunk(offset >> chunk_bits_) + in_chunk, n);
+            offset += n;
+            data += n;
+            length -= n;
+        }
+    }
+
+    void write(size_t offset, const uint8_t* data, size_t length) {
+        while (length) {
+            const size_t in_chunk = offset & chunk_mask();
+            const size_t n = std::min(length, get_chunk_size() - in_chunk);
+            std::memcpy(writable(offset >> chunk_bits_) + in_chunk, data, n);
+            offset += n;
+            data += n;
+            length -= n;
+        }
+    }
+
+    // Little-endian 32-bit register access
+    [[nodiscard]] uint32_t read32(size_t offset) const noexcept {
+        uint8_t bytes[4];
+        read(offset, bytes, sizeof(bytes));
+        return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 |
+               uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+    }
+
+    void write32(size_t offset, uint32_t value) {
+        const uint8_t bytes[4] = {uint8_t(value), uint8_t(value >> 8),
+                                  uint8_t(value >> 16), uint8_t(value >> 24)};
+        write(offset, bytes, sizeof(bytes));
+    }
+
+    // Back to the base image (all zeroes without one) in O(1)
+    void reset() noexcept {
+        if (++epoch_ == 0) {
+            // Wrapped: no chunk may keep a stamp that matches again
+            for (Chunk& chunk : chunks_) chunk.epoch = 0;
+            epoch_ = 1;
+        }
+    }
+
+    // Checkpoint: the private chunks only; restore_state() rebuilds on top
+    // of the same base image, so the store must be constructed alike
+    void save_state(CheckpointWriter& out) const {
+        out.put<uint32_t>(static_cast<uint32_t>(size_));
+        out.put<uint32_t>(static_cast<uint32_t>(get_allocated_chunks()));
+        for (size_t i = 0; i < chunks_.size(); i++) {
+            if (!is_private(i)) continue;
+            out.put<uint32_t>(static_cast<uint32_t>(i));
+            out.put_bytes(chunks_[i].data, get_chunk_size());
+        }
+    }
+
+    bool restore_state(CheckpointReader& in) {
+        if (in.get<uint32_t>() != size_) in.fail();
+        const uint32_t count = in.get<uint32_t>();
+        reset();
+        for (uint32_t n = 0; n < count && in.ok(); n++) {
+            const uint32_t index = in.get<uint32_t>();
+            if (index >= chunks_.size()) {
+                in.fail();
+                break;
+            }
+            in.get_bytes(writable(index), get_chunk_size());
+        }
+        return in.ok();
+    }
+
+private:
+    struct Chunk {
+        uint8_t* data = nullptr;    // Private storage, kept across resets
+        uint32_t epoch = 0;         // Epoch data was written in; 0: never
+    };
+
+    size_t size_;
+    unsigned chunk_bits_;
+    std::vector<Chunk> chunks_;
+    uint32_t epoch_ = 1;
+    std::shared_ptr<const SparseRegisterStore> base_;
+
+    // Shared by every store; only ever read
+    static const uint8_t* zero_page() noexcept {
+        alignas(64) static const uint8_t zeros[MAX_CHUNK_SIZE] = {};
+        return zeros;
+    }
+
+    static unsigned log2(size_t chunk_size) noexcept {
+        unsigned bits = 0;
+        while ((size_t(2) << bits) <= std::min(chunk_size, MAX_CHUNK_SIZE)) bits++;
+        return bits;
+    }
+
+    [[nodiscard]] size_t chunk_mask() const noexcept { return get_chunk_size() - 1; }
+
+    [[nodiscard]] bool is_private(size_t index) const noexcept {
+        return chunks_[index].epoch == epoch_;
+    }
+
+    // Current contents of a chunk: private, else the base image's, else zeroes
+    [[nodiscard]] const uint8_t* chunk(size_t index) const noexcept {
+        if (is_private(index)) return chunks_[index].data;
+        return base_ ? base_->chunk(index) : zero_page();
+    }
+
+    uint8_t* writable(size_t index) {
+        Chunk& entry = chunks_[index];
+        if (entry.epoch != epoch_) {
+            if (!entry.data) entry.data = new uint8_t[get_chunk_size()];
+            std::memcpy(entry.data, base_ ? base_->chunk(index) : zero_page(), get_chunk_size());
+            entry.epoch = epoch_;
+        }
+        return entry.data;
+    }
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_SPARSE_REGS_H
@@ -17,6 +17,14 @@
 #include "keraunos_pcie_clock_reset.h"
 #include "keraunos_pcie_pll_cgm.h"
 #include "keraunos_pcie_phy.h"
+#include "keraunos_pcie_timeout_watchdog.h"
+#include "keraunos_pcie_checkpoint.h"
+#include "keraunos_pcie_boot_config.h"
+#include "keraunos_pcie_trace.h"
+#include "keraunos_pcie_span_trace.h"
+#include "keraunos_pcie_profiler.h"
+#include "keraunos_pcie_tlm_adapter.h"
+#include "keraunos_pcie_payload_pool.h"
 #include <systemc>
 #include <tlm>
 #include <tlm_utils/simple_target_socket.h>
@@ -24,8 +32,9 @@
 #include <sc_dt.h>
 #include <memory>
 #include <array>
-#include <fstream>
-#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <string>
 
 namespace keraunos {
 namespace pcie {
@@ -87,6 +96,7 @@ public:
     ~KeraunosPcieTile() override;  // override keyword for clarity
     
     void end_of_elaboration() override;  // override keyword
+    void end_of_simulation() override;
     
     // BME control — models PCIe controller's Bus Master Enable output (Table 33)
     // In real HW, BME comes from controller's Command Register bit 2.
@@ -95,18 +105,98 @@ public:
     void set_bus_master_enable(bool val) {
         if (noc_pcie_switch_) {
             noc_pcie_switch_->set_bus_master_enable(val);
-            // #region agent log
-            {
-                std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug_bme.log", std::ios::app);
-                char buf[128];
-                snprintf(buf, sizeof(buf), "set_bus_master_enable(%d) called, get=%d\n",
-                    (int)val, (int)noc_pcie_switch_->get_bus_master_enable());
-                f << buf;
-            }
-            // #endregion
+            KERAUNOS_TRACE(tracer_, TraceEvent::SetBusMasterEnable, 0, val ? 1u : 0u);
         }
     }
     
+    // MSI-X Enable / Function Mask — model the controller's MSI-X capability
+    // Message Control bits 15 and 14. Applied by msi_control_process.
+    void set_msix_enable(bool val) {
+        msix_enable_.write(val);
+        KERAUNOS_TRACE(tracer_, TraceEvent::SignalChange,
+                       static_cast<uint64_t>(TracePin::MsixEnable), val ? 1u : 0u);
+    }
+    void set_msix_function_mask(bool val) {
+        msix_mask_.write(val);
+        KERAUNOS_TRACE(tracer_, TraceEvent::SignalChange,
+                       static_cast<uint64_t>(TracePin::MsixFunctionMask), val ? 1u : 0u);
+    }
+    
+    // MSI egress FIFO depth and in-flight MSI write limit; the relay rejects
+    // MSI receiver writes while the FIFO is full
+    void set_msi_egress_limits(uint16_t depth, uint16_t max_outstanding) {
+        if (msi_relay_) msi_relay_->set_egress_limits(depth, max_outstanding);
+    }
+    // MSI receiver writes rejected because the egress FIFO was full
+    [[nodiscard]] uint64_t get_msi_backpressure_count() const noexcept {
+        return msi_relay_ ? msi_relay_->get_backpressure_count() : 0;
+    }
+    // MSI delivery passes run so far; delivery is event driven, so this only
+    // moves when a vector becomes deliverable, a holdoff expires, an MSI
+    // write completes or isolation is released
+    [[nodiscard]] uint64_t get_msi_delivery_passes() const noexcept {
+        return msi_relay_ ? msi_relay_->get_delivery_pass_count() : 0;
+    }
+    
+    // Downstream access watchdog: any access forwarded through an initiator
+    // socket that takes longer than 'timeout' completes with DECERR and sets
+    // the matching noc_timeout bit. SC_ZERO_TIME (default) disables it.
+    void set_downstream_timeout(const sc_core::sc_time& timeout);
+    [[nodiscard]] uint64_t get_downstream_timeout_count() const noexcept {
+        return timeout_watchdog_ ? timeout_watchdog_->get_expired_count() : 0;
+    }
+    // The noc_timeout bits are sticky (neither reset pin clears them); this
+    // clears all three, and the pin follows on the next input change
+    void clear_downstream_timeout_status() {
+        if (noc_io_switch_) {
+            noc_io_switch_->set_timeout_read(false);
+            noc_io_switch_->set_timeout_write(false);
+        }
+        if (smn_io_switch_) smn_io_switch_->set_timeout(false);
+    }
+    
+    // Post-boot state without the SMN boot sequence (see BootConfig), written
+    // straight into the components. set_boot_config() is for elaboration:
+    // the state is applied when cold reset and the controller reset are
+    // first both released. apply_boot_config() applies it now (after
+    // elaboration). Later resets behave as usual, e.g. a controller reset
+    // clears the SII bus/dev number and device type. Both check the MSI-X
+    // vectors against the relay first; on false nothing is applied and
+    // 'error' names the offending vector.
+    bool set_boot_config(const BootConfig& config, std::string& error);
+    bool apply_boot_config(const BootConfig& config, std::string& error);
+    
+    // Power-on state of the management domain in O(1) per table: TLBs, MSI
+    // relay, SII and config registers back to reset values. For harnesses
+    // that power-cycle a tile many times per run; the cold_reset_n pin keeps
+    // its narrower scope (resets and watchdog only).
+    void reset_state();
+    
+    // Whole-tile checkpoint: register spaces, TLBs, MSI relay (tables, PBA,
+    // moderation, egress FIFO), SII/CII tracking, switch and reset state and
+    // the internal control signals, as a versioned binary stream. Take it at
+    // a quiescent point (no b_transport in progress); watchdog-tracked
+    // accesses are not saved. Moderation ticks are absolute, so restore at
+    // the same sim time or expect held vectors to release early/late.
+    // restore_state() needs a tile built the same way; on false the tile
+    // state is undefined and it should be reset or restored again.
+    static constexpr uint32_t CHECKPOINT_VERSION = 1;
+    bool save_state(std::ostream& out) const;
+    bool restore_state(std::istream& in);
+    
+    // Binary activity trace (effective only in builds with KERAUNOS_PCIE_TRACE=1)
+    bool start_trace(const std::string& path) { return tracer_.start(path); }
+    void stop_trace() { tracer_.stop(); }
+    [[nodiscard]] const Tracer& get_tracer() const noexcept { return tracer_; }
+    // Per-hop span trace as Chrome trace-event JSON (same build flag)
+    bool start_span_trace(const std::string& path) { return span_tracer_.start(path, name()); }
+    void stop_span_trace() { span_tracer_.stop(); }
+    [[nodiscard]] const SpanTracer& get_span_tracer() const noexcept { return span_tracer_; }
+    // Host-cycle profile of component entry points (build with KERAUNOS_PCIE_PROFILE=1);
+    // the ranked table is printed at end of simulation
+    void set_profiling(bool enable) noexcept { profiler_.set_enabled(enable); }
+    [[nodiscard]] const Profiler& get_profiler() const noexcept { return profiler_; }
+    
 protected:
     // Top-level socket transport methods (target sockets only - initiator sockets forward outward)
     void noc_n_target_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
@@ -115,15 +205,46 @@ protected:
     
     // Signal update process
     void signal_update_process();
+    void trace_pin_changes();
+    
+    // MSI delivery: control signals feed the relay on change only, and
+    // delivery runs when the relay reports a newly deliverable vector
+    void msi_control_process();
+    void msi_delivery_process();
+    // Runs the relay at the current moderation tick and re-arms
+    // msi_delivery_event_ for the next holdoff release / MSI write completion
+    void deliver_msis();
     
     // Helper method to update modules that depend on config registers
     void update_config_dependent_modules();
     
+    // Forward through an initiator socket under watchdog supervision
+    void forward_downstream(tlm_utils::simple_initiator_socket<KeraunosPcieTile, 64>& socket,
+                            bool smn_path, Transaction& trans, SimTime& delay);
+    [[nodiscard]] uint64_t watchdog_tick(const sc_core::sc_time& delay) const {
+        return (sc_core::sc_time_stamp() + delay).value() / watchdog_tick_value_;
+    }
+    [[nodiscard]] TraceEvent initiator_trace_event(
+            const tlm_utils::simple_initiator_socket<KeraunosPcieTile, 64>& socket) const noexcept {
+        return (&socket == &smn_n_initiator) ? TraceEvent::SmnInitiator
+             : (&socket == &noc_n_initiator) ? TraceEvent::NocInitiator
+             : TraceEvent::PcieInitiator;
+    }
+    [[nodiscard]] SpanHop initiator_span_hop(
+            const tlm_utils::simple_initiator_socket<KeraunosPcieTile, 64>& socket) const noexcept {
+        return (&socket == &smn_n_initiator) ? SpanHop::SmnInitiator
+             : (&socket == &noc_n_initiator) ? SpanHop::NocInitiator
+             : SpanHop::PcieControllerInitiator;
+    }
+    
 protected:
     // ========================================================================
     // INTERNAL COMPONENTS (C++ classes - NO sockets!)
     // Using std::unique_ptr for automatic memory management (RAII)
     // ========================================================================
+    Tracer tracer_;  // Declared first: outlives the components that reference it
+    SpanTracer span_tracer_;
+    Profiler profiler_;
     std::unique_ptr<NocPcieSwitch> noc_pcie_switch_;
     std::unique_ptr<NocIoSwitch> noc_io_switch_;
     std::unique_ptr<SmnIoSwitch> smn_io_switch_;
@@ -139,6 +260,12 @@ protected:
     std::unique_ptr<ClockResetControl> clock_reset_ctrl_;
     std::unique_ptr<PllCgm> pll_cgm_;
     std::unique_ptr<PciePhy> pcie_phy_;
+    std::unique_ptr<TimeoutWatchdog> timeout_watchdog_;
+    uint64_t watchdog_tick_value_;  // sc_time resolution units per watchdog tick
+    uint64_t msi_tick_value_;       // sc_time resolution units per MSI moderation tick
+    bool msi_control_restored_;     // Next msi_control_process keeps the relay's per-PF state
+    PayloadPool payload_pool_;      // Payloads for relay-generated MSI writes
+    std::unique_ptr<BootConfig> pending_boot_config_;  // Applied on first reset release
     
     // Internal signals
     sc_core::sc_signal<bool> system_ready_;
@@ -147,6 +274,7 @@ protected:
     sc_core::sc_signal<bool> msix_enable_;
     sc_core::sc_signal<bool> msix_mask_;
     sc_core::sc_signal<sc_dt::sc_bv<16>> setip_;
+    sc_core::sc_event msi_delivery_event_;
     sc_core::sc_signal<bool> pcie_clock_;
     sc_core::sc_signal<bool> ref_clock_;
     sc_core::sc_signal<bool> pcie_sii_reset_ctrl_;
@@ -0,0 +1,114 @@
+#ifndef KERAUNOS_PCIE_TIMEOUT_WATCHDOG_H
+#define KERAUNOS_PCIE_TIMEOUT_WATCHDOG_H
+
+// Outstanding-transaction watchdog (plain C++ class, no SystemC dependency)
+
+#include <array>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+namespace keraunos {
+namespace pcie {
+
+/**
+ * Timeout Watchdog
+ * Tracks every in-flight downstream access with its deadline in a
+ * hierarchical timer wheel (4 levels x 256 slots, 1 tick resolution).
+ * - arm()/complete() are O(1): intrusive list nodes in a pooled vector
+ * - advance() skips empty slots via per-level occupancy bitmaps, so idle
+ *   stretches of sim time cost a handful of word scans, not one step per tick
+ * - Deadlines beyond the wheel range park in the top level and re-cascade
+ * Time is an abstract tick count; the tile converts sc_time to ticks.
+ */
+class TimeoutWatchdog {
+public:
+    // Timeout channels, one per noc_timeout output bit
+    enum class Channel : uint8_t {
+        NocRead  = 0,   // noc_timeout[0]
+        NocWrite = 1,   // noc_timeout[1]
+        Smn      = 2    // noc_timeout[2]
+    };
+
+    using Handle = uint64_t;
+    using ExpiryCallback = std::function<void(Channel)>;
+
+    static constexpr Handle INVALID_HANDLE = ~0ULL;
+
+    TimeoutWatchdog();
+    ~TimeoutWatchdog() = default;
+
+    // Timeout in ticks; 0 disables the watchdog (arm() returns INVALID_HANDLE)
+    void set_timeout_ticks(const uint64_t ticks) noexcept { timeout_ticks_ = ticks; }
+    [[nodiscard]] uint64_t get_timeout_ticks() const noexcept { return timeout_ticks_; }
+    [[nodiscard]] bool is_enabled() const noexcept { return timeout_ticks_ != 0; }
+
+    // Called once per expired access, at the tick its deadline passes
+    void set_expiry_callback(ExpiryCallback cb) { expiry_callback_ = cb; }
+
+    // Register an access issued at now_tick; deadline = now_tick + timeout
+    [[nodiscard]] Handle arm(uint64_t now_tick, Channel channel);
+
+    // Retire an access that completed at done_tick.
+    // Returns true if it missed its deadline (expired in the wheel, or the
+    // annotated completion time lies past the deadline).
+    bool complete(Handle handle, uint64_t done_tick);
+
+    // Move the wheel forward, firing every deadline <= now_tick
+    void advance(uint64_t now_tick);
+
+    // Drop all outstanding accesses (reset)
+    void clear();
+
+    [[nodiscard]] size_t get_outstanding() const noexcept { return outstanding_; }
+    [[nodiscard]] uint64_t get_expired_count() const noexcept { return expired_count_; }
+    [[nodiscard]] uint64_t get_current_tick() const noexcept { return now_; }
+
+private:
+    static constexpr unsigned LEVELS = 4;
+    static constexpr unsigned SLOT_BITS = 8;
+    static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr unsigned BITMAP_WORDS = SLOTS / 64;
+    static constexpr uint32_t NIL = ~0u;
+
+    enum class NodeState : uint8_t { Free, Armed, Expired };
+
+    struct Node {
+        uint64_t deadline;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t generation;
+        uint16_t bucket;        // level * SLOTS + slot
+        Channel channel;
+        NodeState state;
+        Node() : deadline(0), prev(NIL), next(NIL), generation(0), bucket(0),
+                 channel(Channel::NocRead), state(NodeState::Free) {}
+    };
+
+    std::vector<Node> nodes_;
+    uint32_t free_head_;
+    std::array<uint32_t, LEVELS * SLOTS> buckets_;
+    std::array<uint64_t, LEVELS * BITMAP_WORDS> occupancy_;
+
+    uint64_t now_;
+    uint64_t timeout_ticks_;
+    size_t armed_;          // nodes linked into the wheel
+    size_t outstanding_;    // armed + expired but not yet completed
+    uint64_t expired_count_;
+    ExpiryCallback expiry_callback_;
+
+    uint32_t alloc_node();
+    void free_node(uint32_t idx);
+    void insert(uint32_t idx);
+    void unlink(uint32_t idx);
+    void cascade(unsigned level);
+    void expire_slot();
+    uint64_t next_event_tick() const;
+    int find_occupied_slot(unsigned level, unsigned from) const;
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_TIMEOUT_WATCHDOG_H
@@ -1,10 +1,12 @@
 #ifndef KERAUNOS_PCIE_TLB_COMMON_H
 #define KERAUNOS_PCIE_TLB_COMMON_H
 
-#include <systemc>
-#include <tlm>
+#include "keraunos_pcie_checkpoint.h"
+#include "keraunos_pcie_cow_array.h"
+#include "keraunos_pcie_sparse_regs.h"
+#include "keraunos_pcie_transaction.h"
 #include <cstdint>
-#include <sc_dt.h>
+#include <memory>
 
 namespace keraunos {
 namespace pcie {
@@ -14,11 +16,69 @@ namespace pcie {
 struct TlbEntry {
     bool valid;                    // [0] Valid bit
     uint64_t addr;                 // [63:12] Address (52 bits)
-    sc_dt::sc_bv<256> attr;       // [255:0] Attribute for AxUSER field
+    AxUser attr;                   // [255:0] Attribute for AxUSER field
     
     TlbEntry() : valid(false), addr(0), attr(0) {}
 };
 
+// TLB entry table: reset contents shared by every instance of a TLB type,
+// entries copied out page-wise when software programs them
+using TlbTable = CowArray<TlbEntry>;
+
+// Reset image with entry 0 valid (addr is the unshifted base address)
+inline std::shared_ptr<const TlbTable::Image> make_tlb_reset_image(size_t entries, uint64_t addr, uint32_t attr) {
+    TlbTable::Image image(entries);
+    image[0].valid = true;
+    image[0].addr = addr >> 12;
+    image[0].attr = attr;
+    return TlbTable::make_image(std::move(image));
+}
+
+// Register image of an entry in the 64-byte config layout: [0] valid +
+// ADDR[31:12], [4] ADDR[63:32], [32..63] ATTR
+inline void store_tlb_entry(SparseRegisterStore& regs, uint8_t index, const TlbEntry& entry) {
+    const size_t base = static_cast<size_t>(index) * 64;
+    const uint64_t addr = entry.addr << 12;
+    regs.write32(base, static_cast<uint32_t>(addr) | (entry.valid ? 0x1 : 0));
+    regs.write32(base + 4, static_cast<uint32_t>(addr >> 32));
+    for (int w = 0; w < 8; w++) regs.write32(base + 32 + w * 4, entry.attr.get_word(w));
+}
+
+// Checkpoint of the entries that differ from the reset image (those on
+// private pages): index, valid, addr and ATTR as 32-bit words
+inline void save_tlb_table(CheckpointWriter& out, const TlbTable& table) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < table.size(); i++) count += table.is_private(i) ? 1 : 0;
+    out.put<uint32_t>(static_cast<uint32_t>(table.size()));
+    out.put<uint32_t>(count);
+    for (size_t i = 0; i < table.size(); i++) {
+        if (!table.is_private(i)) continue;
+        const TlbEntry& entry = table[i];
+        out.put<uint16_t>(static_cast<uint16_t>(i));
+        out.put_flag(entry.valid);
+        out.put<uint64_t>(entry.addr);
+        for (int w = 0; w < 8; w++) out.put<uint32_t>(entry.attr.get_word(w));
+    }
+}
+
+inline bool restore_tlb_table(CheckpointReader& in, TlbTable& table) {
+    if (in.get<uint32_t>() != table.size()) in.fail();
+    const uint32_t count = in.get<uint32_t>();
+    table.reset();
+    for (uint32_t n = 0; n < count && in.ok(); n++) {
+        const uint16_t index = in.get<uint16_t>();
+        if (index >= table.size()) {
+            in.fail();
+            break;
+        }
+        TlbEntry& entry = table.mutate(index);
+        entry.valid = in.get_flag();
+        entry.addr = in.get<uint64_t>();
+        for (int w = 0; w < 8; w++) entry.attr.set_word(w, in.get<uint32_t>());
+    }
+    return in.ok();
+}
+
 // Invalid address constant to return DECERR
 const uint64_t INVALID_ADDRESS_DECERR = 0xFFFFFFFFFFFFFFFFULL;
 
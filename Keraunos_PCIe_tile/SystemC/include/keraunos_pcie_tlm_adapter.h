@@ -0,0 +1,235 @@
+#ifndef KERAUNOS_PCIE_TLM_ADAPTER_H
+#define KERAUNOS_PCIE_TLM_ADAPTER_H
+
+// TLM side of the core types (header-only): payload <-> Transaction,
+// sc_time <-> SimTime, and the TLM extensions the tile understands.
+// Only the tile (and testbenches) include this; libkeraunos_core does not.
+
+#include "keraunos_pcie_common.h"
+#include "keraunos_pcie_payload_pool.h"
+#include "keraunos_pcie_trace.h"
+#include <systemc>
+#include <tlm>
+#include <cstdint>
+#include <cstring>
+
+namespace keraunos {
+namespace pcie {
+
+// AxUSER TLM extension — carries sideband (AxUSER) info through TLM transactions.
+struct AxUserExtension : public tlm::tlm_extension<AxUserExtension> {
+    AxUser axuser;
+
+    AxUserExtension() : axuser(0) {}
+
+    tlm::tlm_extension_base* clone() const override {
+        auto* e = new AxUserExtension;
+        e->axuser = axuser;
+        return e;
+    }
+    void copy_from(const tlm::tlm_extension_base& other) override {
+        axuser = static_cast<const AxUserExtension&>(other).axuser;
+    }
+};
+
+// Transaction correlation ID extension — carries Transaction::span_id across
+// tiles that forward the same payload, so per-hop spans stitch together.
+// Read on entry to a tile, attached while a traced transaction is forwarded.
+struct TransactionIdExtension : public tlm::tlm_extension<TransactionIdExtension> {
+    uint64_t id;
+    uint32_t root;   // SpanHop of the span that assigned the ID
+
+    TransactionIdExtension() : id(0), root(0) {}
+
+    tlm::tlm_extension_base* clone() const override {
+        auto* e = new TransactionIdExtension;
+        e->id = id;
+        e->root = root;
+        return e;
+    }
+    void copy_from(const tlm::tlm_extension_base& other) override {
+        id = static_cast<const TransactionIdExtension&>(other).id;
+        root = static_cast<const TransactionIdExtension&>(other).root;
+    }
+};
+
+inline void set_52bit_address(tlm::tlm_generic_payload& trans, const uint64_t addr) noexcept {
+    trans.set_address(mask_52bit_address(addr));
+}
+
+[[nodiscard]] inline uint64_t get_52bit_address(const tlm::tlm_generic_payload& trans) noexcept {
+    return mask_52bit_address(trans.get_address());
+}
+
+// trace_data_word() for payloads that never pass through the core (testbenches)
+inline uint32_t trace_data_word(const tlm::tlm_generic_payload& trans) {
+    return trace_data_word(Transaction(Command::Ignore, 0, trans.get_data_ptr(), trans.get_data_length()));
+}
+
+// Kernel time resolution in femtoseconds (a power of ten; fixed once the
+// simulation has created an sc_time, which it has by the first transport)
+[[nodiscard]] inline uint64_t kernel_resolution_fs() {
+    return static_cast<uint64_t>(sc_core::sc_get_time_resolution().to_seconds() * 1e15 + 0.5);
+}
+
+// Kernel time <-> SimTime; exact at the default 1 ps resolution, rounded
+// down to whole picoseconds (or resolution units) otherwise
+[[nodiscard]] inline SimTime to_sim_time(const sc_core::sc_time& t) {
+    static const uint64_t fs = kernel_resolution_fs();
+    return fs >= 1000 ? t.value() * (fs / 1000) : t.value() / (1000 / fs);
+}
+
+[[nodiscard]] inline sc_core::sc_time to_sc_time(SimTime ps) {
+    static const uint64_t fs = kernel_resolution_fs();
+    return sc_core::sc_time::from_value(fs >= 1000 ? ps / (fs / 1000) : ps * (1000 / fs));
+}
+
+// SimClock reading the kernel (for Tracer / SpanTracer::set_clock)
+inline SimTime kernel_sim_time() {
+    return to_sim_time(sc_core::sc_time_stamp());
+}
+
+/**
+ * TLM Target Adapter
+ * An inbound b_transport as a core Transaction for the adapter's lifetime:
+ * - The Transaction shares the payload's data buffer; address (the TLBs
+ *   translate in place) and response go back to the payload on destruction,
+ *   and the TLM delay moves by whatever the core changed, up or down (a
+ *   downstream target that synchronised may hand back less than it got)
+ * - The payload rides along in Transaction::context, so an initiator hop
+ *   forwards the very same object downstream, extensions included
+ * - A TransactionIdExtension from an upstream tile seeds the span ID
+ */
+class TlmTargetAdapter {
+public:
+    TlmTargetAdapter(tlm::tlm_generic_payload& payload, sc_core::sc_time& delay)
+        : payload_(payload)
+        , sc_delay_(delay)
+        , start_(to_sim_time(delay))
+        , delay_(start_)
+    {
+        trans_.command = static_cast<Command>(payload.get_command());
+        trans_.response = static_cast<Response>(payload.get_response_status());
+        trans_.length = payload.get_data_length();
+        trans_.address = payload.get_address();
+        trans_.data = payload.get_data_ptr();
+        trans_.context = &payload;
+        if (const TransactionIdExtension* id = payload.get_extension<TransactionIdExtension>()) {
+            trans_.span_id = id->id;
+            trans_.span_root = id->root;
+        }
+    }
+    ~TlmTargetAdapter() {
+        payload_.set_address(trans_.address);
+        payload_.set_response_status(static_cast<tlm::tlm_response_status>(trans_.response));
+        // The difference, not the value: an unchanged delay keeps any part
+        // below the SimTime resolution
+        if (delay_ >= start_) {
+            sc_delay_ += to_sc_time(delay_ - start_);
+        } else {
+            sc_delay_ -= to_sc_time(start_ - delay_);
+        }
+    }
+
+    TlmTargetAdapter(const TlmTargetAdapter&) = delete;
+    TlmTargetAdapter& operator=(const TlmTargetAdapter&) = delete;
+
+    [[nodiscard]] Transaction& transaction() noexcept { return trans_; }
+    [[nodiscard]] SimTime& delay() noexcept { return delay_; }
+
+private:
+    tlm::tlm_generic_payload& payload_;
+    sc_core::sc_time& sc_delay_;
+    SimTime start_;
+    SimTime delay_;
+    Transaction trans_;
+};
+
+/**
+ * TLM Initiator Adapter
+ * A core Transaction as a TLM payload for one outbound b_transport:
+ * - Forwards the originating payload (Transaction::context) when there is
+ *   one, else a pooled payload holding a copy of the data (relay-generated
+ *   MSI writes); a downstream target may keep a pooled payload past the call
+ * - Response, delay and the read data of a pooled payload come back on
+ *   destruction; a forwarded payload gets its own command, address, data
+ *   pointer and length back, so the caller finds it as it sent it
+ * - A traced transaction carries its span ID as a TransactionIdExtension
+ *   while forwarded, unless the payload already has one
+ */
+class TlmInitiatorAdapter {
+public:
+    TlmInitiatorAdapter(Transaction& trans, SimTime& delay, PayloadPool& pool)
+        : trans_(trans)
+        , delay_(delay)
+        , sc_delay_(to_sc_time(delay))
+        , pooled_(trans.context == nullptr)
+        , payload_(pooled_ ? pool.acquire(static_cast<tlm::tlm_command>(trans.command),
+                                          trans.address, trans.length)
+                           : static_cast<tlm::tlm_generic_payload*>(trans.context))
+        , attached_(false)
+        , command_(payload_->get_command())
+        , address_(payload_->get_address())
+        , data_(payload_->get_data_ptr())
+        , length_(payload_->get_data_length())
+    {
+        if (pooled_) {
+            if (trans.data && !trans.is_read()) {
+                std::memcpy(payload_->get_data_ptr(), trans.data, trans.length);
+            }
+        } else {
+            payload_->set_command(static_cast<tlm::tlm_command>(trans.command));
+            payload_->set_address(trans.address);
+            payload_->set_data_ptr(trans.data);
+            payload_->set_data_length(trans.length);
+        }
+        payload_->set_response_status(static_cast<tlm::tlm_response_status>(trans.response));
+        if (trans.span_id != 0 && !payload_->get_extension<TransactionIdExtension>()) {
+            span_id_.id = trans.span_id;
+            span_id_.root = trans.span_root;
+            payload_->set_extension(&span_id_);
+            attached_ = true;
+        }
+    }
+    ~TlmInitiatorAdapter() {
+        if (attached_) payload_->clear_extension(&span_id_);
+        trans_.response = static_cast<Response>(payload_->get_response_status());
+        delay_ = to_sim_time(sc_delay_);
+        if (pooled_) {
+            if (trans_.data && trans_.is_read()) {
+                std::memcpy(trans_.data, payload_->get_data_ptr(), trans_.length);
+            }
+            payload_->release();
+        } else {
+            payload_->set_command(command_);
+            payload_->set_address(address_);
+            payload_->set_data_ptr(data_);
+            payload_->set_data_length(length_);
+        }
+    }
+
+    TlmInitiatorAdapter(const TlmInitiatorAdapter&) = delete;
+    TlmInitiatorAdapter& operator=(const TlmInitiatorAdapter&) = delete;
+
+    [[nodiscard]] tlm::tlm_generic_payload& payload() noexcept { return *payload_; }
+    [[nodiscard]] sc_core::sc_time& delay() noexcept { return sc_delay_; }
+
+private:
+    Transaction& trans_;
+    SimTime& delay_;
+    sc_core::sc_time sc_delay_;
+    bool pooled_;
+    tlm::tlm_generic_payload* payload_;
+    bool attached_;
+    TransactionIdExtension span_id_;
+    // Forwarded payload's own fields, restored on destruction
+    tlm::tlm_command command_;
+    uint64_t address_;
+    unsigned char* data_;
+    unsigned int length_;
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_TLM_ADAPTER_H
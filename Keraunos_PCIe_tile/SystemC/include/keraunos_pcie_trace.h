@@ -0,0 +1,183 @@
+#ifndef KERAUNOS_PCIE_TRACE_H
+#define KERAUNOS_PCIE_TRACE_H
+
+// Binary activity tracer: lock-free ring, writer thread, compact encoding
+//
+// Trace sites use KERAUNOS_TRACE(tracer, ...). Unless the build defines
+// KERAUNOS_PCIE_TRACE=1 the macro generates no code; when compiled in, a
+// disabled tracer costs one predictable branch per site.
+
+#include "keraunos_pcie_trace_format.h"
+#include "keraunos_pcie_transaction.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#ifndef KERAUNOS_PCIE_TRACE
+#define KERAUNOS_PCIE_TRACE 0
+#endif
+
+#if KERAUNOS_PCIE_TRACE
+#define KERAUNOS_TRACE(tracer, ...) \
+    do { if ((tracer).is_enabled()) (tracer).record(__VA_ARGS__); } while (0)
+#else
+// Unevaluated: no code, but arguments still count as used
+#define KERAUNOS_TRACE(tracer, ...) \
+    do { (void)sizeof(((tracer).record(__VA_ARGS__), 0)); } while (0)
+#endif
+
+namespace keraunos {
+namespace pcie {
+
+// Compact AxUSER summary for trace records: {DBI (bit 21), TLP type [4:0]}
+inline uint32_t trace_axuser_bits(const AxUser& axuser) {
+    uint32_t bits = axuser.to_uint() & 0x1Fu;
+    return bits | (axuser.bit(21) ? 0x20u : 0u);
+}
+
+// First (up to) four data bytes, little-endian: enough to replay register traffic
+inline uint32_t trace_data_word(const Transaction& trans) {
+    const unsigned char* data = trans.get_data_ptr();
+    if (!data) return 0;
+    unsigned len = trans.get_data_length() < 4 ? trans.get_data_length() : 4;
+    uint32_t word = 0;
+    for (unsigned i = 0; i < len; i++) {
+        word |= static_cast<uint32_t>(data[i]) << (8 * i);
+    }
+    return word;
+}
+
+/**
+ * Single-producer / single-consumer ring of TraceRecords.
+ * The simulation thread pushes, the writer thread pops; no locks.
+ * Capacity is rounded up to a power of two. A full ring drops the record.
+ */
+class TraceRing {
+public:
+    explicit TraceRing(size_t capacity);
+
+    bool push(const TraceRecord& record) noexcept {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        buffer_[head & mask_] = record;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copy up to max_records into out; returns the count
+    size_t pop(TraceRecord* out, size_t max_records) noexcept;
+
+    [[nodiscard]] size_t capacity() const noexcept { return mask_ + 1; }
+
+private:
+    std::vector<TraceRecord> buffer_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+/**
+ * Tracer
+ * One per tile. start() opens the output file, allocates the ring and spawns
+ * the writer thread that drains it; stop() (or destruction) drains the rest,
+ * closes and frees the ring, so an idle tracer holds no ring memory.
+ * Records pushed while stopped count as dropped.
+ * The simulation thread only copies fixed TraceRecords into the ring; the
+ * writer thread does the delta/varint encoding (keraunos_pcie_trace_format.h)
+ * and reports the encoded volume through get_bytes_written().
+ * Records are stamped in picoseconds from the clock set_clock() installs
+ * (none by default: time 0).
+ */
+class Tracer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1u << 16;
+
+    explicit Tracer(size_t capacity = DEFAULT_CAPACITY);
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    bool start(const std::string& path);
+    void stop();
+    [[nodiscard]] bool is_enabled() const noexcept { return enabled_; }
+    void set_clock(SimClock clock) noexcept { clock_ = clock ? clock : &no_clock; }
+
+    // Transaction hop: address before/after translation, TLB entry, route
+    void record(TraceEvent event, const Transaction& trans,
+                uint64_t address, uint64_t translated, uint16_t tlb_entry = TRACE_NO_ENTRY,
+                uint8_t route = TRACE_NO_ROUTE, uint32_t aux = 0) noexcept {
+        TraceRecord rec;
+        rec.sim_time = clock_();
+        rec.address = address;
+        rec.translated = translated;
+        rec.length = trans.get_data_length();
+        rec.aux = aux;
+        rec.tlb_entry = tlb_entry;
+        rec.event = static_cast<uint8_t>(event);
+        rec.command = static_cast<uint8_t>(trans.get_command());
+        rec.response = static_cast<int8_t>(trans.get_response_status());
+        rec.route = route;
+        push(rec);
+    }
+
+    void record(TraceEvent event, const Transaction& trans) noexcept {
+        record(event, trans, trans.get_address(), trans.get_address());
+    }
+
+    // Control event without a transaction
+    void record(TraceEvent event, uint64_t address, uint32_t aux,
+                uint16_t tlb_entry = TRACE_NO_ENTRY) noexcept {
+        TraceRecord rec = {};
+        rec.sim_time = clock_();
+        rec.address = address;
+        rec.translated = address;
+        rec.aux = aux;
+        rec.tlb_entry = tlb_entry;
+        rec.event = static_cast<uint8_t>(event);
+        rec.command = static_cast<uint8_t>(Command::Ignore);
+        rec.response = static_cast<int8_t>(Response::Ok);
+        rec.route = TRACE_NO_ROUTE;
+        push(rec);
+    }
+
+    [[nodiscard]] uint64_t get_recorded() const noexcept { return recorded_; }
+    [[nodiscard]] uint64_t get_dropped() const noexcept { return dropped_; }
+    // Encoded bytes written so far, header included (final after stop())
+    [[nodiscard]] uint64_t get_bytes_written() const noexcept {
+        return bytes_written_.load(std::memory_order_relaxed);
+    }
+
+    // Shared always-disabled instance for components not wired to a tile
+    static Tracer& disabled();
+
+private:
+    size_t capacity_;
+    std::unique_ptr<TraceRing> ring_;   // Only while started
+    SimClock clock_;
+    bool enabled_;
+    uint64_t recorded_;
+    uint64_t dropped_;
+    std::FILE* file_;
+    std::thread writer_;
+    std::atomic<bool> stop_requested_;
+    std::atomic<uint64_t> bytes_written_;
+
+    void push(const TraceRecord& rec) noexcept {
+        if (ring_ && ring_->push(rec)) recorded_++; else dropped_++;
+    }
+    void writer_loop();
+    static SimTime no_clock() { return 0; }
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_TRACE_H
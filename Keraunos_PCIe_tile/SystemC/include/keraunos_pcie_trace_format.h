@@ -0,0 +1,279 @@
+#ifndef KERAUNOS_PCIE_TRACE_FORMAT_H
+#define KERAUNOS_PCIE_TRACE_FORMAT_H
+
+// Versioned binary trace format (header-only, no SystemC dependency)
+// Shared by the tile tracer (encoder) and the offline decoder tool
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace keraunos {
+namespace pcie {
+
+// Trace points (values are part of the on-disk format)
+enum class TraceEvent : uint8_t {
+    // Target sockets, recorded on completion (aux = first <=4 data bytes, LE)
+    NocTarget           = 1,
+    SmnTarget           = 2,
+    PcieTarget          = 3,
+    // Initiator sockets, recorded on completion
+    NocInitiator        = 4,
+    SmnInitiator        = 5,
+    PcieInitiator       = 6,
+    // Internal hops
+    NocPcieRoute        = 7,   // route_from_pcie decode (route = NocPcieRoute)
+    RouteToPcieNoAxuser = 8,   // route_to_pcie without AxUSER
+    RouteToPcieBmeCheck = 9,   // EP with BME=0 (aux = {exempt, DBI, TLP type[4:0]})
+    TlbSysIn0           = 10,
+    TlbAppIn0           = 11,  // aux = instance
+    TlbAppIn1           = 12,
+    TlbSysOut0          = 13,
+    TlbAppOut0          = 14,
+    TlbAppOut1          = 15,
+    // Control events (address/aux only)
+    SetBusMasterEnable  = 16,  // aux = BME
+    TlbAppIn0Configure  = 17,  // address = entry ADDR, aux = {valid, ATTR[30:0]}
+    SignalChange        = 18   // address = TracePin, aux = new value
+};
+
+// Control inputs recorded by SignalChange (values are part of the on-disk format)
+enum class TracePin : uint8_t {
+    ColdResetN, WarmResetN, IsolateReq, PcieControllerResetN,
+    PcieCiiHv, PcieCiiHdrType, PcieCiiHdrAddr,
+    PcieFlrRequest, PcieHotReset, PcieRasError, PcieDmaCompletion, PcieMiscInt,
+    MsixEnable, MsixFunctionMask,
+    Count
+};
+
+inline const char* trace_event_name(uint8_t event) {
+    static const char* const names[] = {
+        "?", "noc_target", "smn_target", "pcie_target",
+        "noc_initiator", "smn_initiator", "pcie_initiator",
+        "noc_pcie_route", "route_to_pcie_no_axuser", "route_to_pcie_bme_check",
+        "tlb_sys_in0", "tlb_app_in0", "tlb_app_in1",
+        "tlb_sys_out0", "tlb_app_out0", "tlb_app_out1",
+        "set_bus_master_enable", "tlb_app_in0_configure", "signal_change"
+    };
+    return (event < sizeof(names) / sizeof(names[0])) ? names[event] : "?";
+}
+
+inline const char* trace_pin_name(uint64_t pin) {
+    static const char* const names[] = {
+        "cold_reset_n", "warm_reset_n", "isolate_req", "pcie_controller_reset_n",
+        "pcie_cii_hv", "pcie_cii_hdr_type", "pcie_cii_hdr_addr",
+        "pcie_flr_request", "pcie_hot_reset", "pcie_ras_error",
+        "pcie_dma_completion", "pcie_misc_int",
+        "msix_enable", "msix_function_mask"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(TracePin::Count),
+                  "trace_pin_name table out of sync with TracePin");
+    return (pin < sizeof(names) / sizeof(names[0])) ? names[pin] : "?";
+}
+
+constexpr uint8_t TRACE_NO_ROUTE = 0xFF;
+constexpr uint16_t TRACE_NO_ENTRY = 0xFFFF;
+
+/**
+ * Trace Record (in-memory form, 40 bytes)
+ * What the simulation thread pushes into the ring; the writer thread
+ * encodes it to the compact on-disk form.
+ */
+struct TraceRecord {
+    uint64_t sim_time;     // Simulated time in header resolution units (ps)
+    uint64_t address;      // before translation
+    uint64_t translated;   // after translation (== address if untranslated)
+    uint32_t length;
+    uint32_t aux;          // event-specific
+    uint16_t tlb_entry;    // TLB entry hit, TRACE_NO_ENTRY if none
+    uint8_t event;         // TraceEvent
+    uint8_t command;       // tlm_command
+    int8_t response;       // tlm_response_status
+    uint8_t route;         // TRACE_NO_ROUTE if none
+    uint8_t reserved[2];
+};
+static_assert(sizeof(TraceRecord) == 40, "TraceRecord must stay 40 bytes");
+
+/**
+ * File layout (version 2)
+ *   Header (16 bytes): "KPTR", u16 version, u16 reserved, u64 time resolution (fs)
+ *   Records:
+ *     u8 event
+ *     u8 flags   [0] time delta follows   [1] translated follows
+ *                [2] length follows       [3] TLB entry follows
+ *                [4] route follows        [5] aux follows
+ *     u8 status  [1:0] command, [4:2] response + 5
+ *     varint time delta                        (flag 0)
+ *     varint zigzag(address - previous address)
+ *     varint zigzag(translated - previous translated)  (flag 1, else = address)
+ *     varint length                            (flag 2, else previous length)
+ *     varint TLB entry                         (flag 3)
+ *     u8 route                                 (flag 4)
+ *     varint aux                               (flag 5)
+ * Little-endian throughout; delta state starts at zero.
+ */
+constexpr char TRACE_MAGIC[4] = {'K', 'P', 'T', 'R'};
+constexpr uint16_t TRACE_FORMAT_VERSION = 2;
+constexpr size_t TRACE_HEADER_SIZE = 16;
+// Resolution the tile records at (SimTime is picoseconds); readers use the header
+constexpr uint64_t TRACE_RESOLUTION_FS = 1000;
+constexpr size_t TRACE_MAX_ENCODED_RECORD = 3 + 10 * 5 + 3 + 1;
+
+inline void trace_write_header(uint8_t* out, uint64_t resolution_fs) {
+    std::memset(out, 0, TRACE_HEADER_SIZE);
+    std::memcpy(out, TRACE_MAGIC, 4);
+    out[4] = TRACE_FORMAT_VERSION & 0xFF;
+    out[5] = TRACE_FORMAT_VERSION >> 8;
+    for (int i = 0; i < 8; i++) {
+        out[8 + i] = static_cast<uint8_t>(resolution_fs >> (8 * i));
+    }
+}
+
+// Returns false on bad magic or unsupported version
+inline bool trace_read_header(const uint8_t* in, uint64_t& resolution_fs) {
+    if (std::memcmp(in, TRACE_MAGIC, 4) != 0) return false;
+    if ((in[4] | (in[5] << 8)) != TRACE_FORMAT_VERSION) return false;
+    resolution_fs = 0;
+    for (int i = 0; i < 8; i++) {
+        resolution_fs |= static_cast<uint64_t>(in[8 + i]) << (8 * i);
+    }
+    return true;
+}
+
+/**
+ * Trace Codec
+ * Holds the delta state; one instance per stream on each side.
+ */
+class TraceCodec {
+public:
+    enum : uint8_t {
+        FLAG_TIME = 0x01, FLAG_TRANSLATED = 0x02, FLAG_LENGTH = 0x04,
+        FLAG_ENTRY = 0x08, FLAG_ROUTE = 0x10, FLAG_AUX = 0x20
+    };
+
+    // Encode into out (at least TRACE_MAX_ENCODED_RECORD bytes); returns bytes written
+    size_t encode(const TraceRecord& rec, uint8_t* out) noexcept {
+        uint8_t* p = out;
+        uint8_t flags = 0;
+        if (rec.sim_time != prev_time_) flags |= FLAG_TIME;
+        if (rec.translated != rec.address) flags |= FLAG_TRANSLATED;
+        if (rec.length != prev_length_) flags |= FLAG_LENGTH;
+        if (rec.tlb_entry != TRACE_NO_ENTRY) flags |= FLAG_ENTRY;
+        if (rec.route != TRACE_NO_ROUTE) flags |= FLAG_ROUTE;
+        if (rec.aux != 0) flags |= FLAG_AUX;
+
+        *p++ = rec.event;
+        *p++ = flags;
+        *p++ = static_cast<uint8_t>((rec.command & 0x3) | (((rec.response + 5) & 0x7) << 2));
+        if (flags & FLAG_TIME) p = put_varint(p, rec.sim_time - prev_time_);
+        p = put_varint(p, zigzag(rec.address - prev_address_));
+        if (flags & FLAG_TRANSLATED) {
+            p = put_varint(p, zigzag(rec.translated - prev_translated_));
+            prev_translated_ = rec.translated;
+        }
+        if (flags & FLAG_LENGTH) p = put_varint(p, rec.length);
+        if (flags & FLAG_ENTRY) p = put_varint(p, rec.tlb_entry);
+        if (flags & FLAG_ROUTE) *p++ = rec.route;
+        if (flags & FLAG_AUX) p = put_varint(p, rec.aux);
+
+        prev_time_ = rec.sim_time;
+        prev_address_ = rec.address;
+        prev_length_ = rec.length;
+        return static_cast<size_t>(p - out);
+    }
+
+    // Decode one record from [p, end); advances p. Returns false if truncated.
+    bool decode(const uint8_t*& p, const uint8_t* end, TraceRecord& rec) noexcept {
+        const uint8_t* q = p;
+        if (end - q < 3) return false;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.event = *q++;
+        uint8_t flags = *q++;
+        uint8_t status = *q++;
+        rec.command = status & 0x3;
+        rec.response = static_cast<int8_t>(((status >> 2) & 0x7) - 5);
+
+        uint64_t v = 0;
+        rec.sim_time = prev_time_;
+        if (flags & FLAG_TIME) {
+            if (!get_varint(q, end, v)) return false;
+            rec.sim_time += v;
+        }
+        if (!get_varint(q, end, v)) return false;
+        rec.address = prev_address_ + unzigzag(v);
+        uint64_t translated = prev_translated_;
+        rec.translated = rec.address;
+        if (flags & FLAG_TRANSLATED) {
+            if (!get_varint(q, end, v)) return false;
+            translated += unzigzag(v);
+            rec.translated = translated;
+        }
+        rec.length = prev_length_;
+        if (flags & FLAG_LENGTH) {
+            if (!get_varint(q, end, v)) return false;
+            rec.length = static_cast<uint32_t>(v);
+        }
+        rec.tlb_entry = TRACE_NO_ENTRY;
+        if (flags & FLAG_ENTRY) {
+            if (!get_varint(q, end, v)) return false;
+            rec.tlb_entry = static_cast<uint16_t>(v);
+        }
+        rec.route = TRACE_NO_ROUTE;
+        if (flags & FLAG_ROUTE) {
+            if (q >= end) return false;
+            rec.route = *q++;
+        }
+        if (flags & FLAG_AUX) {
+            if (!get_varint(q, end, v)) return false;
+            rec.aux = static_cast<uint32_t>(v);
+        }
+
+        // Commit state only for complete records
+        prev_time_ = rec.sim_time;
+        prev_address_ = rec.address;
+        prev_translated_ = translated;
+        prev_length_ = rec.length;
+        p = q;
+        return true;
+    }
+
+    void reset() noexcept {
+        prev_time_ = prev_address_ = prev_translated_ = 0;
+        prev_length_ = 0;
+    }
+
+private:
+    uint64_t prev_time_ = 0;
+    uint64_t prev_address_ = 0;
+    uint64_t prev_translated_ = 0;
+    uint32_t prev_length_ = 0;
+
+    static uint64_t zigzag(uint64_t delta) noexcept {
+        return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+    }
+    static uint64_t unzigzag(uint64_t v) noexcept {
+        return (v >> 1) ^ (~(v & 1) + 1);
+    }
+    static uint8_t* put_varint(uint8_t* p, uint64_t v) noexcept {
+        while (v >= 0x80) {
+            *p++ = static_cast<uint8_t>(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = static_cast<uint8_t>(v);
+        return p;
+    }
+    static bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) noexcept {
+        v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            uint8_t byte = *p++;
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_TRACE_FORMAT_H
@@ -0,0 +1,115 @@
+#ifndef KERAUNOS_PCIE_TRANSACTION_H
+#define KERAUNOS_PCIE_TRANSACTION_H
+
+// Core transaction, time and AxUSER types (header-only, no SystemC dependency)
+//
+// Every component in libkeraunos_core speaks Transaction/SimTime; the tile
+// converts to and from TLM at its sockets (keraunos_pcie_tlm_adapter.h).
+
+#include <cstdint>
+
+namespace keraunos {
+namespace pcie {
+
+// Simulated time in picoseconds
+using SimTime = uint64_t;
+
+// Current simulated time; supplied by whoever drives the core (the tile
+// installs the SystemC kernel clock)
+using SimClock = SimTime (*)();
+
+// Values match tlm_command / tlm_response_status, so trace records and the
+// TLM adapter convert by cast
+enum class Command : uint8_t {
+    Read = 0,
+    Write = 1,
+    Ignore = 2
+};
+
+enum class Response : int8_t {
+    Ok = 1,
+    Incomplete = 0,
+    GenericError = -1,
+    AddressError = -2,
+    CommandError = -3,
+    BurstError = -4,
+    ByteEnableError = -5
+};
+
+/**
+ * AxUSER sideband (256 bits as eight 32-bit words, word 0 = bits [31:0])
+ * Carries TLB ATTR from the outbound TLBs to NOC-PCIE for BME qualification.
+ */
+class AxUser {
+public:
+    static constexpr int WORDS = 8;
+
+    constexpr AxUser(uint32_t low = 0) noexcept : words_{low, 0, 0, 0, 0, 0, 0, 0} {}
+
+    [[nodiscard]] constexpr uint32_t get_word(int i) const noexcept { return words_[i]; }
+    void set_word(int i, uint32_t value) noexcept { words_[i] = value; }
+    // Bits [31:0], as sc_bv::to_uint()
+    [[nodiscard]] constexpr uint32_t to_uint() const noexcept { return words_[0]; }
+    [[nodiscard]] constexpr bool bit(unsigned i) const noexcept {
+        return (words_[i >> 5] >> (i & 31)) & 1;
+    }
+
+    bool operator==(const AxUser& other) const noexcept {
+        for (int i = 0; i < WORDS; i++) {
+            if (words_[i] != other.words_[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const AxUser& other) const noexcept { return !(*this == other); }
+
+private:
+    uint32_t words_[WORDS];
+};
+
+/**
+ * Transaction
+ * - Memory-mapped access as the core components see it: command, address,
+ *   data buffer (owned by the caller) and response
+ * - Accessors follow tlm_generic_payload naming, so component code reads the
+ *   same with either
+ * - span_id/span_root correlate per-hop spans (keraunos_pcie_span_trace.h);
+ *   0 means none yet
+ * - context is opaque to the core: an adapter keeps the object the
+ *   transaction was made from there (the TLM adapter: the originating payload)
+ */
+struct Transaction {
+    Command command = Command::Ignore;
+    Response response = Response::Incomplete;
+    uint32_t length = 0;
+    uint64_t address = 0;
+    uint8_t* data = nullptr;
+    uint64_t span_id = 0;
+    uint32_t span_root = 0;
+    void* context = nullptr;
+
+    Transaction() = default;
+    Transaction(Command cmd, uint64_t addr, uint8_t* buffer, uint32_t len) noexcept
+        : command(cmd), length(len), address(addr), data(buffer) {}
+
+    [[nodiscard]] Command get_command() const noexcept { return command; }
+    void set_command(Command cmd) noexcept { command = cmd; }
+    [[nodiscard]] bool is_read() const noexcept { return command == Command::Read; }
+    [[nodiscard]] bool is_write() const noexcept { return command == Command::Write; }
+
+    [[nodiscard]] uint64_t get_address() const noexcept { return address; }
+    void set_address(uint64_t addr) noexcept { address = addr; }
+
+    [[nodiscard]] uint8_t* get_data_ptr() const noexcept { return data; }
+    void set_data_ptr(uint8_t* buffer) noexcept { data = buffer; }
+    [[nodiscard]] uint32_t get_data_length() const noexcept { return length; }
+    void set_data_length(uint32_t len) noexcept { length = len; }
+
+    [[nodiscard]] Response get_response_status() const noexcept { return response; }
+    void set_response_status(Response status) noexcept { response = status; }
+    [[nodiscard]] bool is_response_ok() const noexcept { return response == Response::Ok; }
+};
+
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_TRANSACTION_H
@@ -0,0 +1,206 @@
+#include "keraunos_pcie_boot_config.h"
+#include <cstdlib>
+#include <fstream>
+
+namespace keraunos {
+namespace pcie {
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return std::string();
+    const size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+bool parse_u64(const std::string& text, uint64_t& value, uint64_t max = ~0ULL) {
+    if (text.empty() || text[0] == '-') return false;
+    char* end = nullptr;
+    value = std::strtoull(text.c_str(), &end, 0);
+    return *end == '\0' && value <= max;
+}
+
+bool parse_flag(const std::string& text, std::optional<bool>& flag) {
+    uint64_t n = 0;
+    if (!parse_u64(text, n, 1)) return false;
+    flag = (n != 0);
+    return true;
+}
+
+bool parse_byte(const std::string& text, std::optional<uint8_t>& byte) {
+    uint64_t n = 0;
+    if (!parse_u64(text, n, 0xFF)) return false;
+    byte = static_cast<uint8_t>(n);
+    return true;
+}
+
+// Comma separated fields, trimmed
+std::vector<std::string> split_fields(const std::string& text) {
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (true) {
+        const size_t comma = text.find(',', pos);
+        fields.push_back(trim(text.substr(pos, comma - pos)));
+        if (comma == std::string::npos) return fields;
+        pos = comma + 1;
+    }
+}
+
+struct TlbName {
+    const char* name;
+    BootConfig::Tlb tlb;
+    unsigned entries;
+};
+
+constexpr TlbName TLB_NAMES[] = {
+    {"sys_in0", BootConfig::Tlb::SysIn0, 64},
+    {"app_in0_0", BootConfig::Tlb::AppIn0_0, 64},
+    {"app_in0_1", BootConfig::Tlb::AppIn0_1, 64},
+    {"app_in0_2", BootConfig::Tlb::AppIn0_2, 64},
+    {"app_in0_3", BootConfig::Tlb::AppIn0_3, 64},
+    {"app_in1", BootConfig::Tlb::AppIn1, 64},
+    {"sys_out0", BootConfig::Tlb::SysOut0, 16},
+    {"app_out0", BootConfig::Tlb::AppOut0, 16},
+    {"app_out1", BootConfig::Tlb::AppOut1, 16},
+};
+
+bool parse_tile_key(const std::string& key, const std::string& value, BootConfig& config) {
+    if (key == "system_ready") return parse_flag(value, config.system_ready);
+    if (key == "outbound_app_enable") return parse_flag(value, config.outbound_app_enable);
+    if (key == "inbound_app_enable") return parse_flag(value, config.inbound_app_enable);
+    if (key == "bus_num") return parse_byte(value, config.bus_num);
+    if (key == "dev_num") return parse_byte(value, config.dev_num);
+    if (key == "bus_master_enable") return parse_flag(value, config.bus_master_enable);
+    if (key == "msix_enable") return parse_flag(value, config.msix_enable);
+    if (key == "msix_mask") return parse_flag(value, config.msix_mask);
+    if (key == "device_type") {
+        if (value != "ep" && value != "rp") return false;
+        config.device_type_rp = (value == "rp");
+        return true;
+    }
+    return false;
+}
+
+bool parse_tlb_entry(const TlbName& tlb, const std::string& key, const std::string& value,
+                     BootConfig& config) {
+    uint64_t index = 0, addr = 0, attr = 0;
+    const std::vector<std::string> fields = split_fields(value);
+    if (!parse_u64(key, index, tlb.entries - 1) || fields.size() > 2 ||
+        !parse_u64(fields[0], addr) ||
+        (fields.size() == 2 && !parse_u64(fields[1], attr, 0xFFFFFFFFULL))) {
+        return false;
+    }
+    config.tlb_windows.push_back({tlb.tlb, static_cast<uint8_t>(index), addr, static_cast<uint32_t>(attr)});
+    return true;
+}
+
+bool parse_msix_vector(uint8_t pf, const std::string& key, const std::string& value, BootConfig& config) {
+    uint64_t index = 0, address = 0, data = 0, masked = 0;
+    const std::vector<std::string> fields = split_fields(value);
+    if (!parse_u64(key, index, MSI_RELAY_MAX_VECTORS - 1) || fields.size() < 2 || fields.size() > 3 ||
+        !parse_u64(fields[0], address) || !parse_u64(fields[1], data, 0xFFFFFFFFULL) ||
+        (fields.size() == 3 && !parse_u64(fields[2], masked, 1))) {
+        return false;
+    }
+    config.msix_vectors.push_back({pf, static_cast<uint16_t>(index), address,
+                                   static_cast<uint32_t>(data), masked != 0});
+    return true;
+}
+
+} // namespace
+
+bool parse_boot_config(std::istream& in, BootConfig& config, std::string& error) {
+    enum class Section { None, Tile, Tlb, Msix } section = Section::None;
+    const TlbName* tlb = nullptr;
+    uint8_t pf = 0;
+    std::string line;
+    for (unsigned number = 1; std::getline(in, line); number++) {
+        const size_t comment = line.find_first_of(";#");
+        if (comment != std::string::npos) line.erase(comment);
+        line = trim(line);
+        if (line.empty()) continue;
+        const std::string where = "line " + std::to_string(number) + ": ";
+
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                error = where + "unterminated section header";
+                return false;
+            }
+            const std::string name = trim(line.substr(1, line.size() - 2));
+            uint64_t n = 0;
+            section = Section::None;
+            if (name == "tile") {
+                section = Section::Tile;
+            } else if (name.compare(0, 4, "tlb.") == 0) {
+                for (const TlbName& candidate : TLB_NAMES) {
+                    if (name.compare(4, std::string::npos, candidate.name) == 0) {
+                        tlb = &candidate;
+                        section = Section::Tlb;
+                    }
+                }
+            } else if (name.compare(0, 7, "msix.pf") == 0 &&
+                       parse_u64(name.substr(7), n, MSI_RELAY_NUM_PFS - 1)) {
+                pf = static_cast<uint8_t>(n);
+                section = Section::Msix;
+            }
+            if (section == Section::None) {
+                error = where + "unknown section [" + name + "]";
+                return false;
+            }
+            continue;
+        }
+
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos || section == Section::None) {
+            error = where + (section == Section::None ? "key outside a section" : "expected key = value");
+            return false;
+        }
+        const std::string key = trim(line.substr(0, eq));
+        const std::string value = trim(line.substr(eq + 1));
+        bool ok = false;
+        switch (section) {
+        case Section::Tile:
+            ok = parse_tile_key(key, value, config);
+            break;
+        case Section::Tlb:
+            ok = parse_tlb_entry(*tlb, key, value, config);
+            break;
+        case Section::Msix:
+            ok = parse_msix_vector(pf, key, value, config);
+            break;
+        case Section::None:
+            break;
+        }
+        if (!ok) {
+            error = where + "bad entry '" + key + " = " + value + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check_boot_config(const BootConfig& config, uint8_t num_pfs, uint16_t vectors_per_pf,
+                       std::string& error) {
+    for (const BootConfig::MsixVector& vector : config.msix_vectors) {
+        if (vector.pf >= num_pfs || vector.index >= vectors_per_pf) {
+            error = "msix.pf" + std::to_string(vector.pf) + " vector " + std::to_string(vector.index) +
+                    ": relay has " + std::to_string(num_pfs) + " PFs of " +
+                    std::to_string(vectors_per_pf) + " vectors";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool load_boot_config(const std::string& path, BootConfig& config, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    return parse_boot_config(in, config, error);
+}
+
+} // namespace pcie
+} // namespace keraunos
@@ -15,5 +15,28 @@ void ClockResetControl::update_resets() noexcept {
     force_to_ref_clk_n_ = !isolate_req_;
 }
 
+void ClockResetControl::save_state(CheckpointWriter& out) const {
+    out.put_flag(cold_reset_n_);
+    out.put_flag(warm_reset_n_);
+    out.put_flag(isolate_req_);
+    out.put_flag(pcie_sii_reset_ctrl_);
+    out.put_flag(pcie_reset_ctrl_);
+    out.put_flag(force_to_ref_clk_n_);
+    out.put_flag(pcie_clock_);
+    out.put_flag(ref_clock_);
+}
+
+bool ClockResetControl::restore_state(CheckpointReader& in) {
+    cold_reset_n_ = in.get_flag();
+    warm_reset_n_ = in.get_flag();
+    isolate_req_ = in.get_flag();
+    pcie_sii_reset_ctrl_ = in.get_flag();
+    pcie_reset_ctrl_ = in.get_flag();
+    force_to_ref_clk_n_ = in.get_flag();
+    pcie_clock_ = in.get_flag();
+    ref_clock_ = in.get_flag();
+    return in.ok();
+}
+
 } // namespace pcie
 } // namespace keraunos
@@ -9,22 +9,30 @@ ConfigRegBlock::ConfigRegBlock()
     , pcie_outbound_app_enable_(true)
     , pcie_inbound_app_enable_(true)
     , isolate_req_(false)
-    , config_memory_("config_memory", 64 * 1024)  // 64KB with SCML2 memory
+    , config_memory_(reset_image())
     , change_callback_(nullptr)
 {
-    // Initialize registers with default values using array notation
-    config_memory_[SYSTEM_READY_OFFSET] = 1;  // system_ready = true
-    config_memory_[PCIE_ENABLE_OFFSET] = 1;   // outbound enable
-    config_memory_[PCIE_ENABLE_OFFSET + 2] = 1;  // inbound enable (bit 16)
 }
 
-void ConfigRegBlock::process_apb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+// Register defaults, built once and shared copy-on-write by every instance
+const std::shared_ptr<const SparseRegisterStore>& ConfigRegBlock::reset_image() {
+    static const std::shared_ptr<const SparseRegisterStore> image = [] {
+        auto regs = std::make_shared<SparseRegisterStore>(64 * 1024);
+        regs->set(SYSTEM_READY_OFFSET, 1);      // system_ready = true
+        regs->set(PCIE_ENABLE_OFFSET, 1);       // outbound enable
+        regs->set(PCIE_ENABLE_OFFSET + 2, 1);   // inbound enable (bit 16)
+        return regs;
+    }();
+    return image;
+}
+
+void ConfigRegBlock::process_apb_access(Transaction& trans, SimTime& delay) {
+    if (trans.get_command() == Command::Read) {
         process_read(trans, delay);
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         process_write(trans, delay);
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
@@ -41,17 +49,36 @@ void ConfigRegBlock::set_isolate_req(const bool isolate) noexcept {
     }
 }
 
-void ConfigRegBlock::process_read(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void ConfigRegBlock::set_control(bool system_ready, bool outbound_app_enable, bool inbound_app_enable) {
+    system_ready_ = system_ready;
+    pcie_outbound_app_enable_ = outbound_app_enable;
+    pcie_inbound_app_enable_ = inbound_app_enable;
+    config_memory_.write32(SYSTEM_READY_OFFSET, system_ready ? 1 : 0);
+    config_memory_.write32(PCIE_ENABLE_OFFSET, (outbound_app_enable ? 0x1 : 0) | (inbound_app_enable ? 0x10000 : 0));
+    if (change_callback_) {
+        change_callback_();
+    }
+}
+
+void ConfigRegBlock::reset() {
+    system_ready_ = true;
+    pcie_outbound_app_enable_ = true;
+    pcie_inbound_app_enable_ = true;
+    config_memory_.reset();
+    if (change_callback_) {
+        change_callback_();
+    }
+}
+
+void ConfigRegBlock::process_read(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    // Read from SCML2 memory using subscript operator
+    // Read from the sparse register store
     if (offset + len <= config_memory_.get_size()) {
-        for (uint32_t i = 0; i < len; i++) {
-            data_ptr[i] = config_memory_[offset + i];
-        }
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        config_memory_.read(offset, data_ptr, len);
+        trans.set_response_status(Response::Ok);
         
         // Update from internal state for control registers
         if (offset == SYSTEM_READY_OFFSET && len >= 4) {
@@ -62,22 +89,20 @@ void ConfigRegBlock::process_read(tlm::tlm_generic_payload& trans, sc_core::sc_t
             *val_ptr = (pcie_outbound_app_enable_ ? 0x1 : 0) | (pcie_inbound_app_enable_ ? 0x10000 : 0);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
 }
 
-void ConfigRegBlock::process_write(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void ConfigRegBlock::process_write(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
     
-    // Write to SCML2 memory using subscript operator
+    // Write to the sparse register store
     if (offset + len <= config_memory_.get_size()) {
-        for (uint32_t i = 0; i < len; i++) {
-            config_memory_[offset + i] = data_ptr[i];
-        }
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        config_memory_.write(offset, data_ptr, len);
+        trans.set_response_status(Response::Ok);
         
         // Update internal state for control registers
         bool config_changed = false;
@@ -97,9 +122,25 @@ void ConfigRegBlock::process_write(tlm::tlm_generic_payload& trans, sc_core::sc_
             change_callback_();
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
 }
 
+void ConfigRegBlock::save_state(CheckpointWriter& out) const {
+    out.put_flag(system_ready_);
+    out.put_flag(pcie_outbound_app_enable_);
+    out.put_flag(pcie_inbound_app_enable_);
+    out.put_flag(isolate_req_);
+    config_memory_.save_state(out);
+}
+
+bool ConfigRegBlock::restore_state(CheckpointReader& in) {
+    system_ready_ = in.get_flag();
+    pcie_outbound_app_enable_ = in.get_flag();
+    pcie_inbound_app_enable_ = in.get_flag();
+    isolate_req_ = in.get_flag();
+    return config_memory_.restore_state(in);
+}
+
 } // namespace pcie
 } // namespace keraunos
@@ -4,33 +4,48 @@
 namespace keraunos {
 namespace pcie {
 
+namespace {
+
+// Reset images, one per TLB type, shared by every instance: entry 0 valid
+// for basic testing
+const std::shared_ptr<const TlbTable::Image>& sys_in0_reset_image() {
+    static const auto image = make_tlb_reset_image(64, 0x80000000, 0x100);
+    return image;
+}
+
+const std::shared_ptr<const TlbTable::Image>& app_in0_reset_image() {
+    static const auto image = make_tlb_reset_image(64, 0x80000000, 0x100);
+    return image;
+}
+
+// Base must be 8GB-aligned (bits[63:33] populated) for 33-bit page TLB
+const std::shared_ptr<const TlbTable::Image>& app_in1_reset_image() {
+    static const auto image = make_tlb_reset_image(64, 0x200000000ULL, 0x200);
+    return image;
+}
+
+} // namespace
+
 // TLBSysIn0
-TLBSysIn0::TLBSysIn0() : entries_(64), system_ready_(true), tlb_memory_("tlb_sys_in0_memory", 4096) {
-    // Initialize entry 0 as valid for basic testing
-    entries_[0].valid = true;
-    entries_[0].addr = 0x80000000 >> 12;  // Physical address
-    entries_[0].attr = 0x100;
+TLBSysIn0::TLBSysIn0()
+    : entries_(sys_in0_reset_image()), tracer_(&Tracer::disabled()), system_ready_(true), tlb_memory_(4096) {
 }
 
-void TLBSysIn0::process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBSysIn0::process_config_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = tlb_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            tlb_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                tlb_memory_[offset + i] = data_ptr[i];
-            }
+            tlb_memory_.write(offset, data_ptr, len);
             
             // CRITICAL FIX: Parse memory writes and update entries_ vector
             uint8_t entry_index = offset / 64;
@@ -38,31 +53,30 @@ void TLBSysIn0::process_config_access(tlm::tlm_generic_payload& trans, sc_core::
             
             if (entry_index < entries_.size()) {
                 if (entry_offset < 8) {
-                    uint32_t lower = 0, upper = 0;
-                    for (int b = 0; b < 4; b++) lower |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + b]) << (b * 8);
-                    for (int b = 0; b < 4; b++) upper |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + 4 + b]) << (b * 8);
+                    uint32_t lower = tlb_memory_.read32(entry_index * 64);
+                    uint32_t upper = tlb_memory_.read32(entry_index * 64 + 4);
                     
-                    entries_[entry_index].valid = (lower & 0x1) != 0;
-                    entries_[entry_index].addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
-                    entries_[entry_index].addr >>= 12;
+                    entries_.mutate(entry_index).valid = (lower & 0x1) != 0;
+                    entries_.mutate(entry_index).addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
+                    entries_.mutate(entry_index).addr >>= 12;
                 } else if (entry_offset == 32 && len == 4) {
                     uint32_t attr_val = *reinterpret_cast<uint32_t*>(data_ptr);
-                    entries_[entry_index].attr = attr_val;
+                    entries_.mutate(entry_index).attr = attr_val;
                 }
             }
             
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
-void TLBSysIn0::process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBSysIn0::process_inbound_traffic(Transaction& trans, SimTime& delay) {
     uint64_t iatu_addr = trans.get_address();
-    uint64_t translated_addr;
+    uint64_t translated_addr = iatu_addr;
     uint32_t axuser;
     
     if (lookup(iatu_addr, translated_addr, axuser)) {
@@ -70,11 +84,13 @@ void TLBSysIn0::process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core
         if (translated_output_) {
             translated_output_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
+    KERAUNOS_TRACE(*tracer_, TraceEvent::TlbSysIn0, trans, iatu_addr, translated_addr,
+                   calculate_index(iatu_addr));
 }
 
 bool TLBSysIn0::lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t& axuser) {
@@ -94,47 +110,59 @@ bool TLBSysIn0::lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t&
 }
 
 void TLBSysIn0::configure_entry(uint8_t index, const TlbEntry& entry) {
-    if (index < entries_.size()) entries_[index] = entry;
+    if (index < entries_.size()) {
+        entries_.mutate(index) = entry;
+        store_tlb_entry(tlb_memory_, index, entry);
+    }
 }
 
 TlbEntry TLBSysIn0::get_entry(uint8_t index) const {
     return (index < entries_.size()) ? entries_[index] : TlbEntry();
 }
 
+void TLBSysIn0::reset() {
+    entries_.reset();
+    tlb_memory_.reset();
+}
+
+void TLBSysIn0::save_state(CheckpointWriter& out) const {
+    out.put_flag(system_ready_);
+    save_tlb_table(out, entries_);
+    tlb_memory_.save_state(out);
+}
+
+bool TLBSysIn0::restore_state(CheckpointReader& in) {
+    system_ready_ = in.get_flag();
+    restore_tlb_table(in, entries_);
+    return tlb_memory_.restore_state(in);
+}
+
 uint8_t TLBSysIn0::calculate_index(uint64_t addr) const {
     return static_cast<uint8_t>((addr >> 14) & 0x3F);
 }
 
 // TLBAppIn0
 TLBAppIn0::TLBAppIn0(uint8_t instance_id) 
-    : instance_id_(instance_id), entries_(64)
-    , tlb_memory_(std::string("tlb_app_in0_") + std::to_string(instance_id) + "_memory", 4096)
+    : instance_id_(instance_id), entries_(app_in0_reset_image()), tracer_(&Tracer::disabled())
+    , tlb_memory_(4096)
 {
-    // Initialize entry 0 as valid for basic testing
-    entries_[0].valid = true;
-    entries_[0].addr = 0x80000000 >> 12;
-    entries_[0].attr = 0x100;
 }
 
-void TLBAppIn0::process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppIn0::process_config_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = tlb_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            tlb_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                tlb_memory_[offset + i] = data_ptr[i];
-            }
+            tlb_memory_.write(offset, data_ptr, len);
             
             // CRITICAL FIX: Parse memory writes and update entries_ vector
             // TLB entry format: 64 bytes per entry
@@ -148,32 +176,31 @@ void TLBAppIn0::process_config_access(tlm::tlm_generic_payload& trans, sc_core::
                 // Check if this write affects entry fields we care about
                 if (entry_offset < 8) {
                     // Address fields being written - reconstruct full entry
-                    uint32_t lower = 0, upper = 0;
-                    for (int b = 0; b < 4; b++) lower |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + b]) << (b * 8);
-                    for (int b = 0; b < 4; b++) upper |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + 4 + b]) << (b * 8);
+                    uint32_t lower = tlb_memory_.read32(entry_index * 64);
+                    uint32_t upper = tlb_memory_.read32(entry_index * 64 + 4);
                     
-                    entries_[entry_index].valid = (lower & 0x1) != 0;
-                    entries_[entry_index].addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
-                    entries_[entry_index].addr >>= 12;  // Store as shifted value
+                    entries_.mutate(entry_index).valid = (lower & 0x1) != 0;
+                    entries_.mutate(entry_index).addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
+                    entries_.mutate(entry_index).addr >>= 12;  // Store as shifted value
                 } else if (entry_offset == 32 && len == 4) {
                     // Attributes being written
                     uint32_t attr_val = *reinterpret_cast<uint32_t*>(data_ptr);
-                    entries_[entry_index].attr = attr_val;
+                    entries_.mutate(entry_index).attr = attr_val;
                 }
             }
             
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
-void TLBAppIn0::process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppIn0::process_inbound_traffic(Transaction& trans, SimTime& delay) {
     uint64_t iatu_addr = trans.get_address();
-    uint64_t translated_addr;
+    uint64_t translated_addr = iatu_addr;
     uint32_t axuser;
     
     if (lookup(iatu_addr, translated_addr, axuser)) {
@@ -181,11 +208,13 @@ void TLBAppIn0::process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core
         if (translated_output_) {
             translated_output_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
+    KERAUNOS_TRACE(*tracer_, TraceEvent::TlbAppIn0, trans, iatu_addr, translated_addr,
+                   calculate_index(iatu_addr), TRACE_NO_ROUTE, instance_id_);
 }
 
 bool TLBAppIn0::lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t& axuser) {
@@ -204,10 +233,10 @@ bool TLBAppIn0::lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t&
 
 void TLBAppIn0::configure_entry(uint8_t index, const TlbEntry& entry) {
     if (index < entries_.size()) {
-        entries_[index] = entry;
-        // #region agent log
-        {std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug.log",std::ios::app);f<<"{\"location\":\"keraunos_pcie_inbound_tlb.cpp:150\",\"message\":\"TLB App In0 configured\",\"data\":{\"index\":"<<(int)index<<",\"addr\":\"0x"<<std::hex<<entry.addr<<std::dec<<"\",\"valid\":"<<(entry.valid?"true":"false")<<",\"attr\":"<<entry.attr.to_uint()<<"},\"timestamp\":"<<sc_core::sc_time_stamp().value()<<",\"hypothesisId\":\"B\"}\n";}
-        // #endregion
+        entries_.mutate(index) = entry;
+        store_tlb_entry(tlb_memory_, index, entry);
+        KERAUNOS_TRACE(*tracer_, TraceEvent::TlbAppIn0Configure, entry.addr,
+                       (entry.attr.to_uint() & 0x7FFFFFFFu) | (entry.valid ? 0x80000000u : 0u), index);
     }
 }
 
@@ -215,38 +244,44 @@ TlbEntry TLBAppIn0::get_entry(uint8_t index) const {
     return (index < entries_.size()) ? entries_[index] : TlbEntry();
 }
 
+void TLBAppIn0::reset() {
+    entries_.reset();
+    tlb_memory_.reset();
+}
+
+void TLBAppIn0::save_state(CheckpointWriter& out) const {
+    save_tlb_table(out, entries_);
+    tlb_memory_.save_state(out);
+}
+
+bool TLBAppIn0::restore_state(CheckpointReader& in) {
+    restore_tlb_table(in, entries_);
+    return tlb_memory_.restore_state(in);
+}
+
 uint8_t TLBAppIn0::calculate_index(uint64_t addr) const {
     return static_cast<uint8_t>((addr >> 24) & 0x3F);
 }
 
 // TLBAppIn1
-TLBAppIn1::TLBAppIn1() : entries_(64), tlb_memory_("tlb_app_in1_memory", 4096) {
-    // Initialize entry 0 as valid
-    // Base must be 8GB-aligned (bits[63:33] populated) for 33-bit page TLB
-    entries_[0].valid = true;
-    entries_[0].addr = 0x200000000ULL >> 12;
-    entries_[0].attr = 0x200;
+TLBAppIn1::TLBAppIn1() : entries_(app_in1_reset_image()), tracer_(&Tracer::disabled()), tlb_memory_(4096) {
 }
 
-void TLBAppIn1::process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppIn1::process_config_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = tlb_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            tlb_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                tlb_memory_[offset + i] = data_ptr[i];
-            }
+            tlb_memory_.write(offset, data_ptr, len);
             
             // CRITICAL FIX: Parse memory writes and update entries_ vector
             uint8_t entry_index = offset / 64;
@@ -254,31 +289,30 @@ void TLBAppIn1::process_config_access(tlm::tlm_generic_payload& trans, sc_core::
             
             if (entry_index < entries_.size()) {
                 if (entry_offset < 8) {
-                    uint32_t lower = 0, upper = 0;
-                    for (int b = 0; b < 4; b++) lower |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + b]) << (b * 8);
-                    for (int b = 0; b < 4; b++) upper |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + 4 + b]) << (b * 8);
+                    uint32_t lower = tlb_memory_.read32(entry_index * 64);
+                    uint32_t upper = tlb_memory_.read32(entry_index * 64 + 4);
                     
-                    entries_[entry_index].valid = (lower & 0x1) != 0;
-                    entries_[entry_index].addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
-                    entries_[entry_index].addr >>= 12;
+                    entries_.mutate(entry_index).valid = (lower & 0x1) != 0;
+                    entries_.mutate(entry_index).addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
+                    entries_.mutate(entry_index).addr >>= 12;
                 } else if (entry_offset == 32 && len == 4) {
                     uint32_t attr_val = *reinterpret_cast<uint32_t*>(data_ptr);
-                    entries_[entry_index].attr = attr_val;
+                    entries_.mutate(entry_index).attr = attr_val;
                 }
             }
             
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
-void TLBAppIn1::process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppIn1::process_inbound_traffic(Transaction& trans, SimTime& delay) {
     uint64_t iatu_addr = trans.get_address();
-    uint64_t translated_addr;
+    uint64_t translated_addr = iatu_addr;
     uint32_t axuser;
     
     if (lookup(iatu_addr, translated_addr, axuser)) {
@@ -286,11 +320,13 @@ void TLBAppIn1::process_inbound_traffic(tlm::tlm_generic_payload& trans, sc_core
         if (translated_output_) {
             translated_output_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
+    KERAUNOS_TRACE(*tracer_, TraceEvent::TlbAppIn1, trans, iatu_addr, translated_addr,
+                   calculate_index(iatu_addr));
 }
 
 bool TLBAppIn1::lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t& axuser) {
@@ -308,13 +344,31 @@ bool TLBAppIn1::lookup(uint64_t iatu_addr, uint64_t& translated_addr, uint32_t&
 }
 
 void TLBAppIn1::configure_entry(uint8_t index, const TlbEntry& entry) {
-    if (index < entries_.size()) entries_[index] = entry;
+    if (index < entries_.size()) {
+        entries_.mutate(index) = entry;
+        store_tlb_entry(tlb_memory_, index, entry);
+    }
 }
 
 TlbEntry TLBAppIn1::get_entry(uint8_t index) const {
     return (index < entries_.size()) ? entries_[index] : TlbEntry();
 }
 
+void TLBAppIn1::reset() {
+    entries_.reset();
+    tlb_memory_.reset();
+}
+
+void TLBAppIn1::save_state(CheckpointWriter& out) const {
+    save_tlb_table(out, entries_);
+    tlb_memory_.save_state(out);
+}
+
+bool TLBAppIn1::restore_state(CheckpointReader& in) {
+    restore_tlb_table(in, entries_);
+    return tlb_memory_.restore_state(in);
+}
+
 uint8_t TLBAppIn1::calculate_index(uint64_t addr) const {
     return static_cast<uint8_t>((addr >> 33) & 0x3F);
 }
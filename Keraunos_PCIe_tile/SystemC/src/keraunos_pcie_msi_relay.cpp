@@ -1,50 +1,87 @@
 #include "keraunos_pcie_msi_relay.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
 namespace keraunos {
 namespace pcie {
 
-MsiRelayUnit::MsiRelayUnit(uint8_t num_vectors)
-    : num_vectors_(num_vectors)
-    , msix_table_(num_vectors)
-    , msix_pba_(0)
-    , msi_outstanding_(0)
-    , msix_enable_(false)
-    , msix_mask_(false)
+MsiRelayUnit::FunctionState::FunctionState(uint16_t vectors)
+    : address(vectors)
+    , data(vectors)
+    , pba(vectors)
+    , masked(vectors)
+    , valid_addr(vectors)
+    , min_interval(vectors)
+    , coalesce_count(vectors)
+    , request_count(vectors)
+    , holdoff_until(vectors)
+    , held(vectors)
+    , count_ready(vectors)
+    , queued(vectors)
+    , deliverable(vectors)
+    , msix_enable(false)
+    , msix_mask(false)
+    , table_page(0)
+    , coalesced(0)
+{
+    masked.set_all();  // Vectors come out of reset masked
+}
+
+MsiRelayUnit::MsiRelayUnit(uint16_t vectors_per_pf, uint8_t num_pfs)
+    : vectors_per_pf_(std::min<uint16_t>(std::max<uint16_t>(vectors_per_pf, 1), MSI_RELAY_MAX_VECTORS))
+    , num_pfs_(std::min<uint8_t>(std::max<uint8_t>(num_pfs, 1), MSI_RELAY_NUM_PFS))
+    , now_tick_(0)
+    , egress_depth_(MSI_EGRESS_DEFAULT_DEPTH)
+    , max_outstanding_(MSI_EGRESS_DEFAULT_OUTSTANDING)
+    , backpressure_count_(0)
+    , delivery_pass_count_(0)
+    , delivering_(false)
+    , deliverable_pfs_(0)
     , setip_(0)
     , msi_output_callback_(nullptr)
 {
-    for (auto& entry : msix_table_) {
-        entry.address = 0;
-        entry.data = 0;
-        entry.mask = true;
+    functions_.reserve(num_pfs_);
+    for (uint8_t pf = 0; pf < num_pfs_; pf++) {
+        functions_.emplace_back(vectors_per_pf_);
     }
 }
 
-void MsiRelayUnit::process_csr_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
-        process_csr_read(trans, delay);
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
-        process_csr_write(trans, delay);
+void MsiRelayUnit::process_csr_access(Transaction& trans, SimTime& delay) {
+    if (trans.get_command() != Command::Read && trans.get_command() != Command::Write) {
+        trans.set_response_status(Response::CommandError);
+        return;
+    }
+    // offset[17:14] selects the PF window; unpopulated windows decode-error
+    // for reads and writes alike
+    uint32_t offset = static_cast<uint32_t>(trans.get_address());
+    uint32_t pf = offset >> MSI_RELAY_PF_SHIFT;
+    uint32_t local = offset & (MSI_RELAY_PF_WINDOW - 1);
+    if (pf >= num_pfs_) {
+        trans.set_response_status(Response::AddressError);
+        return;
+    }
+    if (trans.get_command() == Command::Read) {
+        process_csr_read(trans, static_cast<uint8_t>(pf), local);
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        process_csr_write(trans, static_cast<uint8_t>(pf), local);
     }
 }
 
-void MsiRelayUnit::process_msi_input(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void MsiRelayUnit::process_msi_input(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
+    uint32_t pf = offset >> MSI_RELAY_PF_SHIFT;
+    uint32_t local = offset & (MSI_RELAY_PF_WINDOW - 1);
     
-    if (trans.get_command() == tlm::TLM_WRITE_COMMAND && offset == 0) {
+    if (trans.get_command() == Command::Write && local == 0 && pf < num_pfs_) {
         uint32_t* data_ptr = reinterpret_cast<uint32_t*>(trans.get_data_ptr());
-        write_msi_receiver(*data_ptr);
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
-    } else if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+        trans.set_response_status(write_msi_receiver(*data_ptr, static_cast<uint8_t>(pf)));
+    } else if (trans.get_command() == Command::Read) {
         uint32_t* data_ptr = reinterpret_cast<uint32_t*>(trans.get_data_ptr());
         *data_ptr = 0;
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
 }
 
@@ -52,38 +89,83 @@ void MsiRelayUnit::set_msi_output_callback(TransportCallback callback) {
     msi_output_callback_ = callback;
 }
 
-void MsiRelayUnit::set_msix_enable(bool enable) { msix_enable_ = enable; }
-void MsiRelayUnit::set_msix_mask(bool mask) { msix_mask_ = mask; }
+void MsiRelayUnit::set_msix_enable(bool enable) {
+    for (uint8_t pf = 0; pf < num_pfs_; pf++) {
+        set_msix_enable(pf, enable);
+    }
+}
+
+void MsiRelayUnit::set_msix_mask(bool mask) {
+    for (uint8_t pf = 0; pf < num_pfs_; pf++) {
+        set_msix_mask(pf, mask);
+    }
+}
+
+void MsiRelayUnit::set_msix_enable(uint8_t pf, bool enable) {
+    if (pf < num_pfs_ && functions_[pf].msix_enable != enable) {
+        functions_[pf].msix_enable = enable;
+        update_deliverable_function(pf);
+    }
+}
+
+void MsiRelayUnit::set_msix_mask(uint8_t pf, bool mask) {
+    if (pf < num_pfs_ && functions_[pf].msix_mask != mask) {
+        functions_[pf].msix_mask = mask;
+        update_deliverable_function(pf);
+    }
+}
+
 void MsiRelayUnit::set_interrupt_pending(uint16_t setip_bits) { setip_ = setip_bits; }
 
-void MsiRelayUnit::write_msi_receiver(uint32_t data) {
-    uint8_t vector_index = data & 0xFFFF;
-    if (vector_index < num_vectors_) {
-        set_pba_bit(vector_index);
+Response MsiRelayUnit::write_msi_receiver(uint32_t data, uint8_t pf) {
+    uint16_t vector_index = static_cast<uint16_t>(data & 0xFFFF);
+    if (pf >= num_pfs_ || vector_index >= vectors_per_pf_) {
+        return Response::AddressError;  // No such vector: never backpressure
+    }
+    // A request for a vector already pending folds into its PBA bit and
+    // needs no FIFO slot, so only new requests see backpressure
+    if (get_egress_occupancy() >= egress_depth_ && !is_pending(pf, vector_index)) {
+        backpressure_count_++;
+        return Response::GenericError;  // Egress full: retry
     }
+    FunctionState& fn = functions_[pf];
+    uint16_t& count = fn.request_count.mutate(vector_index);
+    if (count != 0xFFFF) count++;
+    if (fn.coalesce_count[vector_index] != 0 && count >= fn.coalesce_count[vector_index]) {
+        fn.count_ready.set(vector_index);
+    }
+    set_pba_bit(pf, vector_index);
+    return Response::Ok;
 }
 
 uint32_t MsiRelayUnit::read_msi_outstanding() const {
-    return msi_outstanding_;
+    return static_cast<uint32_t>(get_egress_occupancy());
 }
 
-uint32_t MsiRelayUnit::read_msix_pba() const {
-    return static_cast<uint32_t>(msix_pba_);
+uint32_t MsiRelayUnit::read_msix_pba(uint8_t pf, uint16_t dword) const {
+    if (pf >= num_pfs_ || dword >= (vectors_per_pf_ + 31) / 32) {
+        return 0;
+    }
+    uint64_t word = functions_[pf].pba.word(dword / 2);
+    return static_cast<uint32_t>(word >> ((dword & 1) * 32));
 }
 
-void MsiRelayUnit::write_msix_table(uint8_t index, uint64_t address, uint32_t data, bool mask) {
-    if (index < num_vectors_) {
-        msix_table_[index].address = address;
-        msix_table_[index].data = data;
-        msix_table_[index].mask = mask;
+void MsiRelayUnit::write_msix_table(uint16_t index, uint64_t address, uint32_t data, bool mask, uint8_t pf) {
+    if (pf < num_pfs_ && index < vectors_per_pf_) {
+        FunctionState& fn = functions_[pf];
+        fn.address.mutate(index) = address;
+        fn.data.mutate(index) = data;
+        fn.masked.assign(index, mask);
+        update_vector_state(pf, index);
     }
 }
 
-void MsiRelayUnit::read_msix_table(uint8_t index, uint64_t& address, uint32_t& data, bool& mask) const {
-    if (index < num_vectors_) {
-        address = msix_table_[index].address;
-        data = msix_table_[index].data;
-        mask = msix_table_[index].mask;
+void MsiRelayUnit::read_msix_table(uint16_t index, uint64_t& address, uint32_t& data, bool& mask, uint8_t pf) const {
+    if (pf < num_pfs_ && index < vectors_per_pf_) {
+        const FunctionState& fn = functions_[pf];
+        address = fn.address[index];
+        data = fn.data[index];
+        mask = fn.masked.test(index);
     } else {
         address = 0;
         data = 0;
@@ -91,133 +173,486 @@ void MsiRelayUnit::read_msix_table(uint8_t index, uint64_t& address, uint32_t& d
     }
 }
 
-void MsiRelayUnit::process_pending_msis() {
-    for (uint8_t i = 0; i < num_vectors_; i++) {
-        if (is_msi_allowed(i)) {
-            send_msi(i);
-            break;
+void MsiRelayUnit::set_moderation(uint16_t index, uint32_t min_interval, uint8_t coalesce_count, uint8_t pf) {
+    if (pf < num_pfs_ && index < vectors_per_pf_) {
+        FunctionState& fn = functions_[pf];
+        fn.min_interval.mutate(index) = min_interval & MSIX_MODERATION_INTERVAL_MASK;
+        fn.coalesce_count.mutate(index) = coalesce_count;
+        fn.count_ready.assign(index, coalesce_count != 0 && fn.request_count[index] >= coalesce_count);
+        if (fn.min_interval[index] == 0) {
+            fn.held.clear(index);  // Moderation off: end any running holdoff
         }
+        update_deliverable_bit(pf, index);
+    }
+}
+
+uint32_t MsiRelayUnit::read_moderation(uint16_t index, uint8_t pf) const {
+    if (pf >= num_pfs_ || index >= vectors_per_pf_) {
+        return 0;
     }
+    const FunctionState& fn = functions_[pf];
+    return fn.min_interval[index] |
+           (static_cast<uint32_t>(fn.coalesce_count[index]) << MSIX_MODERATION_COUNT_SHIFT);
 }
 
-void MsiRelayUnit::set_pba_bit(uint8_t index) {
-    if (index < num_vectors_) {
-        msix_pba_ |= (1 << index);
+uint64_t MsiRelayUnit::get_coalesced_count(uint8_t pf) const noexcept {
+    return pf < num_pfs_ ? functions_[pf].coalesced : 0;
+}
+
+uint64_t MsiRelayUnit::get_coalesced_count() const noexcept {
+    uint64_t total = 0;
+    for (const auto& fn : functions_) {
+        total += fn.coalesced;
     }
+    return total;
+}
+
+void MsiRelayUnit::set_egress_limits(uint16_t depth, uint16_t max_outstanding) {
+    egress_depth_ = std::max<uint16_t>(depth, 1);
+    max_outstanding_ = std::min<uint16_t>(std::max<uint16_t>(max_outstanding, 1), egress_depth_);
 }
 
-void MsiRelayUnit::clear_pba_bit(uint8_t index) {
-    if (index < num_vectors_) {
-        msix_pba_ &= ~(1 << index);
+uint64_t MsiRelayUnit::get_next_wakeup_tick() const {
+    uint64_t next = releases_.empty() ? NO_WAKEUP : releases_.top().first;
+    if (!in_flight_.empty()) {
+        next = std::min(next, in_flight_.top());
     }
+    return next;
 }
 
-bool MsiRelayUnit::is_msi_allowed(uint8_t index) const {
-    if (index >= num_vectors_) return false;
-    if (!msix_enable_) return false;
-    if (msix_mask_) return false;
-    if (msix_table_[index].mask) return false;
-    if (!(msix_pba_ & (1 << index))) return false;
-    if (msix_table_[index].address == 0) return false;
-    return true;
+bool MsiRelayUnit::is_pending(uint8_t pf, uint16_t index) const {
+    return pf < num_pfs_ && index < vectors_per_pf_ && functions_[pf].pba.test(index);
 }
 
-void MsiRelayUnit::send_msi(uint8_t index) {
-    if (index >= num_vectors_ || !msi_output_callback_) return;
+void MsiRelayUnit::process_pending_msis(uint64_t now_tick) {
+    delivery_pass_count_++;
+    delivering_ = true;
+    release_holdoffs(now_tick);
+    while (!in_flight_.empty() && in_flight_.top() <= now_tick_) {
+        in_flight_.pop();
+    }
+    issue_egress();
     
-    const MsixTableEntry& entry = msix_table_[index];
-    tlm::tlm_generic_payload trans;
-    sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
-    uint32_t data = entry.data;
-    uint8_t* data_ptr = reinterpret_cast<uint8_t*>(&data);
+    // Walk forward from a cursor so a vector that fails delivery (PBA
+    // restored) is not retried within the same activation
+    uint32_t pfs = deliverable_pfs_;
+    while (pfs && get_egress_occupancy() < egress_depth_) {
+        uint8_t pf = static_cast<uint8_t>(__builtin_ctz(pfs));
+        pfs &= pfs - 1;
+        const HierarchicalBitmap& deliverable = functions_[pf].deliverable;
+        size_t index = deliverable.find_next(0);
+        while (index != HierarchicalBitmap::NPOS) {
+            if (get_egress_occupancy() >= egress_depth_) {
+                break;  // Remaining vectors stay pending until a write completes
+            }
+            enqueue_msi(pf, static_cast<uint16_t>(index));
+            issue_egress();
+            index = deliverable.find_next(index + 1);
+        }
+    }
+    delivering_ = false;
+}
+
+void MsiRelayUnit::update_vector_state(uint8_t pf, uint16_t index) {
+    FunctionState& fn = functions_[pf];
+    bool was_deliverable = fn.deliverable.test(index);
+    fn.valid_addr.assign(index, fn.address[index] != 0);
+    update_deliverable_bit(pf, index);
+    // A vector whose MSI write failed stays deliverable; retry it with the
+    // rewritten entry (a newly deliverable one has already notified)
+    if (was_deliverable && fn.deliverable.test(index) && deliverable_callback_ && !delivering_) {
+        deliverable_callback_();
+    }
+}
+
+void MsiRelayUnit::update_deliverable_bit(uint8_t pf, uint16_t index) {
+    FunctionState& fn = functions_[pf];
+    bool deliverable = fn.msix_enable && !fn.msix_mask &&
+                       fn.pba.test(index) && !fn.masked.test(index) && fn.valid_addr.test(index) &&
+                       !fn.queued.test(index) && (!fn.held.test(index) || fn.count_ready.test(index));
+    if (deliverable == fn.deliverable.test(index)) {
+        return;
+    }
+    fn.deliverable.assign(index, deliverable);
+    if (deliverable) {
+        deliverable_pfs_ |= (1u << pf);
+        if (deliverable_callback_ && !delivering_) deliverable_callback_();
+    } else if (!fn.deliverable.any()) {
+        deliverable_pfs_ &= ~(1u << pf);
+    }
+}
+
+void MsiRelayUnit::update_deliverable_function(uint8_t pf) {
+    // Enable / function-mask change: recompute the whole function word-wise
+    FunctionState& fn = functions_[pf];
+    bool gated = fn.msix_enable && !fn.msix_mask;
+    bool newly_deliverable = false;
+    for (size_t w = 0; w < fn.deliverable.word_count(); w++) {
+        uint64_t bits = gated ? (fn.pba.word(w) & ~fn.masked.word(w) & fn.valid_addr.word(w) &
+                                 ~fn.queued.word(w) & (~fn.held.word(w) | fn.count_ready.word(w))) : 0;
+        newly_deliverable |= (bits & ~fn.deliverable.word(w)) != 0;
+        fn.deliverable.set_word(w, bits);
+    }
+    if (fn.deliverable.any()) {
+        deliverable_pfs_ |= (1u << pf);
+    } else {
+        deliverable_pfs_ &= ~(1u << pf);
+    }
+    if (newly_deliverable && deliverable_callback_ && !delivering_) {
+        deliverable_callback_();
+    }
+}
+
+void MsiRelayUnit::set_pba_bit(uint8_t pf, uint16_t index) {
+    if (pf < num_pfs_ && index < vectors_per_pf_) {
+        functions_[pf].pba.set(index);
+        update_deliverable_bit(pf, index);
+    }
+}
+
+void MsiRelayUnit::clear_pba_bit(uint8_t pf, uint16_t index) {
+    if (pf < num_pfs_ && index < vectors_per_pf_) {
+        functions_[pf].pba.clear(index);
+        update_deliverable_bit(pf, index);
+    }
+}
+
+void MsiRelayUnit::release_holdoffs(uint64_t now_tick) {
+    if (now_tick > now_tick_) {
+        now_tick_ = now_tick;
+    }
+    while (!releases_.empty() && releases_.top().first <= now_tick_) {
+        Release release = releases_.top();
+        releases_.pop();
+        uint8_t pf = static_cast<uint8_t>(release.second >> 16);
+        uint16_t index = static_cast<uint16_t>(release.second & 0xFFFF);
+        FunctionState& fn = functions_[pf];
+        if (fn.held.test(index) && fn.holdoff_until[index] == release.first) {
+            fn.held.clear(index);
+            update_deliverable_bit(pf, index);
+        }
+    }
+}
+
+void MsiRelayUnit::start_holdoff(uint8_t pf, uint16_t index, uint16_t requests) {
+    FunctionState& fn = functions_[pf];
+    fn.coalesced += (requests > 1) ? requests - 1 : 0;
+    if (fn.min_interval[index] == 0) {
+        fn.held.clear(index);
+        return;
+    }
+    fn.holdoff_until.mutate(index) = now_tick_ + fn.min_interval[index];
+    fn.held.set(index);
+    releases_.emplace(fn.holdoff_until[index], (static_cast<uint32_t>(pf) << 16) | index);
+}
+
+bool MsiRelayUnit::is_msi_allowed(uint8_t pf, uint16_t index) const {
+    return pf < num_pfs_ && index < vectors_per_pf_ && functions_[pf].deliverable.test(index);
+}
+
+void MsiRelayUnit::enqueue_msi(uint8_t pf, uint16_t index) {
+    if (!is_msi_allowed(pf, index) || !msi_output_callback_) return;
     
-    trans.set_command(tlm::TLM_WRITE_COMMAND);
-    trans.set_address(entry.address);
-    trans.set_data_ptr(data_ptr);
-    trans.set_data_length(4);
-    trans.set_streaming_width(4);
-    trans.set_byte_enable_ptr(0);
-    trans.set_dmi_allowed(false);
-    trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+    // The message is generated now: capture address/data and the requests it
+    // carries, clear the PBA bit. Coalescing and the holdoff are committed
+    // when the write is accepted (send_msi); until then the vector is queued.
+    FunctionState& fn = functions_[pf];
+    egress_.push_back({fn.address[index], fn.data[index], pf, index, fn.request_count[index]});
+    fn.request_count.mutate(index) = 0;
+    fn.count_ready.clear(index);
+    fn.queued.set(index);
+    clear_pba_bit(pf, index);
+}
+
+void MsiRelayUnit::issue_egress() {
+    while (!egress_.empty() && in_flight_.size() < max_outstanding_) {
+        EgressEntry entry = egress_.front();
+        egress_.pop_front();
+        send_msi(entry);
+    }
+}
+
+void MsiRelayUnit::send_msi(const EgressEntry& entry) {
+    // Buffer lives for the call only; an owner that keeps the write copies it
+    uint8_t data[4];
+    std::memcpy(data, &entry.data, sizeof(data));
+    Transaction trans(Command::Write, entry.address, data, sizeof(data));
+    SimTime delay = 0;
     
-    msi_outstanding_++;
     msi_output_callback_(trans, delay);
     
-    if (trans.get_response_status() == tlm::TLM_OK_RESPONSE) {
-        clear_pba_bit(index);
+    FunctionState& fn = functions_[entry.pf];
+    fn.queued.clear(entry.index);
+    if (trans.get_response_status() == Response::Ok) {
+        start_holdoff(entry.pf, entry.index, entry.requests);
+        // In flight until the annotated completion time
+        uint64_t done_tick = now_tick_ + (delay + MSI_MODERATION_TICK_PS - 1) / MSI_MODERATION_TICK_PS;
+        if (done_tick > now_tick_) {
+            in_flight_.push(done_tick);
+        }
+    } else {
+        // Not delivered: the requests are pending again, holdoff untouched
+        uint16_t& count = fn.request_count.mutate(entry.index);
+        count = static_cast<uint16_t>(std::min<uint32_t>(count + entry.requests, 0xFFFF));
+        fn.count_ready.assign(entry.index, fn.coalesce_count[entry.index] != 0 &&
+                                           count >= fn.coalesce_count[entry.index]);
+        fn.pba.set(entry.index);
     }
-    msi_outstanding_--;
+    update_deliverable_bit(entry.pf, entry.index);
 }
 
-void MsiRelayUnit::process_csr_read(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
-    uint32_t offset = static_cast<uint32_t>(trans.get_address());
+void MsiRelayUnit::process_csr_read(Transaction& trans, uint8_t pf, uint32_t local) {
     uint32_t* data_ptr = reinterpret_cast<uint32_t*>(trans.get_data_ptr());
+    const FunctionState& fn = functions_[pf];
+    uint32_t pba_dwords = (vectors_per_pf_ + 31) / 32;
     
-    if (offset == MSI_RECEIVER_OFFSET) {
+    if (local == MSI_RECEIVER_OFFSET) {
         *data_ptr = 0;
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
-    } else if (offset == MSI_OUTSTANDING_OFFSET) {
+        trans.set_response_status(Response::Ok);
+    } else if (local == MSI_OUTSTANDING_OFFSET) {
         *data_ptr = read_msi_outstanding();
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
-    } else if (offset == MSIX_PBA_OFFSET) {
-        *data_ptr = read_msix_pba();
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
-    } else if (offset >= MSIX_TABLE_BASE_OFFSET) {
-        uint32_t table_offset = offset - MSIX_TABLE_BASE_OFFSET;
-        uint8_t index = table_offset / MSIX_TABLE_ENTRY_SIZE;
+        trans.set_response_status(Response::Ok);
+    } else if (local == MSIX_TABLE_PAGE_OFFSET) {
+        *data_ptr = fn.table_page;
+        trans.set_response_status(Response::Ok);
+    } else if (local == MSI_COALESCED_OFFSET) {
+        *data_ptr = static_cast<uint32_t>(std::min<uint64_t>(fn.coalesced, 0xFFFFFFFFULL));
+        trans.set_response_status(Response::Ok);
+    } else if (local == MSI_EGRESS_CTRL_OFFSET) {
+        *data_ptr = egress_depth_ | (static_cast<uint32_t>(max_outstanding_) << 16);
+        trans.set_response_status(Response::Ok);
+    } else if (local >= MSIX_PBA_OFFSET && local < MSIX_PBA_OFFSET + pba_dwords * 4 && (local & 0x3) == 0) {
+        *data_ptr = read_msix_pba(pf, static_cast<uint16_t>((local - MSIX_PBA_OFFSET) / 4));
+        trans.set_response_status(Response::Ok);
+    } else if (local >= MSIX_MODERATION_BASE_OFFSET && local < MSIX_TABLE_BASE_OFFSET) {
+        uint32_t index = fn.table_page * MSIX_TABLE_PAGE_ENTRIES +
+                         (local - MSIX_MODERATION_BASE_OFFSET) / MSIX_MODERATION_ENTRY_SIZE;
+        if (index < vectors_per_pf_) {
+            *data_ptr = read_moderation(static_cast<uint16_t>(index), pf);
+            trans.set_response_status(Response::Ok);
+        } else {
+            trans.set_response_status(Response::AddressError);
+        }
+    } else if (local >= MSIX_TABLE_BASE_OFFSET) {
+        uint32_t table_offset = local - MSIX_TABLE_BASE_OFFSET;
+        uint32_t index = fn.table_page * MSIX_TABLE_PAGE_ENTRIES + table_offset / MSIX_TABLE_ENTRY_SIZE;
         uint8_t field_offset = table_offset % MSIX_TABLE_ENTRY_SIZE;
         
-        if (index < num_vectors_) {
-            const MsixTableEntry& entry = msix_table_[index];
+        if (index < vectors_per_pf_) {
             if (field_offset == 0) {
-                *data_ptr = static_cast<uint32_t>(entry.address & 0xFFFFFFFF);
+                *data_ptr = static_cast<uint32_t>(fn.address[index] & 0xFFFFFFFF);
             } else if (field_offset == 4) {
-                *data_ptr = static_cast<uint32_t>((entry.address >> 32) & 0xFFFFFFFF);
+                *data_ptr = static_cast<uint32_t>((fn.address[index] >> 32) & 0xFFFFFFFF);
             } else if (field_offset == 8) {
-                *data_ptr = entry.data;
+                *data_ptr = fn.data[index];
             } else if (field_offset == 12) {
-                *data_ptr = entry.mask ? 1 : 0;
+                *data_ptr = fn.masked.test(index) ? 1 : 0;
             }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
 }
 
-void MsiRelayUnit::process_csr_write(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
-    uint32_t offset = static_cast<uint32_t>(trans.get_address());
+void MsiRelayUnit::process_csr_write(Transaction& trans, uint8_t pf, uint32_t local) {
     uint32_t* data_ptr = reinterpret_cast<uint32_t*>(trans.get_data_ptr());
     uint32_t data = *data_ptr;
+    FunctionState& fn = functions_[pf];
     
-    if (offset == MSI_RECEIVER_OFFSET) {
-        write_msi_receiver(data);
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
-    } else if (offset >= MSIX_TABLE_BASE_OFFSET) {
-        uint32_t table_offset = offset - MSIX_TABLE_BASE_OFFSET;
-        uint8_t index = table_offset / MSIX_TABLE_ENTRY_SIZE;
+    if (local == MSI_RECEIVER_OFFSET) {
+        trans.set_response_status(write_msi_receiver(data, pf));
+    } else if (local == MSIX_TABLE_PAGE_OFFSET) {
+        if (data < (vectors_per_pf_ + MSIX_TABLE_PAGE_ENTRIES - 1) / MSIX_TABLE_PAGE_ENTRIES) {
+            fn.table_page = static_cast<uint16_t>(data);
+        }
+        trans.set_response_status(Response::Ok);
+    } else if (local == MSI_COALESCED_OFFSET) {
+        fn.coalesced = 0;
+        trans.set_response_status(Response::Ok);
+    } else if (local == MSI_EGRESS_CTRL_OFFSET) {
+        set_egress_limits(static_cast<uint16_t>(data & 0xFFFF), static_cast<uint16_t>(data >> 16));
+        trans.set_response_status(Response::Ok);
+    } else if (local >= MSIX_MODERATION_BASE_OFFSET && local < MSIX_TABLE_BASE_OFFSET) {
+        uint32_t index = fn.table_page * MSIX_TABLE_PAGE_ENTRIES +
+                         (local - MSIX_MODERATION_BASE_OFFSET) / MSIX_MODERATION_ENTRY_SIZE;
+        if (index < vectors_per_pf_) {
+            set_moderation(static_cast<uint16_t>(index), data & MSIX_MODERATION_INTERVAL_MASK,
+                           static_cast<uint8_t>(data >> MSIX_MODERATION_COUNT_SHIFT), pf);
+            trans.set_response_status(Response::Ok);
+        } else {
+            trans.set_response_status(Response::AddressError);
+        }
+    } else if (local >= MSIX_TABLE_BASE_OFFSET) {
+        uint32_t table_offset = local - MSIX_TABLE_BASE_OFFSET;
+        uint32_t index = fn.table_page * MSIX_TABLE_PAGE_ENTRIES + table_offset / MSIX_TABLE_ENTRY_SIZE;
         uint8_t field_offset = table_offset % MSIX_TABLE_ENTRY_SIZE;
         
-        if (index < num_vectors_) {
-            MsixTableEntry& entry = msix_table_[index];
+        if (index < vectors_per_pf_) {
             if (field_offset == 0) {
-                entry.address = (entry.address & 0xFFFFFFFF00000000ULL) | data;
+                fn.address.mutate(index) = (fn.address[index] & 0xFFFFFFFF00000000ULL) | data;
             } else if (field_offset == 4) {
-                entry.address = (entry.address & 0x00000000FFFFFFFFULL) | (static_cast<uint64_t>(data) << 32);
+                fn.address.mutate(index) = (fn.address[index] & 0x00000000FFFFFFFFULL) | (static_cast<uint64_t>(data) << 32);
             } else if (field_offset == 8) {
-                entry.data = data;
+                fn.data.mutate(index) = data;
             } else if (field_offset == 12) {
-                entry.mask = (data & 0x1) != 0;
+                fn.masked.assign(index, (data & 0x1) != 0);
             }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            update_vector_state(pf, static_cast<uint16_t>(index));
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
+    }
+}
+
+void MsiRelayUnit::reset() {
+    for (FunctionState& fn : functions_) {
+        fn.address.reset();
+        fn.data.reset();
+        fn.pba.clear_all();
+        fn.masked.set_all();
+        fn.valid_addr.clear_all();
+        fn.min_interval.reset();
+        fn.coalesce_count.reset();
+        fn.request_count.reset();
+        fn.holdoff_until.reset();
+        fn.held.clear_all();
+        fn.count_ready.clear_all();
+        fn.queued.clear_all();
+        fn.deliverable.clear_all();
+        fn.msix_enable = false;
+        fn.msix_mask = false;
+        fn.table_page = 0;
+        fn.coalesced = 0;
+    }
+    releases_ = {};
+    egress_.clear();
+    in_flight_ = {};
+    backpressure_count_ = 0;
+    delivery_pass_count_ = 0;
+    deliverable_pfs_ = 0;
+    setip_ = 0;
+}
+
+void MsiRelayUnit::save_state(CheckpointWriter& out) const {
+    out.put<uint16_t>(vectors_per_pf_);
+    out.put<uint8_t>(num_pfs_);
+    for (const FunctionState& fn : functions_) {
+        fn.address.save_state(out);
+        fn.data.save_state(out);
+        fn.pba.save_state(out);
+        fn.masked.save_state(out);
+        fn.valid_addr.save_state(out);
+        fn.min_interval.save_state(out);
+        fn.coalesce_count.save_state(out);
+        fn.request_count.save_state(out);
+        fn.holdoff_until.save_state(out);
+        fn.held.save_state(out);
+        fn.count_ready.save_state(out);
+        fn.deliverable.save_state(out);
+        out.put_flag(fn.msix_enable);
+        out.put_flag(fn.msix_mask);
+        out.put<uint16_t>(fn.table_page);
+        out.put<uint64_t>(fn.coalesced);
+    }
+    
+    // Heaps are written in pop order, so restore pushes them back sorted
+    auto releases = releases_;
+    out.put<uint32_t>(static_cast<uint32_t>(releases.size()));
+    for (; !releases.empty(); releases.pop()) {
+        out.put<uint64_t>(releases.top().first);
+        out.put<uint32_t>(releases.top().second);
+    }
+    auto in_flight = in_flight_;
+    out.put<uint32_t>(static_cast<uint32_t>(in_flight.size()));
+    for (; !in_flight.empty(); in_flight.pop()) {
+        out.put<uint64_t>(in_flight.top());
+    }
+    out.put<uint32_t>(static_cast<uint32_t>(egress_.size()));
+    for (const EgressEntry& entry : egress_) {
+        out.put<uint64_t>(entry.address);
+        out.put<uint32_t>(entry.data);
+        out.put<uint8_t>(entry.pf);
+        out.put<uint16_t>(entry.index);
+        out.put<uint16_t>(entry.requests);
     }
+    
+    out.put<uint64_t>(now_tick_);
+    out.put<uint16_t>(egress_depth_);
+    out.put<uint16_t>(max_outstanding_);
+    out.put<uint64_t>(backpressure_count_);
+    out.put<uint32_t>(deliverable_pfs_);
+    out.put<uint16_t>(setip_);
+}
+
+bool MsiRelayUnit::restore_state(CheckpointReader& in) {
+    if (in.get<uint16_t>() != vectors_per_pf_ || in.get<uint8_t>() != num_pfs_) {
+        in.fail();
+        return false;
+    }
+    for (FunctionState& fn : functions_) {
+        fn.address.restore_state(in);
+        fn.data.restore_state(in);
+        fn.pba.restore_state(in);
+        fn.masked.restore_state(in);
+        fn.valid_addr.restore_state(in);
+        fn.min_interval.restore_state(in);
+        fn.coalesce_count.restore_state(in);
+        fn.request_count.restore_state(in);
+        fn.holdoff_until.restore_state(in);
+        fn.held.restore_state(in);
+        fn.count_ready.restore_state(in);
+        fn.deliverable.restore_state(in);
+        fn.msix_enable = in.get_flag();
+        fn.msix_mask = in.get_flag();
+        fn.table_page = in.get<uint16_t>();
+        fn.coalesced = in.get<uint64_t>();
+    }
+    
+    releases_ = {};
+    uint32_t count = in.get<uint32_t>();
+    for (uint32_t i = 0; i < count && in.ok(); i++) {
+        const uint64_t tick = in.get<uint64_t>();
+        const uint32_t key = in.get<uint32_t>();
+        if ((key >> 16) >= num_pfs_ || (key & 0xFFFF) >= vectors_per_pf_) in.fail();
+        releases_.emplace(tick, key);
+    }
+    in_flight_ = {};
+    count = in.get<uint32_t>();
+    for (uint32_t i = 0; i < count && in.ok(); i++) {
+        in_flight_.push(in.get<uint64_t>());
+    }
+    egress_.clear();
+    for (FunctionState& fn : functions_) fn.queued.clear_all();
+    count = in.get<uint32_t>();
+    for (uint32_t i = 0; i < count && in.ok(); i++) {
+        EgressEntry entry;
+        entry.address = in.get<uint64_t>();
+        entry.data = in.get<uint32_t>();
+        entry.pf = in.get<uint8_t>();
+        entry.index = in.get<uint16_t>();
+        entry.requests = in.get<uint16_t>();
+        if (entry.pf >= num_pfs_ || entry.index >= vectors_per_pf_) {
+            in.fail();
+            break;
+        }
+        functions_[entry.pf].queued.set(entry.index);   // Derived from the FIFO
+        egress_.push_back(entry);
+    }
+    
+    now_tick_ = in.get<uint64_t>();
+    egress_depth_ = in.get<uint16_t>();
+    max_outstanding_ = in.get<uint16_t>();
+    backpressure_count_ = in.get<uint64_t>();
+    deliverable_pfs_ = in.get<uint32_t>();
+    setip_ = in.get<uint16_t>();
+    delivering_ = false;
+    return in.ok();
 }
 
 } // namespace pcie
@@ -9,9 +9,9 @@ NocIoSwitch::NocIoSwitch()
     , next_request_id_(1)
 {}
 
-void NocIoSwitch::route_from_noc(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void NocIoSwitch::route_from_noc(Transaction& trans, SimTime& delay) {
     if (isolate_req_) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         timeout_write_ = true;
         return;
     }
@@ -22,12 +22,12 @@ void NocIoSwitch::route_from_noc(tlm::tlm_generic_payload& trans, sc_core::sc_ti
     // MSI Relay: 0x18800000 - 0x18900000
     if ((addr_32 >= 0x18800000) && (addr_32 < 0x18900000)) {
         if (msi_relay_output_) {
-            uint64_t offset = addr_32 - 0x18800000;
+            uint64_t offset = addr_32 - 0x18800000;  // offset[17:14] = PF
             trans.set_address(offset);
             msi_relay_output_(trans, delay);
             trans.set_address(addr);  // Restore
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
@@ -37,7 +37,7 @@ void NocIoSwitch::route_from_noc(tlm::tlm_generic_payload& trans, sc_core::sc_ti
         if (tlb_app_output_) {
             tlb_app_output_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
@@ -46,7 +46,7 @@ void NocIoSwitch::route_from_noc(tlm::tlm_generic_payload& trans, sc_core::sc_ti
     if (((addr_32 >= 0x18A00000) && (addr_32 < 0x18C00000)) ||
         ((addr_32 >= 0x18C00000) && (addr_32 < 0x18E00000)) ||
         ((addr_32 >= 0x18E00000) && (addr_32 < 0x19000000))) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
     
@@ -55,7 +55,7 @@ void NocIoSwitch::route_from_noc(tlm::tlm_generic_payload& trans, sc_core::sc_ti
         if (tlb_app_output_) {
             tlb_app_output_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
@@ -64,16 +64,16 @@ void NocIoSwitch::route_from_noc(tlm::tlm_generic_payload& trans, sc_core::sc_ti
     if (noc_n_output_) {
         noc_n_output_(trans, delay);
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     }
 }
 
-void NocIoSwitch::route_from_tlb(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void NocIoSwitch::route_from_tlb(Transaction& trans, SimTime& delay) {
     // From TLB, always route to external NOC-N
     if (noc_n_output_) {
         noc_n_output_(trans, delay);
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     }
 }
 
@@ -84,5 +84,20 @@ bool NocIoSwitch::route_to_noc_n(uint64_t addr) const {
     return true;
 }
 
+void NocIoSwitch::save_state(CheckpointWriter& out) const {
+    out.put_flag(isolate_req_);
+    out.put_flag(timeout_read_);
+    out.put_flag(timeout_write_);
+    out.put<uint64_t>(next_request_id_);
+}
+
+bool NocIoSwitch::restore_state(CheckpointReader& in) {
+    isolate_req_ = in.get_flag();
+    timeout_read_ = in.get_flag();
+    timeout_write_ = in.get_flag();
+    next_request_id_ = in.get<uint64_t>();
+    return in.ok();
+}
+
 } // namespace pcie
 } // namespace keraunos
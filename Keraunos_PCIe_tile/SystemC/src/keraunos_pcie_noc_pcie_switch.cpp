@@ -1,6 +1,4 @@
 #include "keraunos_pcie_noc_pcie_switch.h"
-#include <fstream>
-#include <cstdio>
 
 namespace keraunos {
 namespace pcie {
@@ -9,15 +7,16 @@ NocPcieSwitch::NocPcieSwitch()
     : isolate_req_(false), pcie_outbound_enable_(true), pcie_inbound_enable_(true), system_ready_(true)
     , bus_master_enable_(true), controller_is_ep_(true)  // Keraunos is EP-only (Table 6)
     , next_request_id_(1)
+    , tracer_(&Tracer::disabled())
 {}
 
-void NocPcieSwitch::route_from_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void NocPcieSwitch::route_from_pcie(Transaction& trans, SimTime& delay) {
     uint64_t addr = trans.get_address();
-    bool is_read = (trans.get_command() == tlm::TLM_READ_COMMAND);
+    bool is_read = (trans.get_command() == Command::Read);
     
     // Step 1: Isolation blocks ALL traffic (physical AXI tie-off per Section 2.2.1.5)
     if (isolate_req_) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
     
@@ -27,13 +26,13 @@ void NocPcieSwitch::route_from_pcie(tlm::tlm_generic_payload& trans, sc_core::sc
     if (is_status_register_access(addr, is_read)) {
         uint32_t* data_ptr = reinterpret_cast<uint32_t*>(trans.get_data_ptr());
         *data_ptr = get_status_reg_value();
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
         return;
     }
     
     // Step 3: Check inbound enable for normal application traffic
     if (!pcie_inbound_enable_) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
     
@@ -46,73 +45,70 @@ void NocPcieSwitch::route_from_pcie(tlm::tlm_generic_payload& trans, sc_core::sc
     switch(route) {
         case NocPcieRoute::TLB_APP_0:
             if (tlb_app_inbound0_) tlb_app_inbound0_(trans, delay);
-            else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            else trans.set_response_status(Response::Ok);
             break;
         case NocPcieRoute::TLB_APP_1:
             if (tlb_app_inbound1_) tlb_app_inbound1_(trans, delay);
-            else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            else trans.set_response_status(Response::Ok);
             break;
         case NocPcieRoute::TLB_SYS:
             if (tlb_sys_inbound_) tlb_sys_inbound_(trans, delay);
-            else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            else trans.set_response_status(Response::Ok);
             break;
         case NocPcieRoute::BYPASS_APP:
             // Bypass path requires system_ready (Section 2.3.1)
             if (!system_ready_) {
-                trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+                trans.set_response_status(Response::AddressError);
             } else if (noc_io_) {
                 noc_io_(trans, delay);
             } else {
-                trans.set_response_status(tlm::TLM_OK_RESPONSE);
+                trans.set_response_status(Response::Ok);
             }
             break;
         case NocPcieRoute::BYPASS_SYS:
             // Bypass path requires system_ready (Section 2.3.1)
             if (!system_ready_) {
-                trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+                trans.set_response_status(Response::AddressError);
             } else if (smn_io_) {
                 smn_io_(trans, delay);
             } else {
-                trans.set_response_status(tlm::TLM_OK_RESPONSE);
+                trans.set_response_status(Response::Ok);
             }
             break;
         default:
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
             break;
     }
     
+    KERAUNOS_TRACE(*tracer_, TraceEvent::NocPcieRoute, trans, addr, data_addr,
+                   TRACE_NO_ENTRY, static_cast<uint8_t>(route));
+    
     // Restore original address with routing bits
     trans.set_address(addr);
     
     // If still incomplete, set OK as default
-    if (trans.get_response_status() == tlm::TLM_INCOMPLETE_RESPONSE) {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    if (trans.get_response_status() == Response::Incomplete) {
+        trans.set_response_status(Response::Ok);
     }
 }
 
-void NocPcieSwitch::route_to_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void NocPcieSwitch::route_to_pcie(Transaction& trans, SimTime& delay) {
     // No AxUSER provided — delegate with zero AxUSER (treated as memory TLP for BME)
-    // #region agent log
-    {
-        std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug_bme.log", std::ios::app);
-        f << "route_to_pcie 2-arg called (NO axuser) addr=0x" << std::hex << trans.get_address() << std::dec << "\n";
-    }
-    // #endregion
-    sc_dt::sc_bv<256> zero_axuser(0);
+    KERAUNOS_TRACE(*tracer_, TraceEvent::RouteToPcieNoAxuser, trans);
+    AxUser zero_axuser(0);
     route_to_pcie(trans, delay, zero_axuser);
 }
 
-void NocPcieSwitch::route_to_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay,
-                                   const sc_dt::sc_bv<256>& axuser) {
+void NocPcieSwitch::route_to_pcie(Transaction& trans, SimTime& delay, const AxUser& axuser) {
     // Step 1: Isolation blocks all outbound traffic (Section 2.2.1.5)
     if (isolate_req_) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
 
     // Step 2: Outbound enable check (Table 33, rows with outbound_enable=0)
     if (!pcie_outbound_enable_) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
 
@@ -122,23 +118,11 @@ void NocPcieSwitch::route_to_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_t
     //  - EP mode, BME=0: only BME-exempt TLPs pass (Cfg, Msg, DBI); Mem TLPs get DECERR
     if (controller_is_ep_ && !bus_master_enable_) {
         bool exempt = is_bme_exempt(axuser);
-        // #region agent log
-        {
-            std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug_bme.log", std::ios::app);
-            char buf[512];
-            uint32_t tlp_type = 0;
-            for (int i = 0; i < 5; i++) { if (axuser[i].to_bool()) tlp_type |= (1u << i); }
-            bool dbi = axuser[21].to_bool();
-            snprintf(buf, sizeof(buf),
-                "route_to_pcie BME CHECK: ep=%d bme=%d exempt=%d tlp_type=%u dbi=%d addr=0x%lx cmd=%d\n",
-                (int)controller_is_ep_, (int)bus_master_enable_, (int)exempt,
-                tlp_type, (int)dbi, (unsigned long)trans.get_address(),
-                (int)trans.get_command());
-            f << buf;
-        }
-        // #endregion
+        KERAUNOS_TRACE(*tracer_, TraceEvent::RouteToPcieBmeCheck, trans, trans.get_address(),
+                       trans.get_address(), TRACE_NO_ENTRY, TRACE_NO_ROUTE,
+                       trace_axuser_bits(axuser) | (exempt ? 0x100u : 0u));
         if (!exempt) {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
             return;
         }
     }
@@ -147,19 +131,16 @@ void NocPcieSwitch::route_to_pcie(tlm::tlm_generic_payload& trans, sc_core::sc_t
     if (pcie_controller_) {
         pcie_controller_(trans, delay);
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     }
 }
 
-bool NocPcieSwitch::is_bme_exempt(const sc_dt::sc_bv<256>& axuser) const {
+bool NocPcieSwitch::is_bme_exempt(const AxUser& axuser) const {
     // Extract fields from subordinate AxUSER (Table 24/25):
     //   TLP Type [4:0]  — request type encoding
     //   DBI      [21]   — DBI Access Indicator
-    uint32_t tlp_type = 0;
-    for (int i = 0; i < 5; i++) {
-        if (axuser[i].to_bool()) tlp_type |= (1u << i);
-    }
-    bool is_dbi = axuser[21].to_bool();
+    uint32_t tlp_type = axuser.to_uint() & 0x1F;
+    bool is_dbi = axuser.bit(21);
 
     // Table 34: TLP types NOT affected by BME
     //   CfgRd/Wr : TYPE[4:0] = 0010x  → decimal 4 or 5
@@ -198,5 +179,26 @@ bool NocPcieSwitch::is_status_register_access(uint64_t addr, bool is_read) const
     return false;
 }
 
+void NocPcieSwitch::save_state(CheckpointWriter& out) const {
+    out.put_flag(isolate_req_);
+    out.put_flag(pcie_outbound_enable_);
+    out.put_flag(pcie_inbound_enable_);
+    out.put_flag(system_ready_);
+    out.put_flag(bus_master_enable_);
+    out.put_flag(controller_is_ep_);
+    out.put<uint64_t>(next_request_id_);
+}
+
+bool NocPcieSwitch::restore_state(CheckpointReader& in) {
+    isolate_req_ = in.get_flag();
+    pcie_outbound_enable_ = in.get_flag();
+    pcie_inbound_enable_ = in.get_flag();
+    system_ready_ = in.get_flag();
+    bus_master_enable_ = in.get_flag();
+    controller_is_ep_ = in.get_flag();
+    next_request_id_ = in.get<uint64_t>();
+    return in.ok();
+}
+
 } // namespace pcie
 } // namespace keraunos
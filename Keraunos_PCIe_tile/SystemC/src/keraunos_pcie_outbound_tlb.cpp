@@ -1,81 +1,94 @@
 #include "keraunos_pcie_outbound_tlb.h"
 #include <cstring>
-#include <fstream>
 
 namespace keraunos {
 namespace pcie {
 
+namespace {
+
+// Reset images, one per TLB type, shared by every instance: entry 0 valid
+const std::shared_ptr<const TlbTable::Image>& sys_out0_reset_image() {
+    static const auto image = make_tlb_reset_image(16, 0x4000000000ULL, 0);
+    return image;
+}
+
+// Base must be 16TB-aligned (bits[63:44] populated) for 44-bit page TLB
+const std::shared_ptr<const TlbTable::Image>& app_out0_reset_image() {
+    static const auto image = make_tlb_reset_image(16, 0xA00000000000ULL, 0);
+    return image;
+}
+
+const std::shared_ptr<const TlbTable::Image>& app_out1_reset_image() {
+    static const auto image = make_tlb_reset_image(16, 0x9000000000ULL, 0);
+    return image;
+}
+
+} // namespace
+
 // TLBSysOut0 - already implemented in inbound file as they share similar logic
 // Just copy implementation here for completeness
-TLBSysOut0::TLBSysOut0() : entries_(16), tlb_memory_("tlb_sys_out0_memory", 4096) {
-    // Initialize entry 0 as valid
-    entries_[0].valid = true;
-    entries_[0].addr = 0x4000000000 >> 12;
-    entries_[0].attr = 0;
+TLBSysOut0::TLBSysOut0() : entries_(sys_out0_reset_image()), tracer_(&Tracer::disabled()), tlb_memory_(4096) {
 }
 
-void TLBSysOut0::process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBSysOut0::process_config_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = tlb_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            tlb_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                tlb_memory_[offset + i] = data_ptr[i];
-            }
+            tlb_memory_.write(offset, data_ptr, len);
             // CRITICAL FIX: Parse memory writes and update entries_ vector
             uint8_t entry_index = offset / 64;
             uint32_t entry_offset = offset % 64;
             if (entry_index < entries_.size()) {
                 if (entry_offset < 8) {
-                    uint32_t lower = 0, upper = 0;
-                    for (int b = 0; b < 4; b++) lower |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + b]) << (b * 8);
-                    for (int b = 0; b < 4; b++) upper |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + 4 + b]) << (b * 8);
-                    entries_[entry_index].valid = (lower & 0x1) != 0;
-                    entries_[entry_index].addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
-                    entries_[entry_index].addr >>= 12;
+                    uint32_t lower = tlb_memory_.read32(entry_index * 64);
+                    uint32_t upper = tlb_memory_.read32(entry_index * 64 + 4);
+                    entries_.mutate(entry_index).valid = (lower & 0x1) != 0;
+                    entries_.mutate(entry_index).addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
+                    entries_.mutate(entry_index).addr >>= 12;
                 } else if (entry_offset == 32 && len == 4) {
                     uint32_t attr_val = *reinterpret_cast<uint32_t*>(data_ptr);
-                    entries_[entry_index].attr = attr_val;
+                    entries_.mutate(entry_index).attr = attr_val;
                 }
             }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
-void TLBSysOut0::process_outbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBSysOut0::process_outbound_traffic(Transaction& trans, SimTime& delay) {
     uint64_t pa = trans.get_address();
-    uint64_t translated_addr;
-    sc_dt::sc_bv<256> attr;
+    uint64_t translated_addr = pa;
+    AxUser attr;
     
     if (lookup(pa, translated_addr, attr)) {
         trans.set_address(translated_addr);
         if (translated_output_) {
             translated_output_(trans, delay, attr);  // Pass AxUSER for BME qualification
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
+    KERAUNOS_TRACE(*tracer_, TraceEvent::TlbSysOut0, trans, pa, translated_addr,
+                   calculate_index(pa));
 }
 
-bool TLBSysOut0::lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256>& attr) {
+bool TLBSysOut0::lookup(uint64_t pa, uint64_t& translated_addr, AxUser& attr) {
     uint8_t index = calculate_index(pa);
     if (index >= entries_.size()) return false;
     const TlbEntry& entry = entries_[index];
@@ -88,88 +101,98 @@ bool TLBSysOut0::lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256
 }
 
 void TLBSysOut0::configure_entry(uint8_t index, const TlbEntry& entry) {
-    if (index < entries_.size()) entries_[index] = entry;
+    if (index < entries_.size()) {
+        entries_.mutate(index) = entry;
+        store_tlb_entry(tlb_memory_, index, entry);
+    }
 }
 
 TlbEntry TLBSysOut0::get_entry(uint8_t index) const {
     return (index < entries_.size()) ? entries_[index] : TlbEntry();
 }
 
+void TLBSysOut0::reset() {
+    entries_.reset();
+    tlb_memory_.reset();
+}
+
+void TLBSysOut0::save_state(CheckpointWriter& out) const {
+    save_tlb_table(out, entries_);
+    tlb_memory_.save_state(out);
+}
+
+bool TLBSysOut0::restore_state(CheckpointReader& in) {
+    restore_tlb_table(in, entries_);
+    return tlb_memory_.restore_state(in);
+}
+
 uint8_t TLBSysOut0::calculate_index(uint64_t addr) const {
     return static_cast<uint8_t>((addr >> 16) & 0xF);
 }
 
 // TLBAppOut0
-TLBAppOut0::TLBAppOut0() : entries_(16), tlb_memory_("tlb_app_out0_memory", 4096) {
-    // Initialize entry 0 as valid
-    // Base must be 16TB-aligned (bits[63:44] populated) for 44-bit page TLB
-    entries_[0].valid = true;
-    entries_[0].addr = 0xA00000000000ULL >> 12;
-    entries_[0].attr = 0;
+TLBAppOut0::TLBAppOut0() : entries_(app_out0_reset_image()), tracer_(&Tracer::disabled()), tlb_memory_(4096) {
 }
 
-void TLBAppOut0::process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppOut0::process_config_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = tlb_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            tlb_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                tlb_memory_[offset + i] = data_ptr[i];
-            }
+            tlb_memory_.write(offset, data_ptr, len);
             // CRITICAL FIX: Parse memory writes and update entries_ vector
             uint8_t entry_index = offset / 64;
             uint32_t entry_offset = offset % 64;
             if (entry_index < entries_.size()) {
                 if (entry_offset < 8) {
-                    uint32_t lower = 0, upper = 0;
-                    for (int b = 0; b < 4; b++) lower |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + b]) << (b * 8);
-                    for (int b = 0; b < 4; b++) upper |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + 4 + b]) << (b * 8);
-                    entries_[entry_index].valid = (lower & 0x1) != 0;
-                    entries_[entry_index].addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
-                    entries_[entry_index].addr >>= 12;
+                    uint32_t lower = tlb_memory_.read32(entry_index * 64);
+                    uint32_t upper = tlb_memory_.read32(entry_index * 64 + 4);
+                    entries_.mutate(entry_index).valid = (lower & 0x1) != 0;
+                    entries_.mutate(entry_index).addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
+                    entries_.mutate(entry_index).addr >>= 12;
                 } else if (entry_offset == 32 && len == 4) {
                     uint32_t attr_val = *reinterpret_cast<uint32_t*>(data_ptr);
-                    entries_[entry_index].attr = attr_val;
+                    entries_.mutate(entry_index).attr = attr_val;
                 }
             }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
-void TLBAppOut0::process_outbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppOut0::process_outbound_traffic(Transaction& trans, SimTime& delay) {
     uint64_t pa = trans.get_address();
-    uint64_t translated_addr;
-    sc_dt::sc_bv<256> attr;
+    uint64_t translated_addr = pa;
+    AxUser attr;
     
     if (lookup(pa, translated_addr, attr)) {
         trans.set_address(translated_addr);
         if (translated_output_) {
             translated_output_(trans, delay, attr);  // Pass AxUSER for BME qualification
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
+    KERAUNOS_TRACE(*tracer_, TraceEvent::TlbAppOut0, trans, pa, translated_addr,
+                   calculate_index(pa));
 }
 
-bool TLBAppOut0::lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256>& attr) {
+bool TLBAppOut0::lookup(uint64_t pa, uint64_t& translated_addr, AxUser& attr) {
     uint8_t index = calculate_index(pa);
     if (index >= entries_.size()) return false;
     const TlbEntry& entry = entries_[index];
@@ -182,87 +205,98 @@ bool TLBAppOut0::lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256
 }
 
 void TLBAppOut0::configure_entry(uint8_t index, const TlbEntry& entry) {
-    if (index < entries_.size()) entries_[index] = entry;
+    if (index < entries_.size()) {
+        entries_.mutate(index) = entry;
+        store_tlb_entry(tlb_memory_, index, entry);
+    }
 }
 
 TlbEntry TLBAppOut0::get_entry(uint8_t index) const {
     return (index < entries_.size()) ? entries_[index] : TlbEntry();
 }
 
+void TLBAppOut0::reset() {
+    entries_.reset();
+    tlb_memory_.reset();
+}
+
+void TLBAppOut0::save_state(CheckpointWriter& out) const {
+    save_tlb_table(out, entries_);
+    tlb_memory_.save_state(out);
+}
+
+bool TLBAppOut0::restore_state(CheckpointReader& in) {
+    restore_tlb_table(in, entries_);
+    return tlb_memory_.restore_state(in);
+}
+
 uint8_t TLBAppOut0::calculate_index(uint64_t addr) const {
     return static_cast<uint8_t>((addr >> 44) & 0xF);
 }
 
 // TLBAppOut1
-TLBAppOut1::TLBAppOut1() : entries_(16), tlb_memory_("tlb_app_out1_memory", 4096) {
-    // Initialize entry 0 as valid
-    entries_[0].valid = true;
-    entries_[0].addr = 0x9000000000 >> 12;
-    entries_[0].attr = 0;
+TLBAppOut1::TLBAppOut1() : entries_(app_out1_reset_image()), tracer_(&Tracer::disabled()), tlb_memory_(4096) {
 }
 
-void TLBAppOut1::process_config_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppOut1::process_config_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = tlb_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            tlb_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= tlb_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                tlb_memory_[offset + i] = data_ptr[i];
-            }
+            tlb_memory_.write(offset, data_ptr, len);
             // CRITICAL FIX: Parse memory writes and update entries_ vector
             uint8_t entry_index = offset / 64;
             uint32_t entry_offset = offset % 64;
             if (entry_index < entries_.size()) {
                 if (entry_offset < 8) {
-                    uint32_t lower = 0, upper = 0;
-                    for (int b = 0; b < 4; b++) lower |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + b]) << (b * 8);
-                    for (int b = 0; b < 4; b++) upper |= ((uint32_t)(uint8_t)tlb_memory_[entry_index * 64 + 4 + b]) << (b * 8);
-                    entries_[entry_index].valid = (lower & 0x1) != 0;
-                    entries_[entry_index].addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
-                    entries_[entry_index].addr >>= 12;
+                    uint32_t lower = tlb_memory_.read32(entry_index * 64);
+                    uint32_t upper = tlb_memory_.read32(entry_index * 64 + 4);
+                    entries_.mutate(entry_index).valid = (lower & 0x1) != 0;
+                    entries_.mutate(entry_index).addr = ((uint64_t)upper << 32) | (lower & 0xFFFFF000);
+                    entries_.mutate(entry_index).addr >>= 12;
                 } else if (entry_offset == 32 && len == 4) {
                     uint32_t attr_val = *reinterpret_cast<uint32_t*>(data_ptr);
-                    entries_[entry_index].attr = attr_val;
+                    entries_.mutate(entry_index).attr = attr_val;
                 }
             }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
-void TLBAppOut1::process_outbound_traffic(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void TLBAppOut1::process_outbound_traffic(Transaction& trans, SimTime& delay) {
     uint64_t pa = trans.get_address();
-    uint64_t translated_addr;
-    sc_dt::sc_bv<256> attr;
+    uint64_t translated_addr = pa;
+    AxUser attr;
     
     if (lookup(pa, translated_addr, attr)) {
         trans.set_address(translated_addr);
         if (translated_output_) {
             translated_output_(trans, delay, attr);  // Pass AxUSER for BME qualification
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
     }
+    KERAUNOS_TRACE(*tracer_, TraceEvent::TlbAppOut1, trans, pa, translated_addr,
+                   calculate_index(pa));
 }
 
-bool TLBAppOut1::lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256>& attr) {
+bool TLBAppOut1::lookup(uint64_t pa, uint64_t& translated_addr, AxUser& attr) {
     uint8_t index = calculate_index(pa);
     if (index >= entries_.size()) return false;
     const TlbEntry& entry = entries_[index];
@@ -275,13 +309,31 @@ bool TLBAppOut1::lookup(uint64_t pa, uint64_t& translated_addr, sc_dt::sc_bv<256
 }
 
 void TLBAppOut1::configure_entry(uint8_t index, const TlbEntry& entry) {
-    if (index < entries_.size()) entries_[index] = entry;
+    if (index < entries_.size()) {
+        entries_.mutate(index) = entry;
+        store_tlb_entry(tlb_memory_, index, entry);
+    }
 }
 
 TlbEntry TLBAppOut1::get_entry(uint8_t index) const {
     return (index < entries_.size()) ? entries_[index] : TlbEntry();
 }
 
+void TLBAppOut1::reset() {
+    entries_.reset();
+    tlb_memory_.reset();
+}
+
+void TLBAppOut1::save_state(CheckpointWriter& out) const {
+    save_tlb_table(out, entries_);
+    tlb_memory_.save_state(out);
+}
+
+bool TLBAppOut1::restore_state(CheckpointReader& in) {
+    restore_tlb_table(in, entries_);
+    return tlb_memory_.restore_state(in);
+}
+
 uint8_t TLBAppOut1::calculate_index(uint64_t addr) const {
     return static_cast<uint8_t>((addr >> 16) & 0xF);
 }
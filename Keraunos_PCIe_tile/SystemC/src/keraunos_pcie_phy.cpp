@@ -6,41 +6,51 @@ namespace pcie {
 
 PciePhy::PciePhy()
     : reset_n_(false), ref_clock_(false), phy_ready_(false)
-    , phy_memory_("phy_memory", 65536)  // 64KB SCML2 memory
+    , phy_memory_(65536)
 {
 }
 
-void PciePhy::process_apb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void PciePhy::process_apb_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= phy_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = phy_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            phy_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= phy_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                phy_memory_[offset + i] = data_ptr[i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            phy_memory_.write(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
-void PciePhy::process_ahb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void PciePhy::process_ahb_access(Transaction& trans, SimTime& delay) {
     process_apb_access(trans, delay);
 }
 
+void PciePhy::save_state(CheckpointWriter& out) const {
+    out.put_flag(reset_n_);
+    out.put_flag(ref_clock_);
+    out.put_flag(phy_ready_);
+    phy_memory_.save_state(out);
+}
+
+bool PciePhy::restore_state(CheckpointReader& in) {
+    reset_n_ = in.get_flag();
+    ref_clock_ = in.get_flag();
+    phy_ready_ = in.get_flag();
+    return phy_memory_.restore_state(in);
+}
+
 } // namespace pcie
 } // namespace keraunos
@@ -6,37 +6,49 @@ namespace pcie {
 
 PllCgm::PllCgm()
     : ref_clock_(false), reset_n_(false), pcie_clock_(false), pll_locked_(false)
-    , pll_memory_("pll_memory", 4096)  // SCML2 memory
+    , pll_memory_(4096)
 {
 }
 
-void PllCgm::process_apb_access(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void PllCgm::process_apb_access(Transaction& trans, SimTime& delay) {
     uint32_t offset = static_cast<uint32_t>(trans.get_address());
     uint32_t len = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
     
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= pll_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = pll_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            pll_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= pll_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                pll_memory_[offset + i] = data_ptr[i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            pll_memory_.write(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
+void PllCgm::save_state(CheckpointWriter& out) const {
+    out.put_flag(ref_clock_);
+    out.put_flag(reset_n_);
+    out.put_flag(pcie_clock_);
+    out.put_flag(pll_locked_);
+    pll_memory_.save_state(out);
+}
+
+bool PllCgm::restore_state(CheckpointReader& in) {
+    ref_clock_ = in.get_flag();
+    reset_n_ = in.get_flag();
+    pcie_clock_ = in.get_flag();
+    pll_locked_ = in.get_flag();
+    return pll_memory_.restore_state(in);
+}
+
 } // namespace pcie
 } // namespace keraunos
@@ -0,0 +1,65 @@
+#include "keraunos_pcie_profiler.h"
+#include <algorithm>
+#include <cinttypes>
+
+namespace keraunos {
+namespace pcie {
+
+const char* profile_site_name(ProfileSite site) {
+    static const char* const names[] = {
+        "NocPcieSwitch::route_from_pcie", "NocPcieSwitch::route_to_pcie",
+        "NocIoSwitch::route_from_noc", "NocIoSwitch::route_from_tlb", "SmnIoSwitch::route_from_smn",
+        "TLBSysIn0::process_inbound_traffic", "TLBAppIn0::process_inbound_traffic",
+        "TLBAppIn1::process_inbound_traffic",
+        "TLBSysOut0::process_outbound_traffic", "TLBAppOut0::process_outbound_traffic",
+        "TLBAppOut1::process_outbound_traffic",
+        "TLB*::process_config_access",
+        "MsiRelayUnit::process_msi_input", "MsiRelayUnit::process_csr_access",
+        "MsiRelayUnit::process_pending_msis", "MsiRelayUnit::set_msix_*",
+        "SiiBlock::update", "SiiBlock::process_apb_access", "ConfigRegBlock::process_apb_access",
+        "KeraunosPcieTile::signal_update_process",
+        "(downstream targets)"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(ProfileSite::Count),
+                  "profile_site_name table out of sync with ProfileSite");
+    return (site < ProfileSite::Count) ? names[static_cast<size_t>(site)] : "?";
+}
+
+uint64_t Profiler::get_total_exclusive_cycles() const noexcept {
+    uint64_t total = 0;
+    for (const auto& stats : stats_) {
+        total += stats.exclusive_cycles;
+    }
+    return total;
+}
+
+void Profiler::reset() noexcept {
+    stack_.clear();
+    stats_.fill(SiteStats{});
+}
+
+void Profiler::report(std::FILE* out, const char* title) const {
+    std::vector<size_t> order;
+    for (size_t i = 0; i < stats_.size(); i++) {
+        if (stats_[i].calls) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return stats_[a].exclusive_cycles > stats_[b].exclusive_cycles;
+    });
+
+    const uint64_t total = get_total_exclusive_cycles();
+    std::fprintf(out, "\n%s: host cycles per entry point (exclusive of nested sites)\n", title);
+    std::fprintf(out, "%-42s %12s %16s %12s %16s %7s\n",
+                 "site", "calls", "exclusive", "excl/call", "inclusive", "%excl");
+    for (size_t i : order) {
+        const SiteStats& s = stats_[i];
+        std::fprintf(out, "%-42s %12" PRIu64 " %16" PRIu64 " %12.1f %16" PRIu64 " %6.2f%%\n",
+                     profile_site_name(static_cast<ProfileSite>(i)), s.calls, s.exclusive_cycles,
+                     static_cast<double>(s.exclusive_cycles) / s.calls, s.inclusive_cycles,
+                     total ? 100.0 * s.exclusive_cycles / total : 0.0);
+    }
+    std::fprintf(out, "%-42s %12s %16" PRIu64 "\n", "total", "", total);
+}
+
+} // namespace pcie
+} // namespace keraunos
@@ -5,14 +5,30 @@ namespace keraunos {
 namespace pcie {
 
 SiiBlock::SiiBlock()
-    : cii_hv_(false), reset_n_(false)
+    : cii_hv_(false), reset_n_(false), in_reset_(true)
+    , cii_hdr_type_(0), cii_hdr_addr_(0)
     , config_int_(false), device_type_(false), sys_int_(false)
     , app_bus_num_(0), app_dev_num_(0)
     , cfg_modified_(0), cii_clear_(0)
-    , sii_memory_("sii_memory", 65536)  // 64KB SCML2 memory
+    , sii_memory_(65536)
 {
 }
 
+void SiiBlock::reset() {
+    cfg_modified_ = 0;
+    cii_clear_    = 0;
+    config_int_   = false;
+    device_type_  = false;   // EP mode is the reset default (Table 6)
+    sys_int_      = false;
+    app_bus_num_  = 0;
+    app_dev_num_  = 0;
+}
+
+void SiiBlock::power_on_reset() {
+    reset();
+    sii_memory_.reset();     // Epoch bump
+}
+
 /**
  * update() -- CII tracking, cfg_modified update, interrupt generation.
  *
@@ -31,16 +47,16 @@ SiiBlock::SiiBlock()
  */
 void SiiBlock::update() {
     // ---- Phase 0: Reset ------------------------------------------------
+    // Applied once on entry (the tile calls update() on every clock edge
+    // while reset is held)
     if (!reset_n_) {
-        cfg_modified_ = 0;
-        cii_clear_    = 0;
-        config_int_   = false;
-        device_type_  = false;   // EP mode is the reset default (Table 6)
-        sys_int_      = false;
-        app_bus_num_  = 0;
-        app_dev_num_  = 0;
+        if (!in_reset_) {
+            reset();
+            in_reset_ = true;
+        }
         return;
     }
+    in_reset_ = false;
 
     // ---- Phase 1: CII tracking (combinational) -------------------------
     // Equivalent to cii_tracking_process() in the backup_original.
@@ -51,10 +67,10 @@ void SiiBlock::update() {
     uint32_t cii_new_bits = 0;
 
     if (cii_hv_ &&
-        (cii_hdr_type_.to_uint() == 0x04) &&            // config write
-        ((cii_hdr_addr_.to_uint() >> 7) == 0)) {        // first 128B
+        (cii_hdr_type_ == 0x04) &&            // config write
+        ((cii_hdr_addr_ >> 7) == 0)) {        // first 128B
         // Register index = address[6:2] (each 32-bit register is 4 bytes)
-        uint8_t reg_index = (cii_hdr_addr_.to_uint() >> 2) & 0x1F;
+        uint8_t reg_index = (cii_hdr_addr_ >> 2) & 0x1F;
         cii_new_bits = (1u << reg_index);
     }
 
@@ -72,19 +88,28 @@ void SiiBlock::update() {
     // This interrupt is routed to SMC PLIC for firmware handling.
     config_int_ = (cfg_modified_ != 0);
 
-    // ---- Phase 4: CDC sync to SCML memory (for APB readback) ------------
+    // ---- Phase 4: CDC sync to register store (for APB readback) --------
     // Equivalent to cdc_pcie_to_apb().
-    // Write the current cfg_modified value into the SCML memory at
+    // Write the current cfg_modified value into the register store at
     // CFG_MODIFIED_OFFSET so that APB reads return the live value.
-    uint32_t mod_val = cfg_modified_;
-    for (unsigned i = 0; i < sizeof(uint32_t); i++) {
-        sii_memory_[CFG_MODIFIED_OFFSET + i] =
-            static_cast<uint8_t>((mod_val >> (i * 8)) & 0xFF);
-    }
+    sii_memory_.write32(CFG_MODIFIED_OFFSET, cfg_modified_);
+}
+
+void SiiBlock::set_device_type(bool is_rp) {
+    uint32_t control = sii_memory_.read32(CORE_CONTROL_OFFSET) & ~CORE_CONTROL_DEVICE_TYPE_MASK;
+    sii_memory_.write32(CORE_CONTROL_OFFSET, control | (is_rp ? CORE_CONTROL_DEVICE_TYPE_RP : 0));
+    device_type_ = is_rp;
+    if (device_type_cb_) device_type_cb_(is_rp);
+}
+
+void SiiBlock::set_bus_dev_num(uint8_t bus, uint8_t dev) {
+    sii_memory_.write32(BUS_DEV_NUM_OFFSET, static_cast<uint32_t>(bus) << 8 | dev);
+    app_bus_num_ = bus;
+    app_dev_num_ = dev;
 }
 
 /**
- * process_apb_access() -- handles TLM read/write from the SMN-IO switch.
+ * process_apb_access() -- handles read/write from the SMN-IO switch.
  *
  * Register map (relative offsets within 64KB SII space):
  *   0x0000  CORE_CONTROL   -- [2:0] device_type (0=EP, 4=RP)
@@ -93,31 +118,26 @@ void SiiBlock::update() {
  *
  * Note: the SMN-IO switch currently passes the full SMN address to this
  * callback (address passthrough), so offsets >64KB will return
- * TLM_ADDRESS_ERROR_RESPONSE.  When the switch is fixed to strip the
+ * Response::AddressError.  When the switch is fixed to strip the
  * base address, all registers will be accessible.
  */
-void SiiBlock::process_apb_access(tlm::tlm_generic_payload& trans,
-                                   sc_core::sc_time& delay) {
+void SiiBlock::process_apb_access(Transaction& trans, SimTime& delay) {
     uint32_t offset   = static_cast<uint32_t>(trans.get_address());
     uint32_t len      = trans.get_data_length();
     uint8_t* data_ptr = trans.get_data_ptr();
 
-    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+    if (trans.get_command() == Command::Read) {
         if (offset + len <= sii_memory_.get_size()) {
-            for (uint32_t i = 0; i < len; i++) {
-                data_ptr[i] = sii_memory_[offset + i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            sii_memory_.read(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
-    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+    } else if (trans.get_command() == Command::Write) {
         if (offset + len <= sii_memory_.get_size()) {
-            // Store raw data into SCML memory
-            for (uint32_t i = 0; i < len; i++) {
-                sii_memory_[offset + i] = data_ptr[i];
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            // Store raw data into the register store
+            sii_memory_.write(offset, data_ptr, len);
+            trans.set_response_status(Response::Ok);
 
             // --- Register-specific side effects ---
             if (len >= 4) {
@@ -147,12 +167,44 @@ void SiiBlock::process_apb_access(tlm::tlm_generic_payload& trans,
                 }
             }
         } else {
-            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            trans.set_response_status(Response::AddressError);
         }
     } else {
-        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        trans.set_response_status(Response::CommandError);
     }
 }
 
+void SiiBlock::save_state(CheckpointWriter& out) const {
+    out.put_flag(cii_hv_);
+    out.put_flag(reset_n_);
+    out.put<uint8_t>(static_cast<uint8_t>(cii_hdr_type_));
+    out.put<uint16_t>(static_cast<uint16_t>(cii_hdr_addr_));
+    out.put_flag(config_int_);
+    out.put_flag(device_type_);
+    out.put_flag(sys_int_);
+    out.put<uint8_t>(app_bus_num_);
+    out.put<uint8_t>(app_dev_num_);
+    out.put<uint32_t>(cfg_modified_);
+    out.put<uint32_t>(cii_clear_);
+    sii_memory_.save_state(out);
+}
+
+// Device type is restored silently: the tile re-drives the switch mode itself
+bool SiiBlock::restore_state(CheckpointReader& in) {
+    cii_hv_ = in.get_flag();
+    reset_n_ = in.get_flag();
+    set_cii_hdr_type(in.get<uint8_t>());
+    set_cii_hdr_addr(in.get<uint16_t>());
+    config_int_ = in.get_flag();
+    device_type_ = in.get_flag();
+    sys_int_ = in.get_flag();
+    app_bus_num_ = in.get<uint8_t>();
+    app_dev_num_ = in.get<uint8_t>();
+    cfg_modified_ = in.get<uint32_t>();
+    cii_clear_ = in.get<uint32_t>();
+    in_reset_ = !reset_n_;   // update() has run since the last input change
+    return sii_memory_.restore_state(in);
+}
+
 } // namespace pcie
 } // namespace keraunos
@@ -7,11 +7,11 @@ SmnIoSwitch::SmnIoSwitch()
     : isolate_req_(false), timeout_(false), next_request_id_(1)
 {}
 
-void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void SmnIoSwitch::route_from_smn(Transaction& trans, SimTime& delay) {
     uint32_t addr = static_cast<uint32_t>(trans.get_address());
     
     if (isolate_req_) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         timeout_ = true;
         return;
     }
@@ -21,12 +21,12 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
     // MSI Relay Config: 0x18000000 - 0x1803FFFF (256KB, 8 PF × 16KB)
     if (addr >= 0x18000000 && addr < 0x18040000) {
         if (msi_relay_cfg_) {
-            uint64_t offset = addr - 0x18000000;
+            uint64_t offset = addr - 0x18000000;  // offset[17:14] = PF window
             trans.set_address(offset);
             msi_relay_cfg_(trans, delay);
             trans.set_address(addr);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
@@ -42,7 +42,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
                 trans.set_address(offset);
                 tlb_sys_out0_cfg_(trans, delay);
                 trans.set_address(addr);
-            } else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            } else trans.set_response_status(Response::Ok);
             return;
         }
         // TLBAppOut0: offset 0x1000-0x1FFF (4KB, 16 entries × 64B)
@@ -51,7 +51,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
                 trans.set_address(offset - 0x1000);
                 tlb_app_out0_cfg_(trans, delay);
                 trans.set_address(addr);
-            } else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            } else trans.set_response_status(Response::Ok);
             return;
         }
         // TLBAppOut1: offset 0x2000-0x2FFF (4KB, 16 entries × 64B)
@@ -60,7 +60,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
                 trans.set_address(offset - 0x2000);
                 tlb_app_out1_cfg_(trans, delay);
                 trans.set_address(addr);
-            } else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            } else trans.set_response_status(Response::Ok);
             return;
         }
         // TLBSysIn0: offset 0x3000-0x3FFF (4KB, 64 entries × 64B)
@@ -69,7 +69,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
                 trans.set_address(offset - 0x3000);
                 tlb_sys_in0_cfg_(trans, delay);
                 trans.set_address(addr);
-            } else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            } else trans.set_response_status(Response::Ok);
             return;
         }
         // TLBAppIn0[0-3]: offset 0x4000-0x7FFF (4 instances × 4KB)
@@ -79,7 +79,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
                 trans.set_address(offset - 0x4000 - (idx * 0x1000));
                 tlb_app_in0_cfg_[idx](trans, delay);
                 trans.set_address(addr);
-            } else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            } else trans.set_response_status(Response::Ok);
             return;
         }
         // TLBAppIn1: offset 0x8000-0x8FFF (4KB, 64 entries × 64B)
@@ -88,7 +88,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
                 trans.set_address(offset - 0x8000);
                 tlb_app_in1_cfg_(trans, delay);
                 trans.set_address(addr);
-            } else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            } else trans.set_response_status(Response::Ok);
             return;
         }
         // Remaining config space (status registers at 0xFFF8, 0xFFFC, etc.)
@@ -96,20 +96,20 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
             trans.set_address(offset);
             config_reg_(trans, delay);
             trans.set_address(addr);
-        } else trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        } else trans.set_response_status(Response::Ok);
         return;
     }
     
     // SMN-IO Fabric CSR: 0x18050000 - 0x1805FFFF (64KB)
     if (addr >= 0x18050000 && addr < 0x18060000) {
         // Placeholder for SMN-IO CSR access
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
         return;
     }
     
     // Gap: 0x18060000 - 0x1807FFFF (128KB, reserved)
     if (addr >= 0x18060000 && addr < 0x18080000) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
     
@@ -118,7 +118,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
         if (serdes_ahb_) {
             serdes_ahb_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
@@ -128,7 +128,7 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
         if (serdes_apb_) {
             serdes_apb_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
@@ -141,14 +141,14 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
             sii_config_(trans, delay);
             trans.set_address(addr);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
     
     // DECERR: 0x18200000 - 0x183FFFFF (2MB, reserved)
     if (addr >= 0x18200000 && addr < 0x18400000) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
     
@@ -157,14 +157,14 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
         if (tlb_sys_outbound_) {
             tlb_sys_outbound_(trans, delay);
         } else {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            trans.set_response_status(Response::Ok);
         }
         return;
     }
     
     // DECERR: 0x18500000 - 0x187FFFFF (3MB, reserved)
     if (addr >= 0x18500000 && addr < 0x18800000) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         return;
     }
     
@@ -172,14 +172,14 @@ void SmnIoSwitch::route_from_smn(tlm::tlm_generic_payload& trans, sc_core::sc_ti
     if (smn_n_output_) {
         smn_n_output_(trans, delay);
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     }
 }
 
-void SmnIoSwitch::route_from_noc_io(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void SmnIoSwitch::route_from_noc_io(Transaction& trans, SimTime& delay) {
     // Same isolation logic
     if (isolate_req_) {
-        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        trans.set_response_status(Response::AddressError);
         timeout_ = true;
         return;
     }
@@ -188,7 +188,7 @@ void SmnIoSwitch::route_from_noc_io(tlm::tlm_generic_payload& trans, sc_core::sc
     if (msi_relay_data_) {
         msi_relay_data_(trans, delay);
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     }
 }
 
@@ -203,5 +203,18 @@ bool SmnIoSwitch::get_timeout_status() const {
     return timeout_;
 }
 
+void SmnIoSwitch::save_state(CheckpointWriter& out) const {
+    out.put_flag(isolate_req_);
+    out.put_flag(timeout_);
+    out.put<uint64_t>(next_request_id_);
+}
+
+bool SmnIoSwitch::restore_state(CheckpointReader& in) {
+    isolate_req_ = in.get_flag();
+    timeout_ = in.get_flag();
+    next_request_id_ = in.get<uint64_t>();
+    return in.ok();
+}
+
 } // namespace pcie
 } // namespace keraunos
@@ -0,0 +1,100 @@
+#include "keraunos_pcie_span_trace.h"
+#include <cinttypes>
+
+namespace keraunos {
+namespace pcie {
+
+const char* span_hop_name(SpanHop hop) {
+    static const char* const names[] = {
+        "pcie_controller_target", "noc_n_target", "smn_n_target",
+        "NocPcieSwitch", "NocIoSwitch", "SmnIoSwitch", "route_to_pcie",
+        "TLBSysIn0", "TLBAppIn0", "TLBAppIn1", "TLBSysOut0", "TLBAppOut0", "TLBAppOut1",
+        "MsiRelayUnit", "ConfigRegBlock",
+        "noc_n_initiator", "smn_n_initiator", "pcie_controller_initiator"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(SpanHop::Count),
+                  "span_hop_name table out of sync with SpanHop");
+    return (hop < SpanHop::Count) ? names[static_cast<size_t>(hop)] : "?";
+}
+
+SpanTracer::~SpanTracer() {
+    stop();
+}
+
+bool SpanTracer::start(const std::string& path, const std::string& process_name) {
+    if (file_) {
+        return false;
+    }
+    file_ = std::fopen(path.c_str(), "w");
+    if (!file_) {
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+    wall_origin_ = std::chrono::steady_clock::now();
+    spans_ = 0;
+
+    std::fprintf(file_, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    std::fprintf(file_, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s (sim time)\"}},\n",
+                 process_name.c_str());
+    std::fprintf(file_, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"%s (wall time)\"}}",
+                 process_name.c_str());
+    for (int pid = 1; pid <= 2; pid++) {
+        for (size_t hop = 0; hop < static_cast<size_t>(SpanHop::Count); hop++) {
+            std::fprintf(file_, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                         pid, hop, span_hop_name(static_cast<SpanHop>(hop)));
+        }
+    }
+    return true;
+}
+
+void SpanTracer::stop() {
+    if (!file_) {
+        return;
+    }
+    std::fprintf(file_, "\n]}\n");
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void SpanTracer::begin(SpanScope& span) {
+    Transaction& trans = *span.trans_;
+    if (trans.span_id == 0) {
+        trans.span_id = next_id_++;
+        trans.span_root = static_cast<uint32_t>(span.hop_);
+        span.owned_ = true;
+    }
+    span.id_ = trans.span_id;
+    span.root_ = trans.span_root;
+    span.address_ = trans.get_address();
+    span.sim_start_ = clock_() + *span.delay_;
+    span.wall_start_ = std::chrono::steady_clock::now();
+}
+
+void SpanTracer::end(SpanScope& span) {
+    auto wall_end = std::chrono::steady_clock::now();
+    uint64_t sim_end = clock_() + *span.delay_;
+    if (file_) {
+        write_event(1, span, span.sim_start_ * 1e-6, (sim_end - span.sim_start_) * 1e-6);
+        write_event(2, span,
+                    std::chrono::duration<double, std::micro>(span.wall_start_ - wall_origin_).count(),
+                    std::chrono::duration<double, std::micro>(wall_end - span.wall_start_).count());
+        spans_++;
+    }
+    if (span.owned_) {
+        span.trans_->span_id = 0;
+        span.trans_->span_root = 0;
+    }
+}
+
+void SpanTracer::write_event(int pid, const SpanScope& span, double ts_us, double dur_us) {
+    std::fprintf(file_,
+                 ",\n{\"name\":\"%s\",\"cat\":\"hop\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                 "\"ts\":%.6f,\"dur\":%.6f,\"args\":{\"id\":%" PRIu64 ",\"addr\":\"0x%" PRIx64 "\","
+                 "\"cmd\":%d,\"resp\":%d}}",
+                 span_hop_name(span.hop_), pid, span.root_, ts_us, dur_us, span.id_, span.address_,
+                 static_cast<int>(span.trans_->get_command()),
+                 static_cast<int>(span.trans_->get_response_status()));
+}
+
+} // namespace pcie
+} // namespace keraunos
@@ -1,6 +1,5 @@
 #include "keraunos_pcie_tile.h"
-#include <fstream>
-#include <cstdio>
+#include <algorithm>
 
 namespace keraunos {
 namespace pcie {
@@ -13,6 +12,10 @@ KeraunosPcieTile::KeraunosPcieTile(sc_core::sc_module_name name)
     , smn_n_initiator("smn_n_initiator")
     , pcie_controller_target("pcie_controller_target")
     , pcie_controller_initiator("pcie_controller_initiator")
+    , watchdog_tick_value_(1)
+    , msi_tick_value_(1)
+    , msi_control_restored_(false)
+    , payload_pool_(1)
 {
     // Register callbacks for target sockets (inbound from external)
     // Initiator sockets don't need register_b_transport - they call outward via ->b_transport()
@@ -33,12 +36,26 @@ KeraunosPcieTile::KeraunosPcieTile(sc_core::sc_module_name name)
     tlb_sys_out0_ = std::make_unique<TLBSysOut0>();
     tlb_app_out0_ = std::make_unique<TLBAppOut0>();
     tlb_app_out1_ = std::make_unique<TLBAppOut1>();
-    msi_relay_ = std::make_unique<MsiRelayUnit>(16);
+    msi_relay_ = std::make_unique<MsiRelayUnit>(MSI_RELAY_MAX_VECTORS, MSI_RELAY_NUM_PFS);
     sii_block_ = std::make_unique<SiiBlock>();
     config_reg_ = std::make_unique<ConfigRegBlock>();
     clock_reset_ctrl_ = std::make_unique<ClockResetControl>();
     pll_cgm_ = std::make_unique<PllCgm>();
     pcie_phy_ = std::make_unique<PciePhy>();
+    timeout_watchdog_ = std::make_unique<TimeoutWatchdog>();
+    
+    // Components trace and measure spans in SimTime; stamp with the kernel clock
+    tracer_.set_clock(&kernel_sim_time);
+    span_tracer_.set_clock(&kernel_sim_time);
+    noc_pcie_switch_->set_tracer(&tracer_);
+    tlb_sys_in0_->set_tracer(&tracer_);
+    for (auto& tlb : tlb_app_in0_) {
+        tlb->set_tracer(&tracer_);
+    }
+    tlb_app_in1_->set_tracer(&tracer_);
+    tlb_sys_out0_->set_tracer(&tracer_);
+    tlb_app_out0_->set_tracer(&tracer_);
+    tlb_app_out1_->set_tracer(&tracer_);
     
     // Set up callback for config register changes
     if (config_reg_) {
@@ -57,6 +74,15 @@ KeraunosPcieTile::KeraunosPcieTile(sc_core::sc_module_name name)
               << pcie_cii_hv << pcie_cii_hdr_type << pcie_cii_hdr_addr
               << pcie_controller_reset_n << pcie_flr_request << pcie_hot_reset
               << pcie_ras_error << pcie_dma_completion << pcie_misc_int;
+    
+    // Event-driven MSI delivery (no per-clock polling)
+    SC_METHOD(msi_control_process);
+    sensitive << msix_enable_ << msix_mask_ << setip_;
+    dont_initialize();
+    
+    SC_METHOD(msi_delivery_process);
+    sensitive << msi_delivery_event_;
+    dont_initialize();
 }
 
 KeraunosPcieTile::~KeraunosPcieTile() {
@@ -66,6 +92,9 @@ KeraunosPcieTile::~KeraunosPcieTile() {
 
 void KeraunosPcieTile::end_of_elaboration() {
     sc_module::end_of_elaboration();
+    // The time resolution is fixed by now
+    msi_tick_value_ = std::max<uint64_t>(
+        sc_core::sc_time(static_cast<double>(MSI_MODERATION_TICK_PS), sc_core::SC_PS).value(), 1);
     // Initialize outputs
     pcie_app_bus_num.write(0);
     pcie_app_dev_num.write(0);
@@ -80,47 +109,65 @@ void KeraunosPcieTile::end_of_elaboration() {
     noc_timeout.write(sc_dt::sc_bv<3>(0));
 }
 
+void KeraunosPcieTile::end_of_simulation() {
+    sc_module::end_of_simulation();
+    if (profiler_.is_enabled()) {
+        profiler_.report(stdout, name());
+    }
+}
+
 void KeraunosPcieTile::wire_components() {
     // Wire NOC-IO Switch (with null safety checks)
     // Forward NOC outbound traffic through the initiator socket to external (testbench)
     noc_io_switch_->set_noc_n_output([this](auto& t, auto& d) {
-        noc_n_initiator->b_transport(t, d);
+        forward_downstream(noc_n_initiator, false, t, d);
     });
     noc_io_switch_->set_msi_relay_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::MsiRelay, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::MsiRelayInput);
         if (msi_relay_) msi_relay_->process_msi_input(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     // Spec Outbound_TLBApp_lookup: pa >= (1<<48) → TLBAppOut0, else → TLBAppOut1 (DBI)
     noc_io_switch_->set_tlb_app_output([this](auto& t, auto& d) {
         uint64_t addr = t.get_address();
         if ((addr >> 48) & 0xFFFF) {
             // High address → TLBAppOut0 (16TB pages for regular memory access)
+            KERAUNOS_SPAN(span_tracer_, SpanHop::TlbAppOut0, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::TlbAppOut0Outbound);
             if (tlb_app_out0_) tlb_app_out0_->process_outbound_traffic(t, d);
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            else t.set_response_status(Response::Ok);
         } else {
             // Low address → TLBAppOut1 (64KB pages for DBI access)
+            KERAUNOS_SPAN(span_tracer_, SpanHop::TlbAppOut1, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::TlbAppOut1Outbound);
             if (tlb_app_out1_) tlb_app_out1_->process_outbound_traffic(t, d);
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            else t.set_response_status(Response::Ok);
         }
     });
     
     // Wire SMN-IO Switch
     // Forward SMN outbound traffic through the initiator socket to external (testbench)
     smn_io_switch_->set_smn_n_output([this](auto& t, auto& d) {
-        smn_n_initiator->b_transport(t, d);
+        forward_downstream(smn_n_initiator, true, t, d);
     });
     // Config reg: SMN-IO switch already computes offset from Config Reg Block base (0x18040000)
     smn_io_switch_->set_config_reg_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::ConfigReg, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::ConfigRegApbAccess);
         if (config_reg_) {
             config_reg_->process_apb_access(t, d);
         } else {
-            t.set_response_status(tlm::TLM_OK_RESPONSE);
+            t.set_response_status(Response::Ok);
         }
     });
     smn_io_switch_->set_msi_relay_cfg_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::MsiRelay, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::MsiRelayCsrAccess);
         msi_relay_->process_csr_access(t, d);
     });
     smn_io_switch_->set_sii_config_output([this](auto& t, auto& d) {
+        KERAUNOS_PROFILE(profiler_, ProfileSite::SiiApbAccess);
         sii_block_->process_apb_access(t, d);
     });
     smn_io_switch_->set_serdes_apb_output([this](auto& t, auto& d) {
@@ -130,36 +177,46 @@ void KeraunosPcieTile::wire_components() {
         pcie_phy_->process_ahb_access(t, d);
     });
     smn_io_switch_->set_tlb_sys_in0_cfg_output([this](auto& t, auto& d) {
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbConfigAccess);
         if (tlb_sys_in0_) tlb_sys_in0_->process_config_access(t, d);  // Null safety
     });
     for (size_t i = 0; i < tlb_app_in0_.size(); i++) {
         smn_io_switch_->set_tlb_app_in0_cfg_output(static_cast<int>(i), [this, i](auto& t, auto& d) {
+            KERAUNOS_PROFILE(profiler_, ProfileSite::TlbConfigAccess);
             if (tlb_app_in0_[i]) tlb_app_in0_[i]->process_config_access(t, d);  // Null safety
         });
     }
     smn_io_switch_->set_tlb_app_in1_cfg_output([this](auto& t, auto& d) {
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbConfigAccess);
         if (tlb_app_in1_) tlb_app_in1_->process_config_access(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     smn_io_switch_->set_tlb_sys_out0_cfg_output([this](auto& t, auto& d) {
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbConfigAccess);
         if (tlb_sys_out0_) tlb_sys_out0_->process_config_access(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     smn_io_switch_->set_tlb_app_out0_cfg_output([this](auto& t, auto& d) {
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbConfigAccess);
         if (tlb_app_out0_) tlb_app_out0_->process_config_access(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     smn_io_switch_->set_tlb_app_out1_cfg_output([this](auto& t, auto& d) {
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbConfigAccess);
         if (tlb_app_out1_) tlb_app_out1_->process_config_access(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     smn_io_switch_->set_tlb_sys_inbound_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::TlbSysIn0, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbSysIn0Inbound);
         if (tlb_sys_in0_) tlb_sys_in0_->process_inbound_traffic(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     smn_io_switch_->set_tlb_sys_outbound_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::TlbSysOut0, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbSysOut0Outbound);
         if (tlb_sys_out0_) tlb_sys_out0_->process_outbound_traffic(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     
     // Wire NOC-PCIE Switch (with null safety checks)
@@ -171,119 +228,124 @@ void KeraunosPcieTile::wire_components() {
         uint8_t full_index = (addr >> 24) & 0xFF;
         uint8_t instance = (full_index >> 6) & 0x3;
         if (instance < tlb_app_in0_.size() && tlb_app_in0_[instance]) {
+            KERAUNOS_SPAN(span_tracer_, SpanHop::TlbAppIn0, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::TlbAppIn0Inbound);
             tlb_app_in0_[instance]->process_inbound_traffic(t, d);
         } else {
-            t.set_response_status(tlm::TLM_OK_RESPONSE);
+            t.set_response_status(Response::Ok);
         }
     });
     noc_pcie_switch_->set_tlb_app_inbound1_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::TlbAppIn1, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbAppIn1Inbound);
         if (tlb_app_in1_) tlb_app_in1_->process_inbound_traffic(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     noc_pcie_switch_->set_tlb_sys_inbound_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::TlbSysIn0, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbSysIn0Inbound);
         if (tlb_sys_in0_) tlb_sys_in0_->process_inbound_traffic(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     noc_pcie_switch_->set_tlb_app_out0_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::TlbAppOut0, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbAppOut0Outbound);
         if (tlb_app_out0_) tlb_app_out0_->process_outbound_traffic(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     noc_pcie_switch_->set_tlb_app_out1_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::TlbAppOut1, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbAppOut1Outbound);
         if (tlb_app_out1_) tlb_app_out1_->process_outbound_traffic(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     noc_pcie_switch_->set_tlb_sys_out0_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::TlbSysOut0, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::TlbSysOut0Outbound);
         if (tlb_sys_out0_) tlb_sys_out0_->process_outbound_traffic(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     noc_pcie_switch_->set_noc_io_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::NocIoSwitch, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::NocIoRouteFromNoc);
         if (noc_io_switch_) noc_io_switch_->route_from_noc(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     noc_pcie_switch_->set_smn_io_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::SmnIoSwitch, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::SmnIoRouteFromSmn);
         if (smn_io_switch_) smn_io_switch_->route_from_smn(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     // Forward PCIe outbound traffic through the initiator socket to external (testbench)
     noc_pcie_switch_->set_pcie_controller_output([this](auto& t, auto& d) {
-        pcie_controller_initiator->b_transport(t, d);
+        forward_downstream(pcie_controller_initiator, false, t, d);
     });
     noc_pcie_switch_->set_msi_relay_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::MsiRelay, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::MsiRelayInput);
         if (msi_relay_) msi_relay_->process_msi_input(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     noc_pcie_switch_->set_config_reg_output([this](auto& t, auto& d) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::ConfigReg, t, d);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::ConfigRegApbAccess);
         if (config_reg_) config_reg_->process_apb_access(t, d);
-        else t.set_response_status(tlm::TLM_OK_RESPONSE);
+        else t.set_response_status(Response::Ok);
     });
     
     // Wire TLB outputs (with null safety checks)
     // TLB Sys In0: translated traffic goes to SMN port (smn_n_initiator), not NOC
     if (tlb_sys_in0_) {
         tlb_sys_in0_->set_translated_output([this](auto& t, auto& d) {
+            KERAUNOS_SPAN(span_tracer_, SpanHop::SmnIoSwitch, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::SmnIoRouteFromSmn);
             if (smn_io_switch_) smn_io_switch_->route_from_smn(t, d);
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            else t.set_response_status(Response::Ok);
         });
     }
     for (size_t i = 0; i < tlb_app_in0_.size(); i++) {
         if (tlb_app_in0_[i]) {
             tlb_app_in0_[i]->set_translated_output([this](auto& t, auto& d) {
+                KERAUNOS_SPAN(span_tracer_, SpanHop::NocIoSwitch, t, d);
+                KERAUNOS_PROFILE(profiler_, ProfileSite::NocIoRouteFromTlb);
                 if (noc_io_switch_) noc_io_switch_->route_from_tlb(t, d);
-                else t.set_response_status(tlm::TLM_OK_RESPONSE);
+                else t.set_response_status(Response::Ok);
             });
         }
     }
     if (tlb_app_in1_) {
         tlb_app_in1_->set_translated_output([this](auto& t, auto& d) {
+            KERAUNOS_SPAN(span_tracer_, SpanHop::NocIoSwitch, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::NocIoRouteFromTlb);
             if (noc_io_switch_) noc_io_switch_->route_from_tlb(t, d);
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            else t.set_response_status(Response::Ok);
         });
     }
     // Outbound TLB translated outputs: pass AxUSER (TLB ATTR) to NOC-PCIE
     // for BME qualification per Table 33, Section 2.5.8.1
     if (tlb_sys_out0_) {
         tlb_sys_out0_->set_translated_output([this](auto& t, auto& d, const auto& attr) {
+            KERAUNOS_SPAN(span_tracer_, SpanHop::RouteToPcie, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::NocPcieRouteToPcie);
             if (noc_pcie_switch_) noc_pcie_switch_->route_to_pcie(t, d, attr);
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            else t.set_response_status(Response::Ok);
         });
     }
     if (tlb_app_out0_) {
         tlb_app_out0_->set_translated_output([this](auto& t, auto& d, const auto& attr) {
-            if (noc_pcie_switch_) {
-                // #region agent log
-                {
-                    std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug_bme.log", std::ios::app);
-                    char buf[512];
-                    uint32_t tlp_type = 0;
-                    for (int i = 0; i < 5; i++) { if (attr[i].to_bool()) tlp_type |= (1u << i); }
-                    bool dbi = attr[21].to_bool();
-                    snprintf(buf, sizeof(buf),
-                        "TLBAppOut0→route_to_pcie: addr=0x%lx bme=%d ep=%d tlp=%u dbi=%d cmd=%d\n",
-                        (unsigned long)t.get_address(),
-                        (int)noc_pcie_switch_->get_bus_master_enable(),
-                        (int)noc_pcie_switch_->get_controller_is_ep(),
-                        tlp_type, (int)dbi, (int)t.get_command());
-                    f << buf;
-                }
-                // #endregion
-                noc_pcie_switch_->route_to_pcie(t, d, attr);
-                // #region agent log
-                {
-                    std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug_bme.log", std::ios::app);
-                    char buf[128];
-                    snprintf(buf, sizeof(buf), "  → resp after route_to_pcie: %d\n",
-                        (int)t.get_response_status());
-                    f << buf;
-                }
-                // #endregion
-            }
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            KERAUNOS_SPAN(span_tracer_, SpanHop::RouteToPcie, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::NocPcieRouteToPcie);
+            if (noc_pcie_switch_) noc_pcie_switch_->route_to_pcie(t, d, attr);
+            else t.set_response_status(Response::Ok);
         });
     }
     if (tlb_app_out1_) {
         tlb_app_out1_->set_translated_output([this](auto& t, auto& d, const auto& attr) {
+            KERAUNOS_SPAN(span_tracer_, SpanHop::RouteToPcie, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::NocPcieRouteToPcie);
             if (noc_pcie_switch_) noc_pcie_switch_->route_to_pcie(t, d, attr);
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            else t.set_response_status(Response::Ok);
         });
     }
     
@@ -298,78 +360,330 @@ void KeraunosPcieTile::wire_components() {
     // Wire MSI Relay output (with null safety)
     if (msi_relay_) {
         msi_relay_->set_msi_output_callback([this](auto& t, auto& d) {
+            KERAUNOS_SPAN(span_tracer_, SpanHop::NocIoSwitch, t, d);
+            KERAUNOS_PROFILE(profiler_, ProfileSite::NocIoRouteFromNoc);
             if (noc_io_switch_) noc_io_switch_->route_from_noc(t, d);
-            else t.set_response_status(tlm::TLM_OK_RESPONSE);
+            else t.set_response_status(Response::Ok);
         });
+        // Deliver in the next delta cycle, outside the access that raised it
+        msi_relay_->set_deliverable_callback([this]() {
+            msi_delivery_event_.notify(sc_core::SC_ZERO_TIME);
+        });
+    }
+    
+    // Watchdog expiry drives the sticky noc_timeout sources in the switches
+    if (timeout_watchdog_) {
+        timeout_watchdog_->set_expiry_callback([this](TimeoutWatchdog::Channel ch) {
+            switch (ch) {
+            case TimeoutWatchdog::Channel::NocRead:
+                if (noc_io_switch_) noc_io_switch_->set_timeout_read(true);
+                break;
+            case TimeoutWatchdog::Channel::NocWrite:
+                if (noc_io_switch_) noc_io_switch_->set_timeout_write(true);
+                break;
+            case TimeoutWatchdog::Channel::Smn:
+                if (smn_io_switch_) smn_io_switch_->set_timeout(true);
+                break;
+            }
+        });
+    }
+}
+
+void KeraunosPcieTile::set_downstream_timeout(const sc_core::sc_time& timeout) {
+    if (!timeout_watchdog_) return;
+    watchdog_tick_value_ = sc_core::sc_time(static_cast<double>(WATCHDOG_TICK_PS), sc_core::SC_PS).value();
+    if (watchdog_tick_value_ == 0) watchdog_tick_value_ = 1;
+    uint64_t ticks = timeout.value() / watchdog_tick_value_;
+    if (timeout != sc_core::SC_ZERO_TIME && ticks == 0) ticks = 1;  // Round sub-tick timeouts up
+    timeout_watchdog_->set_timeout_ticks(ticks);
+}
+
+bool KeraunosPcieTile::set_boot_config(const BootConfig& config, std::string& error) {
+    if (!check_boot_config(config, msi_relay_->get_num_pfs(), msi_relay_->get_vectors_per_pf(), error)) {
+        return false;
+    }
+    pending_boot_config_ = std::make_unique<BootConfig>(config);
+    return true;
+}
+
+bool KeraunosPcieTile::apply_boot_config(const BootConfig& config, std::string& error) {
+    if (!check_boot_config(config, msi_relay_->get_num_pfs(), msi_relay_->get_vectors_per_pf(), error)) {
+        return false;
+    }
+    if (config.system_ready || config.outbound_app_enable || config.inbound_app_enable) {
+        config_reg_->set_control(config.system_ready.value_or(config_reg_->get_system_ready()),
+                                 config.outbound_app_enable.value_or(config_reg_->get_pcie_outbound_app_enable()),
+                                 config.inbound_app_enable.value_or(config_reg_->get_pcie_inbound_app_enable()));
+    }
+    if (config.device_type_rp) {
+        sii_block_->set_device_type(*config.device_type_rp);
+    }
+    if (config.bus_num || config.dev_num) {
+        sii_block_->set_bus_dev_num(config.bus_num.value_or(sii_block_->get_app_bus_num()),
+                                    config.dev_num.value_or(sii_block_->get_app_dev_num()));
+    }
+    if (config.bus_master_enable) {
+        set_bus_master_enable(*config.bus_master_enable);
+    }
+    
+    for (const BootConfig::TlbWindow& window : config.tlb_windows) {
+        TlbEntry entry;
+        entry.valid = true;
+        entry.addr = window.addr >> 12;
+        entry.attr = window.attr;
+        switch (window.tlb) {
+        case BootConfig::Tlb::SysIn0:   tlb_sys_in0_->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::AppIn0_0: tlb_app_in0_[0]->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::AppIn0_1: tlb_app_in0_[1]->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::AppIn0_2: tlb_app_in0_[2]->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::AppIn0_3: tlb_app_in0_[3]->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::AppIn1:   tlb_app_in1_->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::SysOut0:  tlb_sys_out0_->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::AppOut0:  tlb_app_out0_->configure_entry(window.index, entry); break;
+        case BootConfig::Tlb::AppOut1:  tlb_app_out1_->configure_entry(window.index, entry); break;
+        }
+    }
+    
+    for (const BootConfig::MsixVector& vector : config.msix_vectors) {
+        msi_relay_->write_msix_table(vector.index, vector.address, vector.data, vector.masked, vector.pf);
+    }
+    if (config.msix_enable) set_msix_enable(*config.msix_enable);
+    if (config.msix_mask) set_msix_function_mask(*config.msix_mask);
+    
+    pcie_app_bus_num.write(sii_block_->get_app_bus_num());
+    pcie_app_dev_num.write(sii_block_->get_app_dev_num());
+    pcie_device_type.write(sii_block_->get_device_type());
+    return true;
+}
+
+void KeraunosPcieTile::reset_state() {
+    // Each reset() is an epoch bump plus the bitmaps and flags, so repeated
+    // power cycling does not rewalk tables or register spaces
+    tlb_sys_in0_->reset();
+    for (auto& tlb : tlb_app_in0_) tlb->reset();
+    tlb_app_in1_->reset();
+    tlb_sys_out0_->reset();
+    tlb_app_out0_->reset();
+    tlb_app_out1_->reset();
+    msi_relay_->reset();
+    sii_block_->power_on_reset();
+    noc_pcie_switch_->set_bus_master_enable(true);
+    if (timeout_watchdog_->get_outstanding() != 0) timeout_watchdog_->clear();
+    config_reg_->reset();   // Re-drives the config-dependent modules
+    
+    pcie_app_bus_num.write(sii_block_->get_app_bus_num());
+    pcie_app_dev_num.write(sii_block_->get_app_dev_num());
+    pcie_device_type.write(sii_block_->get_device_type());
+}
+
+namespace {
+constexpr uint32_t CHECKPOINT_MAGIC = checkpoint_tag('K', 'P', 'C', 'T');
+}
+
+bool KeraunosPcieTile::save_state(std::ostream& out) const {
+    CheckpointWriter writer(out);
+    writer.put<uint32_t>(CHECKPOINT_MAGIC);
+    writer.put<uint32_t>(CHECKPOINT_VERSION);
+    
+    writer.begin_section(checkpoint_tag('S', 'I', 'G', ' '));
+    writer.put_flag(system_ready_.read());
+    writer.put_flag(pcie_outbound_app_enable_.read());
+    writer.put_flag(pcie_inbound_app_enable_.read());
+    writer.put_flag(msix_enable_.read());
+    writer.put_flag(msix_mask_.read());
+    writer.put<uint16_t>(static_cast<uint16_t>(setip_.read().to_uint()));
+    writer.put_flag(pcie_clock_.read());
+    writer.put_flag(ref_clock_.read());
+    writer.put_flag(pcie_sii_reset_ctrl_.read());
+    writer.put_flag(pcie_reset_ctrl_.read());
+    writer.put<uint64_t>(watchdog_tick_value_);
+    writer.put<uint64_t>(timeout_watchdog_->get_timeout_ticks());
+    
+    writer.begin_section(checkpoint_tag('R', 'S', 'T', ' '));
+    clock_reset_ctrl_->save_state(writer);
+    pll_cgm_->save_state(writer);
+    pcie_phy_->save_state(writer);
+    writer.begin_section(checkpoint_tag('C', 'F', 'G', ' '));
+    config_reg_->save_state(writer);
+    writer.begin_section(checkpoint_tag('S', 'I', 'I', ' '));
+    sii_block_->save_state(writer);
+    writer.begin_section(checkpoint_tag('S', 'W', 'T', 'C'));
+    noc_pcie_switch_->save_state(writer);
+    noc_io_switch_->save_state(writer);
+    smn_io_switch_->save_state(writer);
+    writer.begin_section(checkpoint_tag('T', 'L', 'B', 'I'));
+    tlb_sys_in0_->save_state(writer);
+    for (const auto& tlb : tlb_app_in0_) tlb->save_state(writer);
+    tlb_app_in1_->save_state(writer);
+    writer.begin_section(checkpoint_tag('T', 'L', 'B', 'O'));
+    tlb_sys_out0_->save_state(writer);
+    tlb_app_out0_->save_state(writer);
+    tlb_app_out1_->save_state(writer);
+    writer.begin_section(checkpoint_tag('M', 'S', 'I', ' '));
+    msi_relay_->save_state(writer);
+    writer.begin_section(checkpoint_tag('E', 'N', 'D', ' '));
+    return writer.ok();
+}
+
+bool KeraunosPcieTile::restore_state(std::istream& in) {
+    CheckpointReader reader(in);
+    if (reader.get<uint32_t>() != CHECKPOINT_MAGIC || reader.get<uint32_t>() != CHECKPOINT_VERSION) {
+        return false;
+    }
+    
+    if (!reader.expect_section(checkpoint_tag('S', 'I', 'G', ' '))) return false;
+    system_ready_.write(reader.get_flag());
+    pcie_outbound_app_enable_.write(reader.get_flag());
+    pcie_inbound_app_enable_.write(reader.get_flag());
+    // The relay section restores the per-PF enables and masks; when these
+    // writes wake msi_control_process it must not re-apply the global ones
+    bool msix_enable = reader.get_flag();
+    bool msix_mask = reader.get_flag();
+    sc_dt::sc_bv<16> setip(reader.get<uint16_t>());
+    msi_control_restored_ = msix_enable != msix_enable_.read() || msix_mask != msix_mask_.read() ||
+                            setip != setip_.read();
+    msix_enable_.write(msix_enable);
+    msix_mask_.write(msix_mask);
+    setip_.write(setip);
+    pcie_clock_.write(reader.get_flag());
+    ref_clock_.write(reader.get_flag());
+    pcie_sii_reset_ctrl_.write(reader.get_flag());
+    pcie_reset_ctrl_.write(reader.get_flag());
+    watchdog_tick_value_ = std::max<uint64_t>(reader.get<uint64_t>(), 1);
+    timeout_watchdog_->clear();
+    timeout_watchdog_->set_timeout_ticks(reader.get<uint64_t>());
+    
+    if (!reader.expect_section(checkpoint_tag('R', 'S', 'T', ' '))) return false;
+    clock_reset_ctrl_->restore_state(reader);
+    pll_cgm_->restore_state(reader);
+    pcie_phy_->restore_state(reader);
+    if (!reader.expect_section(checkpoint_tag('C', 'F', 'G', ' '))) return false;
+    config_reg_->restore_state(reader);
+    if (!reader.expect_section(checkpoint_tag('S', 'I', 'I', ' '))) return false;
+    sii_block_->restore_state(reader);
+    if (!reader.expect_section(checkpoint_tag('S', 'W', 'T', 'C'))) return false;
+    noc_pcie_switch_->restore_state(reader);
+    noc_io_switch_->restore_state(reader);
+    smn_io_switch_->restore_state(reader);
+    if (!reader.expect_section(checkpoint_tag('T', 'L', 'B', 'I'))) return false;
+    tlb_sys_in0_->restore_state(reader);
+    for (auto& tlb : tlb_app_in0_) tlb->restore_state(reader);
+    tlb_app_in1_->restore_state(reader);
+    if (!reader.expect_section(checkpoint_tag('T', 'L', 'B', 'O'))) return false;
+    tlb_sys_out0_->restore_state(reader);
+    tlb_app_out0_->restore_state(reader);
+    tlb_app_out1_->restore_state(reader);
+    if (!reader.expect_section(checkpoint_tag('M', 'S', 'I', ' '))) return false;
+    msi_relay_->restore_state(reader);
+    if (!reader.expect_section(checkpoint_tag('E', 'N', 'D', ' '))) return false;
+    
+    // Outputs the restored components drive (signal_update_process refreshes
+    // them again on the next input change)
+    pcie_app_bus_num.write(sii_block_->get_app_bus_num());
+    pcie_app_dev_num.write(sii_block_->get_app_dev_num());
+    pcie_device_type.write(sii_block_->get_device_type());
+    pcie_sys_int.write(sii_block_->get_sys_int());
+    config_update.write(sii_block_->get_config_int());
+    sc_dt::sc_bv<3> timeout_val;
+    timeout_val[0] = noc_io_switch_->get_timeout_read();
+    timeout_val[1] = noc_io_switch_->get_timeout_write();
+    timeout_val[2] = smn_io_switch_->get_timeout();
+    noc_timeout.write(timeout_val);
+    
+    // Pending MSIs and holdoff releases resume from msi_delivery_process
+    if (msi_relay_->has_deliverable() || msi_relay_->get_next_wakeup_tick() != MsiRelayUnit::NO_WAKEUP) {
+        msi_delivery_event_.notify(sc_core::SC_ZERO_TIME);
+    }
+    return true;
+}
+
+void KeraunosPcieTile::forward_downstream(tlm_utils::simple_initiator_socket<KeraunosPcieTile, 64>& socket,
+                                          bool smn_path, Transaction& trans, SimTime& delay) {
+    KERAUNOS_SPAN(span_tracer_, initiator_span_hop(socket), trans, delay);
+    KERAUNOS_PROFILE(profiler_, ProfileSite::Downstream);
+    {
+        TlmInitiatorAdapter adapter(trans, delay, payload_pool_);
+        if (!timeout_watchdog_ || !timeout_watchdog_->is_enabled()) {
+            socket->b_transport(adapter.payload(), adapter.delay());
+        } else {
+            // PCIe controller outbound traffic originates on the NOC side, so it shares
+            // the NOC read/write bits; SMN-N accesses use the SMN bit
+            TimeoutWatchdog::Channel ch = smn_path ? TimeoutWatchdog::Channel::Smn
+                                        : trans.is_read() ? TimeoutWatchdog::Channel::NocRead
+                                        : TimeoutWatchdog::Channel::NocWrite;
+            TimeoutWatchdog::Handle handle = timeout_watchdog_->arm(watchdog_tick(adapter.delay()), ch);
+            socket->b_transport(adapter.payload(), adapter.delay());
+            if (timeout_watchdog_->complete(handle, watchdog_tick(adapter.delay()))) {
+                adapter.payload().set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            }
+        }
     }
+    KERAUNOS_TRACE(tracer_, initiator_trace_event(socket), trans);
 }
 
-// Top-level socket transport methods (with null safety)
-void KeraunosPcieTile::noc_n_target_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+// Top-level socket transport methods (with null safety): the core sees a
+// Transaction; the adapter writes address, response and delay back on return
+void KeraunosPcieTile::noc_n_target_b_transport(tlm::tlm_generic_payload& payload, sc_core::sc_time& sc_delay) {
+    TlmTargetAdapter adapter(payload, sc_delay);
+    Transaction& trans = adapter.transaction();
+    SimTime& delay = adapter.delay();
+    uint64_t addr = trans.get_address();
+    KERAUNOS_SPAN(span_tracer_, SpanHop::NocTarget, trans, delay);
+    
     if (noc_io_switch_) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::NocIoSwitch, trans, delay);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::NocIoRouteFromNoc);
         noc_io_switch_->route_from_noc(trans, delay);
-        // #region agent log
-        {
-            std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug_bme.log", std::ios::app);
-            char buf[256];
-            snprintf(buf, sizeof(buf),
-                "noc_n_b_transport AFTER route_from_noc: addr=0x%lx resp=%d\n",
-                (unsigned long)trans.get_address(), (int)trans.get_response_status());
-            f << buf;
-        }
-        // #endregion
-        if (trans.get_response_status() == tlm::TLM_INCOMPLETE_RESPONSE) {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        if (trans.get_response_status() == Response::Incomplete) {
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     }
+    KERAUNOS_TRACE(tracer_, TraceEvent::NocTarget, trans, addr, trans.get_address(),
+                   TRACE_NO_ENTRY, TRACE_NO_ROUTE, trace_data_word(trans));
 }
 
-void KeraunosPcieTile::smn_n_target_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+void KeraunosPcieTile::smn_n_target_b_transport(tlm::tlm_generic_payload& payload, sc_core::sc_time& sc_delay) {
+    TlmTargetAdapter adapter(payload, sc_delay);
+    Transaction& trans = adapter.transaction();
+    SimTime& delay = adapter.delay();
     uint64_t addr = trans.get_address();
+    KERAUNOS_SPAN(span_tracer_, SpanHop::SmnTarget, trans, delay);
     
     if (smn_io_switch_) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::SmnIoSwitch, trans, delay);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::SmnIoRouteFromSmn);
         smn_io_switch_->route_from_smn(trans, delay);
-        if (trans.get_response_status() == tlm::TLM_INCOMPLETE_RESPONSE) {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        if (trans.get_response_status() == Response::Incomplete) {
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        trans.set_response_status(Response::Ok);
     }
+    KERAUNOS_TRACE(tracer_, TraceEvent::SmnTarget, trans, addr, trans.get_address(),
+                   TRACE_NO_ENTRY, TRACE_NO_ROUTE, trace_data_word(trans));
 }
 
-void KeraunosPcieTile::pcie_controller_target_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
-    // #region agent log
-    {
-        std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug.log", std::ios::app);
-        char buf[512];
-        uint64_t addr = trans.get_address();
-        snprintf(buf, sizeof(buf), "{\"location\":\"keraunos_pcie_tile.cpp:pcie_b_transport\",\"message\":\"PCIe DUT ENTRY\",\"data\":{\"addr\":\"0x%lx\",\"cmd\":\"%s\",\"has_switch\":%s},\"timestamp\":%ld,\"hypothesisId\":\"DUT_ENTRY\"}\n",
-                 addr, (trans.get_command() == tlm::TLM_READ_COMMAND ? "READ" : "WRITE"),
-                 noc_pcie_switch_ ? "true" : "false", sc_core::sc_time_stamp().value());
-        f << buf;
-    }
-    // #endregion
-
+void KeraunosPcieTile::pcie_controller_target_b_transport(tlm::tlm_generic_payload& payload, sc_core::sc_time& sc_delay) {
+    TlmTargetAdapter adapter(payload, sc_delay);
+    Transaction& trans = adapter.transaction();
+    SimTime& delay = adapter.delay();
+    uint64_t addr = trans.get_address();
+    KERAUNOS_SPAN(span_tracer_, SpanHop::PcieControllerTarget, trans, delay);
+    
     if (noc_pcie_switch_) {
+        KERAUNOS_SPAN(span_tracer_, SpanHop::NocPcieSwitch, trans, delay);
+        KERAUNOS_PROFILE(profiler_, ProfileSite::NocPcieRouteFromPcie);
         noc_pcie_switch_->route_from_pcie(trans, delay);
-        if (trans.get_response_status() == tlm::TLM_INCOMPLETE_RESPONSE) {
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        if (trans.get_response_status() == Response::Incomplete) {
+            trans.set_response_status(Response::Ok);
         }
     } else {
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
-    }
-
-    // #region agent log
-    {
-        std::ofstream f("/localdev/pdroy/keraunos_pcie_workspace/.cursor/debug.log", std::ios::app);
-        char buf[256];
-        snprintf(buf, sizeof(buf), "{\"location\":\"keraunos_pcie_tile.cpp:pcie_b_transport\",\"message\":\"PCIe DUT EXIT\",\"data\":{\"response\":%d},\"timestamp\":%ld,\"hypothesisId\":\"DUT_EXIT\"}\n",
-                 trans.get_response_status(), sc_core::sc_time_stamp().value());
-        f << buf;
+        trans.set_response_status(Response::Ok);
     }
-    // #endregion
+    KERAUNOS_TRACE(tracer_, TraceEvent::PcieTarget, trans, addr, trans.get_address(),
+                   TRACE_NO_ENTRY, TRACE_NO_ROUTE, trace_data_word(trans));
 }
 
 void KeraunosPcieTile::update_config_dependent_modules() {
@@ -391,7 +705,34 @@ void KeraunosPcieTile::update_config_dependent_modules() {
     }
 }
 
+// SignalChange records for the control inputs that changed this delta, so
+// a replay can drive the pins in step with the recorded transactions
+void KeraunosPcieTile::trace_pin_changes() {
+    auto pin = [this](TracePin id, uint32_t value) {
+        KERAUNOS_TRACE(tracer_, TraceEvent::SignalChange, static_cast<uint64_t>(id), value);
+    };
+    if (cold_reset_n.event()) pin(TracePin::ColdResetN, cold_reset_n.read());
+    if (warm_reset_n.event()) pin(TracePin::WarmResetN, warm_reset_n.read());
+    if (isolate_req.event()) pin(TracePin::IsolateReq, isolate_req.read());
+    if (pcie_controller_reset_n.event()) pin(TracePin::PcieControllerResetN, pcie_controller_reset_n.read());
+    if (pcie_cii_hv.event()) pin(TracePin::PcieCiiHv, pcie_cii_hv.read());
+    if (pcie_cii_hdr_type.event()) pin(TracePin::PcieCiiHdrType, pcie_cii_hdr_type.read().to_uint());
+    if (pcie_cii_hdr_addr.event()) pin(TracePin::PcieCiiHdrAddr, pcie_cii_hdr_addr.read().to_uint());
+    if (pcie_flr_request.event()) pin(TracePin::PcieFlrRequest, pcie_flr_request.read());
+    if (pcie_hot_reset.event()) pin(TracePin::PcieHotReset, pcie_hot_reset.read());
+    if (pcie_ras_error.event()) pin(TracePin::PcieRasError, pcie_ras_error.read());
+    if (pcie_dma_completion.event()) pin(TracePin::PcieDmaCompletion, pcie_dma_completion.read());
+    if (pcie_misc_int.event()) pin(TracePin::PcieMiscInt, pcie_misc_int.read());
+}
+
 void KeraunosPcieTile::signal_update_process() {
+    KERAUNOS_PROFILE(profiler_, ProfileSite::SignalUpdateProcess);
+    if (tracer_.is_enabled()) trace_pin_changes();
+    if (pending_boot_config_ && cold_reset_n.read() && pcie_controller_reset_n.read()) {
+        std::string error;  // Checked by set_boot_config()
+        apply_boot_config(*pending_boot_config_, error);
+        pending_boot_config_.reset();
+    }
     // Update internal component states from input signals (with null safety)
     if (clock_reset_ctrl_) {
         clock_reset_ctrl_->set_cold_reset_n(cold_reset_n.read());
@@ -414,18 +755,35 @@ void KeraunosPcieTile::signal_update_process() {
             noc_pcie_switch_->set_bus_master_enable(true);
         }
     }
+    
+    // Fire watchdog deadlines that passed while accesses were blocked downstream
+    // (clock edges keep this process running during a target's wait()).
+    // Cold reset drops all tracked accesses; their completions become no-ops.
+    if (timeout_watchdog_) {
+        if (!cold_reset_n.read()) {
+            // Walks the node pool, so only when something is tracked: a
+            // held reset costs nothing per clock edge
+            if (timeout_watchdog_->get_outstanding() != 0) timeout_watchdog_->clear();
+        } else if (timeout_watchdog_->is_enabled()) {
+            timeout_watchdog_->advance(watchdog_tick(sc_core::SC_ZERO_TIME));
+        }
+    }
+    
     if (noc_io_switch_) noc_io_switch_->set_isolate_req(isolate_req.read());
     if (smn_io_switch_) smn_io_switch_->set_isolate_req(isolate_req.read());
     
     if (sii_block_) {
         // Set CII inputs from PCIe controller signals
         sii_block_->set_cii_hv(pcie_cii_hv.read());
-        sii_block_->set_cii_hdr_type(pcie_cii_hdr_type.read());
-        sii_block_->set_cii_hdr_addr(pcie_cii_hdr_addr.read());
+        sii_block_->set_cii_hdr_type(static_cast<uint8_t>(pcie_cii_hdr_type.read().to_uint()));
+        sii_block_->set_cii_hdr_addr(static_cast<uint16_t>(pcie_cii_hdr_addr.read().to_uint()));
         sii_block_->set_reset_n(pcie_controller_reset_n.read());
 
         // Process CII tracking, cfg_modified update, interrupt generation
-        sii_block_->update();
+        {
+            KERAUNOS_PROFILE(profiler_, ProfileSite::SiiUpdate);
+            sii_block_->update();
+        }
 
         // Drive outputs from SII
         pcie_app_bus_num.write(sii_block_->get_app_bus_num());
@@ -466,12 +824,42 @@ void KeraunosPcieTile::signal_update_process() {
     }
     noc_timeout.write(timeout_val);
     
-    // Trigger MSI processing (with null safety)
+    // MSI writes fail while isolated and their vectors stay pending; retry
+    // them once isolation is released
+    if (msi_relay_ && isolate_req.event() && !isolate_req.read() && msi_relay_->has_deliverable()) {
+        msi_delivery_event_.notify(sc_core::SC_ZERO_TIME);
+    }
+}
+
+void KeraunosPcieTile::msi_control_process() {
     if (msi_relay_) {
-        msi_relay_->set_msix_enable(msix_enable_.read());
-        msi_relay_->set_msix_mask(msix_mask_.read());
+        KERAUNOS_PROFILE(profiler_, ProfileSite::MsiRelayControl);
+        if (!msi_control_restored_) {
+            msi_relay_->set_msix_enable(msix_enable_.read());
+            msi_relay_->set_msix_mask(msix_mask_.read());
+        }
+        msi_control_restored_ = false;
         msi_relay_->set_interrupt_pending(setip_.read().to_uint());
-        msi_relay_->process_pending_msis();
+    }
+}
+
+void KeraunosPcieTile::msi_delivery_process() {
+    if (msi_relay_) deliver_msis();
+}
+
+void KeraunosPcieTile::deliver_msis() {
+    uint64_t now_tick = sc_core::sc_time_stamp().value() / msi_tick_value_;
+    
+    {
+        KERAUNOS_PROFILE(profiler_, ProfileSite::MsiRelayPending);
+        msi_relay_->process_pending_msis(now_tick);
+    }
+    
+    uint64_t wakeup_tick = msi_relay_->get_next_wakeup_tick();
+    if (wakeup_tick != MsiRelayUnit::NO_WAKEUP) {
+        // sc_event keeps the earliest pending notification
+        msi_delivery_event_.notify(sc_core::sc_time(
+            static_cast<double>((wakeup_tick - now_tick) * MSI_MODERATION_TICK_PS), sc_core::SC_PS));
     }
 }
 
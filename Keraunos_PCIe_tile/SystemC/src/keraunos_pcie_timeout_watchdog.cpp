@@ -0,0 +1,254 @@
+#include "keraunos_pcie_timeout_watchdog.h"
+#include <algorithm>
+
+namespace keraunos {
+namespace pcie {
+
+TimeoutWatchdog::TimeoutWatchdog()
+    : free_head_(NIL)
+    , now_(0)
+    , timeout_ticks_(0)
+    , armed_(0)
+    , outstanding_(0)
+    , expired_count_(0)
+{
+    buckets_.fill(NIL);
+    occupancy_.fill(0);
+}
+
+TimeoutWatchdog::Handle TimeoutWatchdog::arm(uint64_t now_tick, Channel channel) {
+    if (timeout_ticks_ == 0) {
+        return INVALID_HANDLE;
+    }
+    advance(now_tick);
+
+    uint32_t idx = alloc_node();
+    Node& node = nodes_[idx];
+    uint64_t start = std::max(now_tick, now_);
+    // Saturate instead of wrapping for very large timeouts
+    node.deadline = (start > ~0ULL - timeout_ticks_) ? ~0ULL : start + timeout_ticks_;
+    node.channel = channel;
+    node.state = NodeState::Armed;
+    insert(idx);
+    armed_++;
+    outstanding_++;
+
+    return (static_cast<uint64_t>(node.generation) << 32) | idx;
+}
+
+bool TimeoutWatchdog::complete(Handle handle, uint64_t done_tick) {
+    if (handle == INVALID_HANDLE) {
+        return false;
+    }
+    uint32_t idx = static_cast<uint32_t>(handle & 0xFFFFFFFFULL);
+    uint32_t generation = static_cast<uint32_t>(handle >> 32);
+    if (idx >= nodes_.size()) {
+        return false;
+    }
+    Node& node = nodes_[idx];
+    if (node.state == NodeState::Free || node.generation != generation) {
+        return false;  // Stale handle (e.g. cleared by reset)
+    }
+
+    bool timed_out = (node.state == NodeState::Expired);
+    if (!timed_out) {
+        unlink(idx);
+        armed_--;
+        // Loosely-timed targets annotate latency instead of waiting, so the
+        // wheel never saw the deadline pass - check the completion time too
+        if (done_tick >= node.deadline) {
+            timed_out = true;
+            expired_count_++;
+            if (expiry_callback_) expiry_callback_(node.channel);
+        }
+    }
+
+    free_node(idx);
+    outstanding_--;
+    return timed_out;
+}
+
+void TimeoutWatchdog::advance(uint64_t now_tick) {
+    if (now_tick <= now_) {
+        return;
+    }
+    while (armed_ != 0) {
+        uint64_t next = next_event_tick();
+        if (next > now_tick) {
+            break;
+        }
+        now_ = next;
+        // Cascade from the top so entries dropping out of a higher level
+        // can land in the lower level's current slot
+        for (unsigned level = LEVELS - 1; level > 0; level--) {
+            uint64_t span_mask = (1ULL << (level * SLOT_BITS)) - 1;
+            if ((now_ & span_mask) == 0) {
+                cascade(level);
+            }
+        }
+        expire_slot();
+    }
+    now_ = now_tick;
+}
+
+void TimeoutWatchdog::clear() {
+    // Bump every generation so outstanding handles become stale
+    free_head_ = NIL;
+    for (uint32_t idx = 0; idx < nodes_.size(); idx++) {
+        Node& node = nodes_[idx];
+        if (node.state != NodeState::Free) {
+            node.generation++;
+            node.state = NodeState::Free;
+        }
+        node.prev = NIL;
+        node.next = free_head_;
+        free_head_ = idx;
+    }
+    buckets_.fill(NIL);
+    occupancy_.fill(0);
+    armed_ = 0;
+    outstanding_ = 0;
+}
+
+uint32_t TimeoutWatchdog::alloc_node() {
+    if (free_head_ != NIL) {
+        uint32_t idx = free_head_;
+        free_head_ = nodes_[idx].next;
+        return idx;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimeoutWatchdog::free_node(uint32_t idx) {
+    Node& node = nodes_[idx];
+    node.state = NodeState::Free;
+    node.generation++;
+    node.prev = NIL;
+    node.next = free_head_;
+    free_head_ = idx;
+}
+
+void TimeoutWatchdog::insert(uint32_t idx) {
+    Node& node = nodes_[idx];
+    uint64_t expiry = std::max(node.deadline, now_);
+
+    // Lowest level whose slot index distance from now fits in one rotation
+    unsigned level = 0;
+    for (; level < LEVELS; level++) {
+        unsigned shift = level * SLOT_BITS;
+        if ((expiry >> shift) - (now_ >> shift) < SLOTS) {
+            break;
+        }
+    }
+
+    uint64_t slot;
+    if (level == LEVELS) {
+        // Beyond wheel range: park in the last top-level slot, re-cascade later
+        level = LEVELS - 1;
+        slot = ((now_ >> (level * SLOT_BITS)) + SLOT_MASK) & SLOT_MASK;
+    } else {
+        slot = (expiry >> (level * SLOT_BITS)) & SLOT_MASK;
+    }
+
+    uint16_t bucket = static_cast<uint16_t>(level * SLOTS + slot);
+    node.bucket = bucket;
+    node.prev = NIL;
+    node.next = buckets_[bucket];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = idx;
+    }
+    buckets_[bucket] = idx;
+    occupancy_[bucket / 64] |= (1ULL << (bucket % 64));
+}
+
+void TimeoutWatchdog::unlink(uint32_t idx) {
+    Node& node = nodes_[idx];
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        buckets_[node.bucket] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    if (buckets_[node.bucket] == NIL) {
+        occupancy_[node.bucket / 64] &= ~(1ULL << (node.bucket % 64));
+    }
+    node.prev = NIL;
+    node.next = NIL;
+}
+
+void TimeoutWatchdog::cascade(unsigned level) {
+    uint64_t slot = (now_ >> (level * SLOT_BITS)) & SLOT_MASK;
+    uint16_t bucket = static_cast<uint16_t>(level * SLOTS + slot);
+    uint32_t idx = buckets_[bucket];
+    buckets_[bucket] = NIL;
+    occupancy_[bucket / 64] &= ~(1ULL << (bucket % 64));
+
+    while (idx != NIL) {
+        uint32_t next = nodes_[idx].next;
+        insert(idx);
+        idx = next;
+    }
+}
+
+void TimeoutWatchdog::expire_slot() {
+    uint16_t bucket = static_cast<uint16_t>(now_ & SLOT_MASK);
+    uint32_t idx = buckets_[bucket];
+    buckets_[bucket] = NIL;
+    occupancy_[bucket / 64] &= ~(1ULL << (bucket % 64));
+
+    while (idx != NIL) {
+        Node& node = nodes_[idx];
+        uint32_t next = node.next;
+        node.prev = NIL;
+        node.next = NIL;
+        // Node stays allocated until its owner calls complete()
+        node.state = NodeState::Expired;
+        armed_--;
+        expired_count_++;
+        if (expiry_callback_) expiry_callback_(node.channel);
+        idx = next;
+    }
+}
+
+uint64_t TimeoutWatchdog::next_event_tick() const {
+    // Earliest of: next level-0 expiry, or next higher-level cascade point
+    uint64_t next = ~0ULL;
+    for (unsigned level = 0; level < LEVELS; level++) {
+        unsigned shift = level * SLOT_BITS;
+        unsigned cur = static_cast<unsigned>((now_ >> shift) & SLOT_MASK);
+        int slot = (cur + 1 < SLOTS) ? find_occupied_slot(level, cur + 1) : -1;
+        if (slot < 0) {
+            slot = find_occupied_slot(level, 0);
+        }
+        if (slot < 0) {
+            continue;
+        }
+        uint64_t distance = (static_cast<unsigned>(slot) > cur)
+                          ? static_cast<unsigned>(slot) - cur
+                          : static_cast<unsigned>(slot) + SLOTS - cur;
+        uint64_t tick = ((now_ >> shift) + distance) << shift;
+        next = std::min(next, tick);
+    }
+    return next;
+}
+
+int TimeoutWatchdog::find_occupied_slot(unsigned level, unsigned from) const {
+    const uint64_t* bitmap = &occupancy_[level * BITMAP_WORDS];
+    unsigned word = from / 64;
+    uint64_t bits = bitmap[word] & (~0ULL << (from % 64));
+    while (true) {
+        if (bits) {
+            return static_cast<int>(word * 64 + __builtin_ctzll(bits));
+        }
+        if (++word >= BITMAP_WORDS) {
+            return -1;
+        }
+        bits = bitmap[word];
+    }
+}
+
+} // namespace pcie
+} // namespace keraunos
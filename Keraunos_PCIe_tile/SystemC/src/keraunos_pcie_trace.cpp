@@ -0,0 +1,113 @@
+#include "keraunos_pcie_trace.h"
+#include <algorithm>
+#include <chrono>
+
+namespace keraunos {
+namespace pcie {
+
+TraceRing::TraceRing(size_t capacity)
+    : mask_(0)
+    , head_(0)
+    , tail_(0)
+{
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+}
+
+size_t TraceRing::pop(TraceRecord* out, size_t max_records) noexcept {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t count = std::min(head - tail, max_records);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = buffer_[(tail + i) & mask_];
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+Tracer::Tracer(size_t capacity)
+    : capacity_(capacity)
+    , clock_(&no_clock)
+    , enabled_(false)
+    , recorded_(0)
+    , dropped_(0)
+    , file_(nullptr)
+    , stop_requested_(false)
+    , bytes_written_(0)
+{}
+
+Tracer::~Tracer() {
+    stop();
+}
+
+Tracer& Tracer::disabled() {
+    static Tracer instance(1);
+    return instance;
+}
+
+bool Tracer::start(const std::string& path) {
+    if (enabled_ || file_) {
+        return false;
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+
+    uint8_t header[TRACE_HEADER_SIZE];
+    trace_write_header(header, TRACE_RESOLUTION_FS);
+    std::fwrite(header, 1, sizeof(header), file_);
+    bytes_written_.store(sizeof(header), std::memory_order_relaxed);
+
+    ring_ = std::make_unique<TraceRing>(capacity_);
+    stop_requested_.store(false, std::memory_order_release);
+    writer_ = std::thread(&Tracer::writer_loop, this);
+    enabled_ = true;
+    return true;
+}
+
+void Tracer::stop() {
+    enabled_ = false;
+    if (writer_.joinable()) {
+        stop_requested_.store(true, std::memory_order_release);
+        writer_.join();
+    }
+    ring_.reset();  // Drained by the writer
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void Tracer::writer_loop() {
+    TraceCodec codec;
+    std::vector<TraceRecord> batch(4096);
+    std::vector<uint8_t> encoded(batch.size() * TRACE_MAX_ENCODED_RECORD);
+    while (true) {
+        // Read the flag before draining so records pushed ahead of stop()
+        // are always written
+        bool stopping = stop_requested_.load(std::memory_order_acquire);
+        size_t count = ring_->pop(batch.data(), batch.size());
+        if (count) {
+            size_t bytes = 0;
+            for (size_t i = 0; i < count; i++) {
+                bytes += codec.encode(batch[i], encoded.data() + bytes);
+            }
+            std::fwrite(encoded.data(), 1, bytes, file_);
+            bytes_written_.fetch_add(bytes, std::memory_order_relaxed);
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    std::fflush(file_);
+}
+
+} // namespace pcie
+} // namespace keraunos
@@ -0,0 +1,148 @@
+// Offline decoder for Keraunos PCIe tile binary traces (format version 2)
+//
+// Usage: keraunos_pcie_trace_decode [--csv] <trace.bin> [output]
+// Writes to stdout when no output file is given. Needs no SystemC.
+
+#include "keraunos_pcie_trace_format.h"
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <vector>
+
+using keraunos::pcie::TraceCodec;
+using keraunos::pcie::TraceRecord;
+using keraunos::pcie::TRACE_HEADER_SIZE;
+using keraunos::pcie::TRACE_NO_ENTRY;
+using keraunos::pcie::TRACE_NO_ROUTE;
+
+namespace {
+
+const char* command_name(uint8_t cmd) {
+    switch (cmd) {
+        case 0: return "RD";
+        case 1: return "WR";
+        default: return "--";
+    }
+}
+
+const char* response_name(int8_t resp) {
+    switch (resp) {
+        case 1: return "OK";
+        case 0: return "INCOMPLETE";
+        case -1: return "GENERIC_ERROR";
+        case -2: return "ADDRESS_ERROR";
+        case -3: return "COMMAND_ERROR";
+        case -4: return "BURST_ERROR";
+        case -5: return "BYTE_ENABLE_ERROR";
+        default: return "?";
+    }
+}
+
+void print_text(std::FILE* out, const TraceRecord& rec, double time_scale_ns) {
+    if (rec.event == static_cast<uint8_t>(keraunos::pcie::TraceEvent::SignalChange)) {
+        std::fprintf(out, "%14.3f ns  %-24s %s = 0x%X\n",
+                     rec.sim_time * time_scale_ns, keraunos::pcie::trace_event_name(rec.event),
+                     keraunos::pcie::trace_pin_name(rec.address), rec.aux);
+        return;
+    }
+    std::fprintf(out, "%14.3f ns  %-24s %s 0x%016" PRIx64,
+                 rec.sim_time * time_scale_ns, keraunos::pcie::trace_event_name(rec.event),
+                 command_name(rec.command), rec.address);
+    if (rec.translated != rec.address) {
+        std::fprintf(out, " -> 0x%016" PRIx64, rec.translated);
+    }
+    std::fprintf(out, " len=%u %s", rec.length, response_name(rec.response));
+    if (rec.route != TRACE_NO_ROUTE) std::fprintf(out, " route=0x%X", rec.route);
+    if (rec.tlb_entry != TRACE_NO_ENTRY) std::fprintf(out, " entry=%u", rec.tlb_entry);
+    if (rec.aux) std::fprintf(out, " aux=0x%X", rec.aux);
+    std::fputc('\n', out);
+}
+
+void print_csv(std::FILE* out, const TraceRecord& rec) {
+    std::fprintf(out, "%" PRIu64 ",%s,%s,0x%" PRIx64 ",0x%" PRIx64 ",%u,%s,",
+                 rec.sim_time, keraunos::pcie::trace_event_name(rec.event),
+                 command_name(rec.command), rec.address, rec.translated, rec.length,
+                 response_name(rec.response));
+    if (rec.route != TRACE_NO_ROUTE) std::fprintf(out, "%u", rec.route);
+    std::fputc(',', out);
+    if (rec.tlb_entry != TRACE_NO_ENTRY) std::fprintf(out, "%u", rec.tlb_entry);
+    std::fprintf(out, ",0x%X\n", rec.aux);
+}
+
+int usage() {
+    std::fprintf(stderr, "usage: keraunos_pcie_trace_decode [--csv] <trace.bin> [output]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool csv = false;
+    const char* in_path = nullptr;
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) csv = true;
+        else if (!in_path) in_path = argv[i];
+        else if (!out_path) out_path = argv[i];
+        else return usage();
+    }
+    if (!in_path) return usage();
+
+    std::FILE* in = std::fopen(in_path, "rb");
+    if (!in) {
+        std::fprintf(stderr, "cannot open %s\n", in_path);
+        return 1;
+    }
+    uint8_t header[TRACE_HEADER_SIZE];
+    uint64_t resolution_fs = 0;
+    if (std::fread(header, 1, sizeof(header), in) != sizeof(header) ||
+        !keraunos::pcie::trace_read_header(header, resolution_fs)) {
+        std::fprintf(stderr, "%s: not a version %u Keraunos PCIe trace\n",
+                     in_path, keraunos::pcie::TRACE_FORMAT_VERSION);
+        std::fclose(in);
+        return 1;
+    }
+    std::FILE* out = out_path ? std::fopen(out_path, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "cannot open %s\n", out_path);
+        std::fclose(in);
+        return 1;
+    }
+    if (csv) {
+        std::fprintf(out, "time,event,command,address,translated,length,response,route,tlb_entry,aux\n");
+    }
+
+    // Stream in chunks; a record never spans more than the carried-over tail
+    const double time_scale_ns = resolution_fs * 1e-6;
+    TraceCodec codec;
+    TraceRecord rec;
+    std::vector<uint8_t> buffer(1 << 20);
+    size_t filled = 0;
+    uint64_t records = 0;
+    bool eof = false;
+    while (!eof || filled) {
+        if (!eof) {
+            size_t n = std::fread(buffer.data() + filled, 1, buffer.size() - filled, in);
+            filled += n;
+            eof = (n == 0);
+        }
+        const uint8_t* p = buffer.data();
+        const uint8_t* end = p + filled;
+        while (codec.decode(p, end, rec)) {
+            if (csv) print_csv(out, rec); else print_text(out, rec, time_scale_ns);
+            records++;
+        }
+        size_t consumed = static_cast<size_t>(p - buffer.data());
+        if (consumed == 0 && eof) {
+            if (filled) std::fprintf(stderr, "warning: %zu trailing bytes (truncated record)\n", filled);
+            break;
+        }
+        std::memmove(buffer.data(), p, filled - consumed);
+        filled -= consumed;
+    }
+
+    std::fprintf(stderr, "%" PRIu64 " records\n", records);
+    if (out != stdout) std::fclose(out);
+    std::fclose(in);
+    return 0;
+}
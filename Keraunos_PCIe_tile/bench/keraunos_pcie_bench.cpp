@@ -0,0 +1,518 @@
+/*
+ * Microbenchmark suite for Keraunos PCIe Tile
+ *
+ * Builds against a stock open SystemC/TLM kernel (no scml2, no
+ * scml2_testing / FastBuild harness) and reports host ns/op and ops/sec.
+ *
+ * Component benchmarks (no kernel involvement):
+ * - TLB lookup() for each of the six TLBs
+ * - Switch decode: NocPcieSwitch, NocIoSwitch, SmnIoSwitch
+ * - MSI generation through MsiRelayUnit
+ *
+ * Each result also reports heap allocations per operation, counted by the
+ * replacement operator new below.
+ *
+ * End-to-end benchmarks (b_transport through the tile sockets):
+ * - Inbound app / sys / bypass, outbound app / sys / DBI
+ * - SMN config writes, MSI generation (receiver write to NOC MSI write)
+ *
+ * Workload mode (--workload SPEC) replaces the suites above with a
+ * TrafficGenerator driving a mixed, sustained load through all three target
+ * sockets, e.g. --workload inbound_app=4,outbound_app=2,msi=1,locality=random
+ *
+ * Sweep mode (--sweep SPEC) runs the same generator open loop at a series
+ * of offered loads (--loads, GB/s) against bandwidth-limited links behind
+ * the tile (--links) and prints a latency-vs-throughput CSV.
+ *
+ * Host mode (--host SPEC) puts PcieHostModel on both PCIe sockets: inbound
+ * TLP streams under flow-control credits and tags, outbound traffic (from
+ * --workload, if given) terminated with credit backpressure.
+ *
+ * Scaling mode (--scale SPEC) elaborates 1..64 tiles (--tiles) in one
+ * kernel, each with its own generator, and prints per-tile and aggregate
+ * throughput, elaboration time and resident memory as CSV.
+ *
+ * Usage: keraunos_pcie_bench [--iterations N] [--filter substring] [--csv]
+ *                            [--workload SPEC] [--host SPEC] [--links SPEC]
+ *                            [--sweep SPEC [--loads LIST] [--links SPEC]]
+ *                            [--scale SPEC [--tiles LIST] [--links SPEC]]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "keraunos_pcie_bench_harness.h"
+#include "keraunos_pcie_traffic_gen.h"
+#include "keraunos_pcie_load_sweep.h"
+#include "keraunos_pcie_multi_tile.h"
+#include "keraunos_pcie_host_model.h"
+
+using namespace keraunos::pcie;
+
+// Heap allocations made by this process, for allocs/op
+static std::atomic<uint64_t> allocation_count{0};
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    bool ok;
+};
+
+struct BenchOptions {
+    uint64_t iterations = 1000000;
+    std::string filter;
+    bool csv = false;
+    std::string workload;
+    std::string sweep;
+    std::string loads;
+    std::string links;
+    std::string scale;
+    std::string tiles;
+    std::string host;
+};
+
+BenchOptions options;
+std::vector<BenchResult> results;
+volatile uint64_t bench_sink;   // Keeps lookup results observable
+
+bool selected(const char* name) {
+    return options.filter.empty() || std::strstr(name, options.filter.c_str()) != nullptr;
+}
+
+// Runs op(i) for a tenth of the iterations as warm-up, then times the rest.
+// op returns false on a functional failure; the result is then flagged.
+template <typename Op>
+void run_bench(const char* name, uint64_t iterations, Op&& op) {
+    if (!selected(name)) return;
+    bool ok = true;
+    for (uint64_t i = 0; i < iterations / 10 + 1; i++) {
+        ok &= op(i);
+    }
+    const uint64_t allocations = allocation_count.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        op(i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    double allocs = static_cast<double>(allocation_count.load(std::memory_order_relaxed) - allocations);
+    results.push_back({name, iterations, ns / static_cast<double>(iterations),
+                       allocs / static_cast<double>(iterations), ok});
+}
+
+void print_results() {
+    if (options.csv) {
+        std::printf("benchmark,iterations,ns_per_op,ops_per_sec,allocs_per_op,ok\n");
+        for (const auto& r : results) {
+            std::printf("%s,%llu,%.2f,%.0f,%.3f,%d\n", r.name.c_str(),
+                        static_cast<unsigned long long>(r.iterations), r.ns_per_op,
+                        1e9 / r.ns_per_op, r.allocs_per_op, r.ok ? 1 : 0);
+        }
+        return;
+    }
+    std::printf("\n%-34s %12s %12s %14s %10s\n", "benchmark", "iterations", "ns/op", "ops/sec", "allocs/op");
+    for (const auto& r : results) {
+        std::printf("%-34s %12llu %12.2f %14.0f %10.3f%s\n", r.name.c_str(),
+                    static_cast<unsigned long long>(r.iterations), r.ns_per_op,
+                    1e9 / r.ns_per_op, r.allocs_per_op, r.ok ? "" : "  FAILED");
+    }
+}
+
+TlbEntry make_entry(uint64_t physical_addr, uint32_t attr = 0) {
+    TlbEntry entry;
+    entry.valid = true;
+    entry.addr = physical_addr >> 12;
+    entry.attr = attr;
+    return entry;
+}
+
+// Addresses that walk every entry of a TLB: entry index at bit 'shift'
+std::vector<uint64_t> entry_walk(unsigned shift, unsigned entries, uint64_t base = 0) {
+    std::vector<uint64_t> addrs(1024);
+    for (size_t i = 0; i < addrs.size(); i++) {
+        addrs[i] = base | (static_cast<uint64_t>(i % entries) << shift) | ((i * 0x40) & 0xFFF);
+    }
+    return addrs;
+}
+
+void ok_sink(Transaction& trans, SimTime&) {
+    trans.set_response_status(Response::Ok);
+}
+
+// ============================================================================
+// Component benchmarks
+// ============================================================================
+
+template <typename Tlb>
+void bench_inbound_lookup(const char* name, Tlb& tlb, unsigned shift, unsigned entries, uint64_t page) {
+    for (unsigned i = 0; i < entries; i++) {
+        tlb.configure_entry(static_cast<uint8_t>(i), make_entry((i + 1) * page, i));
+    }
+    std::vector<uint64_t> addrs = entry_walk(shift, entries);
+    run_bench(name, options.iterations, [&](uint64_t i) {
+        uint64_t translated = 0;
+        uint32_t axuser = 0;
+        bool hit = tlb.lookup(addrs[i & 1023], translated, axuser);
+        bench_sink = translated + axuser;
+        return hit;
+    });
+}
+
+template <typename Tlb>
+void bench_outbound_lookup(const char* name, Tlb& tlb, unsigned shift, unsigned entries, uint64_t page,
+                           uint64_t base = 0) {
+    for (unsigned i = 0; i < entries; i++) {
+        tlb.configure_entry(static_cast<uint8_t>(i), make_entry((i + 1) * page, i));
+    }
+    std::vector<uint64_t> addrs = entry_walk(shift, entries, base);
+    AxUser attr;
+    run_bench(name, options.iterations, [&](uint64_t i) {
+        uint64_t translated = 0;
+        bool hit = tlb.lookup(addrs[i & 1023], translated, attr);
+        bench_sink = translated;
+        return hit;
+    });
+}
+
+void bench_tlb_lookups() {
+    TLBSysIn0 sys_in0;
+    TLBAppIn0 app_in0;
+    TLBAppIn1 app_in1;
+    TLBSysOut0 sys_out0;
+    TLBAppOut0 app_out0;
+    TLBAppOut1 app_out1;
+    bench_inbound_lookup("tlb.sys_in0.lookup", sys_in0, 14, 64, 1ULL << 14);
+    bench_inbound_lookup("tlb.app_in0.lookup", app_in0, 24, 64, 1ULL << 24);
+    bench_inbound_lookup("tlb.app_in1.lookup", app_in1, 33, 64, 1ULL << 33);
+    bench_outbound_lookup("tlb.sys_out0.lookup", sys_out0, 16, 16, 1ULL << 16);
+    bench_outbound_lookup("tlb.app_out0.lookup", app_out0, 44, 16, 1ULL << 44);
+    bench_outbound_lookup("tlb.app_out1.lookup", app_out1, 16, 16, 1ULL << 16);
+}
+
+// Cycles a transaction through a fixed address set, resetting status each time
+template <typename Route>
+void bench_decode(const char* name, const std::vector<uint64_t>& addrs, Route&& route) {
+    uint8_t data[4] = {};
+    Transaction trans(Command::Write, 0, data, sizeof(data));
+    SimTime delay = 0;
+    run_bench(name, options.iterations, [&](uint64_t i) {
+        trans.set_address(addrs[i % addrs.size()]);
+        trans.set_response_status(Response::Incomplete);
+        route(trans, delay);
+        return trans.get_response_status() != Response::Incomplete;
+    });
+}
+
+void bench_switch_decode() {
+    NocPcieSwitch noc_pcie;
+    noc_pcie.set_tlb_app_inbound0_output(ok_sink);
+    noc_pcie.set_tlb_app_inbound1_output(ok_sink);
+    noc_pcie.set_tlb_sys_inbound_output(ok_sink);
+    noc_pcie.set_tlb_app_out0_output(ok_sink);
+    noc_pcie.set_tlb_app_out1_output(ok_sink);
+    noc_pcie.set_tlb_sys_out0_output(ok_sink);
+    noc_pcie.set_noc_io_output(ok_sink);
+    noc_pcie.set_smn_io_output(ok_sink);
+    noc_pcie.set_pcie_controller_output(ok_sink);
+    noc_pcie.set_msi_relay_output(ok_sink);
+    noc_pcie.set_config_reg_output(ok_sink);
+    noc_pcie.set_system_ready(true);
+    noc_pcie.set_pcie_inbound_app_enable(true);
+    noc_pcie.set_pcie_outbound_app_enable(true);
+    // Routes 0 (TLBAppIn0), 1 (TLBAppIn1), 4 (TLBSysIn0), 8/9 (bypass)
+    bench_decode("switch.noc_pcie.route_from_pcie",
+                 {0x0000000000001000ULL, 0x1000000000001000ULL, 0x4000000000001000ULL,
+                  0x8000000000001000ULL, 0x9000000000001000ULL},
+                 [&](auto& t, auto& d) { noc_pcie.route_from_pcie(t, d); });
+
+    NocIoSwitch noc_io;
+    noc_io.set_noc_n_output(ok_sink);
+    noc_io.set_tlb_app_output(ok_sink);
+    noc_io.set_msi_relay_output(ok_sink);
+    // MSI receiver, TLB App outbound window, AxADDR[51:48] TLB route, NOC-N default
+    bench_decode("switch.noc_io.route_from_noc",
+                 {0x18800000ULL, 0x18908000ULL, 0x1000000003000ULL, 0x20001000ULL},
+                 [&](auto& t, auto& d) { noc_io.route_from_noc(t, d); });
+
+    SmnIoSwitch smn_io;
+    smn_io.set_smn_n_output(ok_sink);
+    smn_io.set_tlb_sys_inbound_output(ok_sink);
+    smn_io.set_tlb_sys_outbound_output(ok_sink);
+    smn_io.set_config_reg_output(ok_sink);
+    smn_io.set_msi_relay_cfg_output(ok_sink);
+    smn_io.set_sii_config_output(ok_sink);
+    smn_io.set_serdes_apb_output(ok_sink);
+    smn_io.set_serdes_ahb_output(ok_sink);
+    smn_io.set_tlb_sys_in0_cfg_output(ok_sink);
+    for (int i = 0; i < 4; i++) smn_io.set_tlb_app_in0_cfg_output(i, ok_sink);
+    smn_io.set_tlb_app_in1_cfg_output(ok_sink);
+    smn_io.set_tlb_sys_out0_cfg_output(ok_sink);
+    smn_io.set_tlb_app_out0_cfg_output(ok_sink);
+    smn_io.set_tlb_app_out1_cfg_output(ok_sink);
+    // MSI CSR, TLB config windows, status registers, SII, TLBSysOut0 data, external
+    bench_decode("switch.smn_io.route_from_smn",
+                 {0x18000000ULL, 0x18041000ULL, 0x18044000ULL, 0x1804FFFCULL,
+                  0x18100000ULL, 0x18400000ULL, 0x18800000ULL},
+                 [&](auto& t, auto& d) { smn_io.route_from_smn(t, d); });
+}
+
+void bench_msi_relay() {
+    MsiRelayUnit relay;
+    uint64_t sent = 0;
+    relay.set_msi_output_callback([&sent](auto& t, auto&) {
+        sent++;
+        t.set_response_status(Response::Ok);
+    });
+    for (uint16_t v = 0; v < relay.get_vectors_per_pf(); v++) {
+        relay.write_msix_table(v, 0x80002000ULL + v * 4, 0x5600 + v, false);
+    }
+    relay.set_msix_enable(true);
+    relay.set_msix_mask(false);
+    const uint16_t vectors = relay.get_vectors_per_pf();
+    run_bench("msi.relay.generate", options.iterations, [&](uint64_t i) {
+        uint64_t before = sent;
+        bool taken = relay.write_msi_receiver(static_cast<uint32_t>(i % vectors)) == Response::Ok;
+        relay.process_pending_msis(i);
+        return taken && sent == before + 1;
+    });
+}
+
+// ============================================================================
+// End-to-end benchmarks through the tile sockets
+// ============================================================================
+
+class BenchHarness : public bench::TileHarness {
+public:
+    SC_HAS_PROCESS(BenchHarness);
+
+    explicit BenchHarness(sc_core::sc_module_name name) : TileHarness(name) {
+        SC_THREAD(run);
+    }
+
+    // One reused payload per path, as an initiator streaming traffic would
+    void bench_path(const char* name, InitiatorSocket& socket,
+                    tlm::tlm_command cmd, uint64_t base, uint64_t stride, uint64_t span) {
+        tlm::tlm_generic_payload trans;
+        uint32_t data = 0;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        trans.set_command(cmd);
+        trans.set_data_ptr(reinterpret_cast<unsigned char*>(&data));
+        trans.set_data_length(4);
+        trans.set_streaming_width(4);
+        run_bench(name, options.iterations / 4, [&](uint64_t i) {
+            trans.set_address(base + (i * stride) % span);
+            trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+            delay = sc_core::SC_ZERO_TIME;
+            socket->b_transport(trans, delay);
+            return trans.is_response_ok();
+        });
+    }
+
+    void run() {
+        reset_sequence();
+
+        configure_traffic_windows();
+        wait(sc_core::SC_ZERO_TIME);
+
+        bench_path("e2e.inbound_app.write", pcie_init, tlm::TLM_WRITE_COMMAND, 0x0ULL, 0x40, 0x1000000);
+        bench_path("e2e.inbound_app.read", pcie_init, tlm::TLM_READ_COMMAND, 0x0ULL, 0x40, 0x1000000);
+        bench_path("e2e.inbound_sys.write", pcie_init, tlm::TLM_WRITE_COMMAND, 0x4000000000000000ULL, 0x4, 0x4000);
+        bench_path("e2e.bypass_app.write", pcie_init, tlm::TLM_WRITE_COMMAND, 0x8000000000001000ULL, 0x40, 0x100000);
+        bench_path("e2e.outbound_app.write", noc_init, tlm::TLM_WRITE_COMMAND, 0x1000000000000ULL, 0x40, 0x100000);
+        bench_path("e2e.outbound_app.read", noc_init, tlm::TLM_READ_COMMAND, 0x1000000000000ULL, 0x40, 0x100000);
+        bench_path("e2e.outbound_sys.write", smn_init, tlm::TLM_WRITE_COMMAND, 0x18400000ULL, 0x4, 0x10000);
+        bench_path("e2e.outbound_dbi.write", noc_init, tlm::TLM_WRITE_COMMAND, 0x18900000ULL, 0x4, 0x10000);
+        // TLBAppIn1 entry 63 config words: exercises the SMN decode + TLB config write
+        bench_path("e2e.smn_config.write", smn_init, tlm::TLM_WRITE_COMMAND, 0x18048000ULL + 63 * 64 + 32, 0x4, 0x20);
+
+        bench_msi_e2e();
+        sc_core::sc_stop();
+    }
+
+    // Receiver write over NOC-N, then let the delivery process send the MSI write
+    void bench_msi_e2e() {
+        configure_msi_vector(0, 0x5678);
+        wait(sc_core::SC_ZERO_TIME);
+
+        run_bench("e2e.msi.generate", options.iterations / 4, [&](uint64_t) {
+            uint64_t before = msi_out_count;
+            uint32_t vector = 0;
+            bool ok = access(noc_init, tlm::TLM_WRITE_COMMAND, 0x18800000ULL, vector);
+            for (int delta = 0; ok && msi_out_count == before && delta < 4; delta++) {
+                wait(sc_core::SC_ZERO_TIME);
+            }
+            return ok && msi_out_count == before + 1;
+        });
+    }
+};
+
+void usage() {
+    std::fprintf(stderr, "usage: keraunos_pcie_bench [--iterations N] [--filter substring] [--csv]"
+                         " [--workload SPEC] [--host SPEC] [--links SPEC]\n"
+                         "       keraunos_pcie_bench --sweep SPEC [--loads a,b,...|start:stop:step]"
+                         " [--links SPEC]\n"
+                         "       keraunos_pcie_bench --scale SPEC [--tiles a,b,...] [--links SPEC]\n");
+    std::exit(2);
+}
+
+} // namespace
+
+int sc_main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            options.iterations = std::strtoull(argv[++i], nullptr, 0);
+            if (options.iterations < 4) usage();
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--csv") == 0) {
+            options.csv = true;
+        } else if (std::strcmp(argv[i], "--workload") == 0 && i + 1 < argc) {
+            options.workload = argv[++i];
+        } else if (std::strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            options.sweep = argv[++i];
+        } else if (std::strcmp(argv[i], "--loads") == 0 && i + 1 < argc) {
+            options.loads = argv[++i];
+        } else if (std::strcmp(argv[i], "--links") == 0 && i + 1 < argc) {
+            options.links = argv[++i];
+        } else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            options.scale = argv[++i];
+        } else if (std::strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+            options.tiles = argv[++i];
+        } else if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            options.host = argv[++i];
+        } else {
+            usage();
+        }
+    }
+    sc_core::sc_report_handler::set_actions(sc_core::SC_INFO, sc_core::SC_DO_NOTHING);
+
+    if (!options.sweep.empty()) {
+        bench::WorkloadSpec spec;
+        spec.poisson = true;    // Random arrivals show queueing below saturation
+        bench::LinkSpec links;
+        std::vector<double> loads;
+        std::string error;
+        if (!bench::parse_workload(options.sweep, spec, error) ||
+            !bench::parse_links(options.links, links, error) ||
+            (!options.loads.empty() && !bench::parse_loads(options.loads, loads, error))) {
+            std::fprintf(stderr, "--sweep: %s\n", error.c_str());
+            return 2;
+        }
+        if (spec.transactions == 0) {
+            std::fprintf(stderr, "--sweep: transactions=0 never finishes here\n");
+            return 2;
+        }
+        if (loads.empty()) loads = bench::default_loads(links);
+        return bench::run_load_sweep(spec, links, loads, stdout);
+    }
+
+    if (!options.scale.empty()) {
+        bench::WorkloadSpec spec;
+        bench::LinkSpec links;
+        std::string error;
+        if (!bench::parse_workload(options.scale, spec, error) ||
+            !bench::parse_links(options.links, links, error)) {
+            std::fprintf(stderr, "--scale: %s\n", error.c_str());
+            return 2;
+        }
+        if (spec.transactions == 0) {
+            std::fprintf(stderr, "--scale: transactions=0 never finishes here\n");
+            return 2;
+        }
+        std::vector<unsigned> tile_counts = bench::default_tile_counts();
+        if (!options.tiles.empty()) {
+            tile_counts.clear();
+            for (const char* p = options.tiles.c_str(); *p;) {
+                char* end = nullptr;
+                unsigned long count = std::strtoul(p, &end, 10);
+                if (end == p || count == 0 || (*end && *end != ',')) usage();
+                tile_counts.push_back(static_cast<unsigned>(count));
+                p = *end ? end + 1 : end;
+            }
+        }
+        return bench::run_multi_tile(spec, options.links.empty() ? nullptr : &links, tile_counts, stdout);
+    }
+
+    if (!options.workload.empty() || !options.host.empty()) {
+        bench::WorkloadSpec spec;
+        bench::HostSpec host_spec;
+        bench::LinkSpec links;
+        std::string error;
+        if (!bench::parse_workload(options.workload, spec, error)) {
+            std::fprintf(stderr, "--workload: %s\n", error.c_str());
+            return 2;
+        }
+        if (!bench::parse_host(options.host, host_spec, error)) {
+            std::fprintf(stderr, "--host: %s\n", error.c_str());
+            return 2;
+        }
+        if (!bench::parse_links(options.links, links, error)) {
+            std::fprintf(stderr, "--links: %s\n", error.c_str());
+            return 2;
+        }
+        if (!options.workload.empty() && spec.transactions == 0) {
+            std::fprintf(stderr, "--workload: transactions=0 never finishes here\n");
+            return 2;
+        }
+        bench::TileHarness tile("tile");
+        if (!options.links.empty()) bench::apply_links(tile, links);
+        std::unique_ptr<bench::TrafficGenerator> generator;
+        std::unique_ptr<bench::PcieHostModel> host;
+        if (!options.workload.empty()) {
+            generator.reset(new bench::TrafficGenerator("traffic", tile, spec));
+        }
+        if (!options.host.empty()) {
+            // Alongside a workload, the generator configures the tile and the host follows
+            if (generator) host_spec.setup = false;
+            host.reset(new bench::PcieHostModel("host", tile, host_spec));
+            if (generator) host->set_start_event(&generator->ready_event());
+            tile.pcie_host = host.get();
+        }
+        // The free-running clocks keep the kernel busy; advance until every driver is done
+        while ((generator && !generator->is_done()) || (host && !host->is_done())) {
+            sc_core::sc_start(10, sc_core::SC_US);
+        }
+        if (generator) generator->report(stdout);
+        if (host) host->report(stdout);
+        for (const auto* memory : {tile.noc_mem.get(), tile.smn_mem.get(), tile.pcie_mem.get()}) {
+            if (memory) memory->report(stdout);
+        }
+        return 0;
+    }
+
+    bench_tlb_lookups();
+    bench_switch_decode();
+    bench_msi_relay();
+
+    BenchHarness harness("bench");
+    sc_core::sc_start();
+
+    print_results();
+    for (const auto& r : results) {
+        if (!r.ok) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,273 @@
+#ifndef KERAUNOS_PCIE_BENCH_HARNESS_H
+#define KERAUNOS_PCIE_BENCH_HARNESS_H
+
+// Tile harness shared by the bench/ drivers (microbenchmarks, trace replay,
+// traffic generator)
+//
+// Owns one KeraunosPcieTile with every port bound: an initiator socket per
+// tile target socket, accept-everything sinks behind the tile initiator
+// sockets (optionally backed by SparseMemory endpoints), driven control
+// pins and the two clocks. Drivers derive from it and add their own
+// SC_THREAD.
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/simple_target_socket.h>
+#include <cstdint>
+#include <memory>
+#include "keraunos_pcie_tile.h"
+#include "keraunos_pcie_sparse_memory.h"
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+/**
+ * Downstream Link
+ * Single-server FIFO standing in for the fabric behind a tile initiator
+ * socket: an access arriving at sc_time_stamp() + delay starts once the
+ * link is free, holds it for length / bytes_per_ns and completes 'latency'
+ * after that. The defaults (no latency, unlimited bandwidth) leave the
+ * annotated delay untouched.
+ */
+struct DownstreamLink {
+    sc_core::sc_time latency = sc_core::SC_ZERO_TIME;
+    double bytes_per_ns = 0;                    // 0: unlimited
+    sc_core::sc_time busy_until = sc_core::SC_ZERO_TIME;
+
+    void serve(const tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+        if (bytes_per_ns <= 0 && latency == sc_core::SC_ZERO_TIME) return;
+        const sc_core::sc_time now = sc_core::sc_time_stamp();
+        sc_core::sc_time start = now + delay;
+        if (busy_until > start) start = busy_until;
+        busy_until = start;
+        if (bytes_per_ns > 0) {
+            busy_until += sc_core::sc_time(trans.get_data_length() / bytes_per_ns, sc_core::SC_NS);
+        }
+        delay = busy_until + latency - now;
+    }
+    // Time at which everything accepted so far has completed
+    [[nodiscard]] sc_core::sc_time drained_at() const { return busy_until + latency; }
+};
+
+class TileHarness : public sc_core::sc_module {
+public:
+    using InitiatorSocket = tlm_utils::simple_initiator_socket<TileHarness, 64>;
+    using TargetSocket = tlm_utils::simple_target_socket<TileHarness, 64>;
+
+    KeraunosPcieTile* dut;
+
+    // Drive the tile target sockets
+    InitiatorSocket noc_init;
+    InitiatorSocket smn_init;
+    InitiatorSocket pcie_init;
+    // Sinks behind the tile initiator sockets
+    TargetSocket noc_tgt;
+    TargetSocket smn_tgt;
+    TargetSocket pcie_tgt;
+
+    sc_core::sc_signal<bool> cold_reset_n, warm_reset_n, isolate_req;
+    sc_core::sc_signal<bool> pcie_cii_hv;
+    sc_core::sc_signal<sc_dt::sc_bv<5>> pcie_cii_hdr_type;
+    sc_core::sc_signal<sc_dt::sc_bv<12>> pcie_cii_hdr_addr;
+    sc_core::sc_signal<bool> pcie_controller_reset_n;
+    sc_core::sc_signal<bool> pcie_flr_request, pcie_hot_reset, pcie_ras_error;
+    sc_core::sc_signal<bool> pcie_dma_completion, pcie_misc_int;
+    sc_core::sc_signal<bool> function_level_reset, hot_reset_requested, config_update;
+    sc_core::sc_signal<bool> ras_error, dma_completion, controller_misc_int;
+    sc_core::sc_signal<sc_dt::sc_bv<3>> noc_timeout;
+    sc_core::sc_signal<uint8_t> pcie_app_bus_num, pcie_app_dev_num;
+    sc_core::sc_signal<bool> pcie_device_type, pcie_sys_int;
+    sc_core::sc_clock pcie_core_clk;
+    sc_core::sc_clock axi_clk;
+
+    // Accesses that left the tile, per initiator socket
+    uint64_t noc_out_count = 0;
+    uint64_t smn_out_count = 0;
+    uint64_t pcie_out_count = 0;
+    // NOC-N writes to this 4KB page count as generated MSIs
+    uint64_t msi_page = 0x80002000ULL;
+    uint64_t msi_out_count = 0;
+    // Fabric behind each initiator socket (see DownstreamLink)
+    DownstreamLink noc_link;
+    DownstreamLink smn_link;
+    DownstreamLink pcie_link;
+    // Endpoints behind the links once attach_memories() ran; otherwise the
+    // sinks just complete every access
+    std::unique_ptr<SparseMemory> noc_mem;      // Device memory
+    std::unique_ptr<SparseMemory> smn_mem;      // SMN fabric
+    std::unique_ptr<SparseMemory> pcie_mem;     // Host memory
+    // Replaces pcie_link and pcie_mem when set (e.g. PcieHostModel, which
+    // models the link itself and forwards data to pcie_mem)
+    tlm::tlm_blocking_transport_if<>* pcie_host = nullptr;
+
+    explicit TileHarness(sc_core::sc_module_name name)
+        : sc_module(name)
+        , noc_init("noc_init"), smn_init("smn_init"), pcie_init("pcie_init")
+        , noc_tgt("noc_tgt"), smn_tgt("smn_tgt"), pcie_tgt("pcie_tgt")
+        , pcie_core_clk("pcie_core_clk", 10, sc_core::SC_NS)
+        , axi_clk("axi_clk", 5, sc_core::SC_NS)
+    {
+        dut = new KeraunosPcieTile("dut");
+        noc_init.bind(dut->noc_n_target);
+        smn_init.bind(dut->smn_n_target);
+        pcie_init.bind(dut->pcie_controller_target);
+        dut->noc_n_initiator.bind(noc_tgt);
+        dut->smn_n_initiator.bind(smn_tgt);
+        dut->pcie_controller_initiator.bind(pcie_tgt);
+
+        dut->cold_reset_n(cold_reset_n);
+        dut->warm_reset_n(warm_reset_n);
+        dut->isolate_req(isolate_req);
+        dut->pcie_cii_hv(pcie_cii_hv);
+        dut->pcie_cii_hdr_type(pcie_cii_hdr_type);
+        dut->pcie_cii_hdr_addr(pcie_cii_hdr_addr);
+        dut->pcie_controller_reset_n(pcie_controller_reset_n);
+        dut->pcie_flr_request(pcie_flr_request);
+        dut->pcie_hot_reset(pcie_hot_reset);
+        dut->pcie_ras_error(pcie_ras_error);
+        dut->pcie_dma_completion(pcie_dma_completion);
+        dut->pcie_misc_int(pcie_misc_int);
+        dut->function_level_reset(function_level_reset);
+        dut->hot_reset_requested(hot_reset_requested);
+        dut->config_update(config_update);
+        dut->ras_error(ras_error);
+        dut->dma_completion(dma_completion);
+        dut->controller_misc_int(controller_misc_int);
+        dut->noc_timeout(noc_timeout);
+        dut->pcie_app_bus_num(pcie_app_bus_num);
+        dut->pcie_app_dev_num(pcie_app_dev_num);
+        dut->pcie_device_type(pcie_device_type);
+        dut->pcie_sys_int(pcie_sys_int);
+        dut->pcie_core_clk(pcie_core_clk);
+        dut->axi_clk(axi_clk);
+
+        noc_tgt.register_b_transport(this, &TileHarness::noc_b_transport);
+        smn_tgt.register_b_transport(this, &TileHarness::smn_b_transport);
+        pcie_tgt.register_b_transport(this, &TileHarness::pcie_b_transport);
+    }
+
+    ~TileHarness() override { delete dut; }
+
+    // Time at which every link has drained
+    [[nodiscard]] sc_core::sc_time links_drained_at() const {
+        sc_core::sc_time t = noc_link.drained_at();
+        if (smn_link.drained_at() > t) t = smn_link.drained_at();
+        if (pcie_link.drained_at() > t) t = pcie_link.drained_at();
+        return t;
+    }
+
+    // Sparse memories behind all three initiator sockets, with statistics
+    // regions for the windows configure_traffic_windows() sets up (call
+    // during elaboration)
+    void attach_memories(bool huge_pages = false) {
+        noc_mem.reset(new SparseMemory("device_mem", huge_pages));
+        noc_mem->add_region("app_in", 0x20000000ULL, 0x1000000);
+        noc_mem->add_region("msi", msi_page, 0x1000);
+        smn_mem.reset(new SparseMemory("smn_fabric", huge_pages));
+        smn_mem->add_region("sys_in", 0x18800000ULL, 0x4000);
+        pcie_mem.reset(new SparseMemory("host_mem", huge_pages));
+        pcie_mem->add_region("app_out", 0xA00000000000ULL, 0x100000);
+        pcie_mem->add_region("sys_out", 0x4000000000ULL, 0x10000);
+        pcie_mem->add_region("dbi", 0x9000000000ULL, 0x10000);
+    }
+
+    // Cold + controller reset pulse (call from a thread)
+    void reset_sequence() {
+        cold_reset_n.write(false);
+        pcie_controller_reset_n.write(false);
+        wait(50, sc_core::SC_NS);
+        cold_reset_n.write(true);
+        warm_reset_n.write(true);
+        pcie_controller_reset_n.write(true);
+        wait(50, sc_core::SC_NS);
+    }
+
+    bool access(InitiatorSocket& socket, tlm::tlm_command cmd, uint64_t addr, uint32_t& data) {
+        tlm::tlm_generic_payload trans;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        trans.set_command(cmd);
+        trans.set_address(addr);
+        trans.set_data_ptr(reinterpret_cast<unsigned char*>(&data));
+        trans.set_data_length(4);
+        trans.set_streaming_width(4);
+        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+        socket->b_transport(trans, delay);
+        return trans.is_response_ok();
+    }
+    bool smn_write(uint64_t addr, uint32_t value) {
+        return access(smn_init, tlm::TLM_WRITE_COMMAND, addr, value);
+    }
+
+    // Same layout the unit tests use: [0] valid + ADDR[31:12], [4] ADDR[63:32], [32] ATTR
+    void configure_tlb(uint32_t tlb_config_base, uint8_t index, uint64_t physical_addr, uint32_t attr) {
+        uint32_t entry = tlb_config_base + index * 64;
+        smn_write(entry + 0, static_cast<uint32_t>(physical_addr & 0xFFFFF000ULL) | 0x1);
+        smn_write(entry + 4, static_cast<uint32_t>(physical_addr >> 32));
+        smn_write(entry + 32, attr);
+    }
+
+    // system_ready plus inbound and outbound enables
+    void enable_system() {
+        smn_write(0x18040000 + 0x0FFFC, 0x1);
+        smn_write(0x18040000 + 0x0FFF8, 0x10001);
+    }
+
+    // Entry 0 of each TLB mapped for the standard bench paths, then enable_system().
+    // The traffic windows in keraunos_pcie_traffic_gen.h assume this layout.
+    void configure_traffic_windows() {
+        configure_tlb(0x18044000, 0, 0x20000000ULL, 0x123);     // TLBAppIn0[0] entry 0
+        configure_tlb(0x18043000, 0, 0x18800000ULL, 0x789);     // TLBSysIn0 entry 0 -> external SMN
+        configure_tlb(0x18041000, 0, 0xA00000000000ULL, 0);     // TLBAppOut0 entry 0
+        configure_tlb(0x18040000, 0, 0x4000000000ULL, 0);       // TLBSysOut0 entry 0
+        configure_tlb(0x18042000, 0, 0x9000000000ULL, 0);       // TLBAppOut1 entry 0 (DBI)
+        enable_system();
+    }
+
+    // MSI-X table entry 'vector' targets msi_page; enables MSI-X, unmasked
+    void configure_msi_vector(uint16_t vector, uint32_t data) {
+        const uint32_t entry = 0x18000000 + 0x2000 + vector * 16;
+        smn_write(entry + 0x0, static_cast<uint32_t>(msi_page) + vector * 4);
+        smn_write(entry + 0x4, static_cast<uint32_t>(msi_page >> 32));
+        smn_write(entry + 0x8, data);
+        smn_write(entry + 0xC, 0x0);
+        dut->set_msix_enable(true);
+        dut->set_msix_function_mask(false);
+    }
+
+private:
+    void noc_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+        noc_out_count++;
+        if ((trans.get_address() & ~0xFFFULL) == msi_page && trans.is_write()) msi_out_count++;
+        noc_link.serve(trans, delay);
+        complete(noc_mem.get(), trans, delay);
+    }
+    void smn_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+        smn_out_count++;
+        smn_link.serve(trans, delay);
+        complete(smn_mem.get(), trans, delay);
+    }
+    void pcie_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+        pcie_out_count++;
+        if (pcie_host) {
+            pcie_host->b_transport(trans, delay);
+            return;
+        }
+        pcie_link.serve(trans, delay);
+        complete(pcie_mem.get(), trans, delay);
+    }
+    static void complete(SparseMemory* memory, tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+        if (memory) {
+            memory->b_transport(trans, delay);
+        } else {
+            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        }
+    }
+};
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_BENCH_HARNESS_H
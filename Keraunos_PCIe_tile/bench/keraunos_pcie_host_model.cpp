@@ -0,0 +1,349 @@
+#include "keraunos_pcie_host_model.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+namespace {
+
+bool parse_u64(const std::string& text, uint64_t& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = std::strtoull(text.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+bool parse_u32(const std::string& text, uint32_t& value, uint64_t max = 0xFFFFFFFFULL) {
+    uint64_t n = 0;
+    if (!parse_u64(text, n) || n > max) return false;
+    value = static_cast<uint32_t>(n);
+    return true;
+}
+
+bool is_power_of_two(uint64_t v) { return v && !(v & (v - 1)); }
+
+double to_ns(const sc_core::sc_time& t) { return t.to_seconds() * 1e9; }
+
+} // namespace
+
+bool parse_host(const std::string& text, HostSpec& spec, std::string& error) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = text.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            error = "expected key=value: " + item;
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        uint32_t n = 0;
+        bool ok = true;
+
+        if (key == "gts") {
+            char* end = nullptr;
+            spec.gts = std::strtod(value.c_str(), &end);
+            ok = end != value.c_str() && *end == '\0' && spec.gts > 0;
+        } else if (key == "lanes") {
+            ok = parse_u32(value, n, 32) && (n == 1 || n == 2 || n == 4 || n == 8 || n == 16 || n == 32);
+            if (ok) spec.lanes = n;
+        } else if (key == "flight") {
+            ok = parse_sim_time(value, spec.flight);
+        } else if (key == "mps" || key == "mrrs") {
+            ok = parse_u32(value, n, 4096) && n >= 128 && is_power_of_two(n);
+            if (ok) (key == "mps" ? spec.mps : spec.mrrs) = n;
+        } else if (key == "tags") {
+            ok = parse_u32(value, n, 1024) && n >= 1;
+            if (ok) spec.tags = n;
+        } else if (key == "posted_hdr") {
+            ok = parse_u32(value, spec.posted_hdr);
+        } else if (key == "posted_data") {
+            ok = parse_u32(value, spec.posted_data);
+        } else if (key == "np_hdr") {
+            ok = parse_u32(value, spec.np_hdr);
+        } else if (key == "host_latency") {
+            ok = parse_sim_time(value, spec.host_latency);
+        } else if (key == "reads") {
+            ok = parse_u32(value, spec.read_percent, 100);
+        } else if (key == "size") {
+            ok = parse_u32(value, n, 0x100000) && n >= 4 && n % 4 == 0;
+            if (ok) spec.size = n;
+        } else if (key == "requests") {
+            ok = parse_u64(value, spec.requests);
+        } else if (key == "window") {
+            // Inbound windows set up by TileHarness::configure_traffic_windows()
+            if (value == "app") {
+                spec.base = 0x0;
+                spec.span = 0x1000000;
+            } else if (value == "bypass") {
+                spec.base = 0x8000000000001000ULL;
+                spec.span = 0x100000;
+            } else {
+                ok = false;
+            }
+        } else if (key == "quantum") {
+            ok = parse_sim_time(value, spec.quantum);
+        } else if (key == "seed") {
+            ok = parse_u64(value, spec.seed);
+        } else if (key == "setup") {
+            ok = parse_u32(value, n, 1);
+            if (ok) spec.setup = (n != 0);
+        } else {
+            error = "unknown host key: " + key;
+            return false;
+        }
+        if (!ok) {
+            error = "bad value for " + key + ": " + value;
+            return false;
+        }
+    }
+    if (spec.size > spec.span) {
+        error = "size larger than the inbound window";
+        return false;
+    }
+    return true;
+}
+
+sc_core::sc_time CreditPool::acquire(uint32_t n, sc_core::sc_time ready) {
+    if (!limit_ || !n) return ready;
+    if (n > limit_) n = limit_;
+    while (!pending_.empty() && (pending_.top().at <= ready || available_ < n)) {
+        const Return& top = pending_.top();
+        if (top.at > ready) ready = top.at;
+        available_ += top.credits;
+        pending_.pop();
+    }
+    available_ -= n;
+    return ready;
+}
+
+PcieHostModel::PcieHostModel(sc_core::sc_module_name name, TileHarness& tile, const HostSpec& spec)
+    : sc_module(name)
+    , tile_(tile)
+    , spec_(spec)
+    // Per direction, after 128b/130b encoding
+    , bytes_per_ns_(spec.gts * spec.lanes * 128.0 / 130.0 / 8.0)
+    , rng_(spec.seed)
+{
+    for (Receiver* rx : {&tile_rx_, &host_rx_}) {
+        rx->posted_hdr.set_limit(spec_.posted_hdr);
+        rx->posted_data.set_limit(spec_.posted_data);
+        rx->np_hdr.set_limit(spec_.np_hdr);
+        rx->tags.set_limit(spec_.tags);
+    }
+    SC_THREAD(run);
+}
+
+sc_core::sc_time PcieHostModel::acquire_posted(Receiver& rx, uint32_t length, sc_core::sc_time ready,
+                                               Stats& stats) {
+    sc_core::sc_time t = rx.posted_hdr.acquire(1, ready);
+    t = rx.posted_data.acquire(data_credits(length), t);
+    stats.credit_stall += t - ready;
+    return t;
+}
+
+sc_core::sc_time PcieHostModel::acquire_np(Receiver& rx, sc_core::sc_time ready, Stats& stats) {
+    sc_core::sc_time t = rx.tags.acquire(1, ready);
+    stats.tag_stall += t - ready;
+    const sc_core::sc_time tagged = t;
+    t = rx.np_hdr.acquire(1, t);
+    stats.credit_stall += t - tagged;
+    return t;
+}
+
+void PcieHostModel::run() {
+    if (spec_.setup) {
+        tile_.reset_sequence();
+        tile_.configure_traffic_windows();
+    } else if (start_event_) {
+        wait(*start_event_);
+    }
+    if (spec_.requests == 0) {
+        done_ = true;
+        return;
+    }
+
+    first_issue_ = sc_core::sc_time_stamp();
+    sc_core::sc_time local_offset = sc_core::SC_ZERO_TIME;
+    for (uint64_t i = 0; i < spec_.requests; i++) {
+        const bool read = rng_.below(100) < spec_.read_percent;
+        const uint64_t offset = cursor_;
+        cursor_ = (cursor_ + spec_.size) % spec_.span;
+        const uint64_t addr = spec_.base + (offset + spec_.size > spec_.span ? spec_.span - spec_.size : offset);
+
+        // Split at the max TLP size, never across a 4KB boundary
+        const uint32_t max_tlp = read ? spec_.mrrs : spec_.mps;
+        sc_core::sc_time t = sc_core::sc_time_stamp() + local_offset;
+        for (uint32_t done = 0; done < spec_.size;) {
+            const uint64_t tlp_addr = addr + done;
+            uint32_t length = std::min<uint32_t>(spec_.size - done, max_tlp);
+            length = static_cast<uint32_t>(std::min<uint64_t>(length, 0x1000 - (tlp_addr & 0xFFF)));
+            t = read ? inbound_read(tlp_addr, length, t) : inbound_write(tlp_addr, length, t);
+            done += length;
+        }
+        local_offset = t - sc_core::sc_time_stamp();
+        if (local_offset >= spec_.quantum) {
+            wait(local_offset);
+            local_offset = sc_core::SC_ZERO_TIME;
+        }
+    }
+    if (local_offset > sc_core::SC_ZERO_TIME) wait(local_offset);
+    if (last_completion_ > sc_core::sc_time_stamp()) wait(last_completion_ - sc_core::sc_time_stamp());
+    done_ = true;
+}
+
+// Returns the time the host may start on its next TLP (credits obtained)
+sc_core::sc_time PcieHostModel::inbound_write(uint64_t addr, uint32_t length, sc_core::sc_time ready) {
+    const sc_core::sc_time now = sc_core::sc_time_stamp();
+    const sc_core::sc_time t = acquire_posted(tile_rx_, length, ready, in_write_);
+    const sc_core::sc_time arrival = downstream_.send(wire_bytes(addr, length), t, bytes_per_ns_) + spec_.flight;
+
+    tlm::tlm_generic_payload* trans = pool_.acquire(tlm::TLM_WRITE_COMMAND, addr, length);
+    sc_core::sc_time delay = arrival - now;
+    tile_.pcie_init->b_transport(*trans, delay);
+    if (!trans->is_response_ok()) in_write_.errors++;
+    trans->release();
+
+    // The controller frees the buffer once the tile has taken the write; the
+    // UpdateFC reaches the host one flight later
+    const sc_core::sc_time accepted = now + delay;
+    tile_rx_.posted_hdr.release(1, accepted + spec_.flight);
+    tile_rx_.posted_data.release(data_credits(length), accepted + spec_.flight);
+    if (accepted > last_completion_) last_completion_ = accepted;
+    in_write_.tlps++;
+    in_write_.bytes += length;
+    return t;
+}
+
+sc_core::sc_time PcieHostModel::inbound_read(uint64_t addr, uint32_t length, sc_core::sc_time ready) {
+    const sc_core::sc_time now = sc_core::sc_time_stamp();
+    const sc_core::sc_time t = acquire_np(tile_rx_, ready, in_read_);
+    const sc_core::sc_time arrival = downstream_.send(wire_bytes(addr, 0), t, bytes_per_ns_) + spec_.flight;
+
+    tlm::tlm_generic_payload* trans = pool_.acquire(tlm::TLM_READ_COMMAND, addr, length);
+    sc_core::sc_time delay = arrival - now;
+    tile_.pcie_init->b_transport(*trans, delay);
+    if (!trans->is_response_ok()) in_read_.errors++;
+    trans->release();
+
+    const sc_core::sc_time serviced = now + delay;
+    tile_rx_.np_hdr.release(1, serviced + spec_.flight);
+    // Completions back upstream, MPS at a time; the tag frees with the last one
+    sc_core::sc_time last = serviced;
+    for (uint32_t sent = 0; sent < length;) {
+        const uint32_t n = std::min(length - sent, spec_.mps);
+        last = upstream_.send(wire_bytes(0, n), serviced, bytes_per_ns_) + spec_.flight;
+        sent += n;
+    }
+    tile_rx_.tags.release(1, last);
+    if (last > last_completion_) last_completion_ = last;
+    read_latency_.push_back((last - ready).value());
+    latency_sorted_ = false;
+    in_read_.tlps++;
+    in_read_.bytes += length;
+    return t;
+}
+
+void PcieHostModel::b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+    const sc_core::sc_time now = sc_core::sc_time_stamp();
+    const uint64_t addr = trans.get_address();
+    const uint32_t length = trans.get_data_length();
+    sc_core::sc_time t = now + delay;
+    sc_core::sc_time complete = t;
+
+    if (trans.is_write()) {
+        for (uint32_t done = 0; done < length;) {
+            const uint32_t n = std::min<uint32_t>(length - done, spec_.mps);
+            t = acquire_posted(host_rx_, n, t, out_write_);
+            complete = upstream_.send(wire_bytes(addr + done, n), t, bytes_per_ns_);
+            // The root port drains the write into host memory
+            const sc_core::sc_time drained = complete + spec_.flight + spec_.host_latency;
+            host_rx_.posted_hdr.release(1, drained + spec_.flight);
+            host_rx_.posted_data.release(data_credits(n), drained + spec_.flight);
+            out_write_.tlps++;
+            done += n;
+        }
+        out_write_.bytes += length;
+    } else if (trans.is_read()) {
+        for (uint32_t done = 0; done < length;) {
+            const uint32_t n = std::min<uint32_t>(length - done, spec_.mrrs);
+            t = acquire_np(host_rx_, t, out_read_);
+            const sc_core::sc_time serviced =
+                upstream_.send(wire_bytes(addr + done, 0), t, bytes_per_ns_) + spec_.flight + spec_.host_latency;
+            host_rx_.np_hdr.release(1, serviced + spec_.flight);
+            sc_core::sc_time last = serviced;
+            for (uint32_t sent = 0; sent < n;) {
+                const uint32_t c = std::min(n - sent, spec_.mps);
+                last = downstream_.send(wire_bytes(0, c), serviced, bytes_per_ns_) + spec_.flight;
+                sent += c;
+            }
+            host_rx_.tags.release(1, last);
+            if (last > complete) complete = last;
+            out_read_.tlps++;
+            done += n;
+        }
+        out_read_.bytes += length;
+    }
+
+    if (tile_.pcie_mem) {
+        sc_core::sc_time memory_delay = sc_core::SC_ZERO_TIME;     // host_latency stands for it
+        tile_.pcie_mem->b_transport(trans, memory_delay);
+    } else {
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+    if (!trans.is_response_ok()) (trans.is_read() ? out_read_ : out_write_).errors++;
+    delay = complete - now;
+}
+
+sc_core::sc_time PcieHostModel::get_read_latency_percentile(double percentile) {
+    if (read_latency_.empty()) return sc_core::SC_ZERO_TIME;
+    if (!latency_sorted_) {
+        std::sort(read_latency_.begin(), read_latency_.end());
+        latency_sorted_ = true;
+    }
+    // Nearest rank
+    double rank = percentile / 100.0 * static_cast<double>(read_latency_.size());
+    size_t index = rank <= 1.0 ? 0 : static_cast<size_t>(std::ceil(rank)) - 1;
+    if (index >= read_latency_.size()) index = read_latency_.size() - 1;
+    return sc_core::sc_time::from_value(read_latency_[index]);
+}
+
+void PcieHostModel::report(std::FILE* out) {
+    std::fprintf(out, "\n%s: %.1f GB/s per direction, MPS %u, MRRS %u, %u tags\n",
+                 name(), bytes_per_ns_, spec_.mps, spec_.mrrs, spec_.tags);
+    std::fprintf(out, "  %-16s %12s %14s %8s %16s %16s\n",
+                 "stream", "tlps", "bytes", "errors", "credit_stall_ns", "tag_stall_ns");
+    const struct { const char* name; const Stats& stats; } rows[] = {
+        {"inbound_write", in_write_}, {"inbound_read", in_read_},
+        {"outbound_write", out_write_}, {"outbound_read", out_read_},
+    };
+    for (const auto& row : rows) {
+        if (!row.stats.tlps) continue;
+        std::fprintf(out, "  %-16s %12" PRIu64 " %14" PRIu64 " %8" PRIu64 " %16.0f %16.0f\n",
+                     row.name, row.stats.tlps, row.stats.bytes, row.stats.errors,
+                     to_ns(row.stats.credit_stall), to_ns(row.stats.tag_stall));
+    }
+    const double span_ns = to_ns(last_completion_ - first_issue_);
+    if (span_ns > 0) {
+        std::fprintf(out, "inbound: %.3f GB/s over %.0f ns simulated",
+                     (in_write_.bytes + in_read_.bytes) / span_ns, span_ns);
+        if (!read_latency_.empty()) {
+            std::fprintf(out, ", read latency p50 %.0f ns, p99 %.0f ns",
+                         to_ns(get_read_latency_percentile(50.0)), to_ns(get_read_latency_percentile(99.0)));
+        }
+        std::fputc('\n', out);
+    }
+}
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
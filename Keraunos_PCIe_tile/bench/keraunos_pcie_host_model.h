@@ -0,0 +1,191 @@
+#ifndef KERAUNOS_PCIE_HOST_MODEL_H
+#define KERAUNOS_PCIE_HOST_MODEL_H
+
+// PCIe controller + host stand-in for the Keraunos PCIe tile
+//
+// Replaces the licensed controller IP model on both tile PCIe sockets:
+// drives inbound memory read/write TLP streams into pcie_controller_target
+// and terminates pcie_controller_initiator, with link serialisation, flow
+// control credits, tag-limited reads and MPS/MRRS splitting. Loosely
+// timed: every TLP is one b_transport whose timing comes from the credit,
+// tag and link state, not from extra SystemC processes.
+
+#include <systemc>
+#include <tlm>
+#include <cstdint>
+#include <cstdio>
+#include <queue>
+#include <string>
+#include <vector>
+#include "keraunos_pcie_bench_harness.h"
+#include "keraunos_pcie_payload_pool.h"
+#include "keraunos_pcie_traffic_gen.h"
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+/**
+ * Host / Link Description
+ * Text form (comma separated key=value, see parse_host):
+ *   reads=50,size=4096,requests=20000,mps=256,mrrs=512,tags=64
+ * Credits are per receiver, as advertised in InitFC: header credits count
+ * TLPs, data credits 16-byte units; 0 means infinite. Both ends advertise
+ * the same posted/non-posted credits here; completion credits are
+ * infinite at both ends, as for a root port and an endpoint that only
+ * issue requests they can absorb. Freed credits return one flight after
+ * the receiver drains the TLP (UpdateFC).
+ */
+struct HostSpec {
+    // Link: Gen5 x16 by default (32 GT/s per lane, 128b/130b)
+    double gts = 32.0;
+    unsigned lanes = 16;
+    sc_core::sc_time flight = sc_core::sc_time(100, sc_core::SC_NS);      // One-way PHY + controller pipeline
+    uint32_t mps = 256;
+    uint32_t mrrs = 512;
+    unsigned tags = 64;                         // Outstanding non-posted requests per direction
+    uint32_t posted_hdr = 128;
+    uint32_t posted_data = 2048;                // 32KB: covers the credit round trip at Gen5 x16
+    uint32_t np_hdr = 64;                       // Memory reads carry no data credits
+    sc_core::sc_time host_latency = sc_core::sc_time(400, sc_core::SC_NS);  // Host memory / root complex turnaround
+
+    // Inbound stream: requests of 'size' bytes, sequential within the window
+    uint32_t read_percent = 50;
+    uint32_t size = 4096;
+    uint64_t requests = 20000;                  // 0: no inbound traffic, only terminate outbound
+    uint64_t base = 0x0;                        // Inbound app window (configure_traffic_windows)
+    uint64_t span = 0x1000000;
+    sc_core::sc_time quantum = sc_core::sc_time(1, sc_core::SC_US);
+    uint64_t seed = 1;
+    bool setup = true;                          // Reset and configure the tile first
+};
+
+bool parse_host(const std::string& text, HostSpec& spec, std::string& error);
+
+/**
+ * Credit Pool
+ * Free credits plus the times at which consumed ones come back. acquire()
+ * returns the earliest time >= ready at which n credits are free; a request
+ * larger than the whole pool waits for all of it (as a receiver must
+ * accept a max-size TLP).
+ */
+class CreditPool {
+public:
+    void set_limit(uint32_t limit) {
+        limit_ = limit;
+        available_ = limit;
+        pending_ = {};
+    }
+    sc_core::sc_time acquire(uint32_t n, sc_core::sc_time ready);
+    void release(uint32_t n, const sc_core::sc_time& at) {
+        if (limit_) pending_.push({at, n});
+    }
+
+private:
+    struct Return {
+        sc_core::sc_time at;
+        uint32_t credits;
+        bool operator>(const Return& other) const { return at > other.at; }
+    };
+    uint32_t limit_ = 0;                        // 0: infinite
+    uint32_t available_ = 0;
+    std::priority_queue<Return, std::vector<Return>, std::greater<Return>> pending_;
+};
+
+/**
+ * PCIe Host Model
+ * Attach with tile.pcie_host = &host; drives tile.pcie_init from its own
+ * thread. Inbound writes become MPS-sized posted TLPs, inbound reads
+ * MRRS-sized requests (one tag each) whose data returns upstream as
+ * MPS-sized completions. Outbound accesses from the tile are split the
+ * same way against the host's receive credits; a posted write returns once
+ * its last TLP is on the link, a read once its last completion arrives, so
+ * credit and tag exhaustion shows up as backpressure on the tile. Data
+ * goes to tile.pcie_mem when attached.
+ */
+class PcieHostModel : public sc_core::sc_module, public tlm::tlm_blocking_transport_if<> {
+public:
+    struct Stats {
+        uint64_t tlps = 0;
+        uint64_t bytes = 0;                     // Payload
+        uint64_t errors = 0;
+        sc_core::sc_time credit_stall;          // Summed wait for credits
+        sc_core::sc_time tag_stall;             // Summed wait for a free tag
+    };
+
+    SC_HAS_PROCESS(PcieHostModel);
+
+    PcieHostModel(sc_core::sc_module_name name, TileHarness& tile, const HostSpec& spec);
+
+    // Wait for this event (e.g. TrafficGenerator::ready_event) instead of
+    // running setup; call during elaboration
+    void set_start_event(const sc_core::sc_event* event) noexcept { start_event_ = event; }
+
+    // Outbound: the tile's pcie_controller_initiator lands here
+    void b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) override;
+
+    [[nodiscard]] bool is_done() const noexcept { return done_; }
+    [[nodiscard]] double get_link_bytes_per_ns() const noexcept { return bytes_per_ns_; }
+    [[nodiscard]] const Stats& get_inbound_write_stats() const noexcept { return in_write_; }
+    [[nodiscard]] const Stats& get_inbound_read_stats() const noexcept { return in_read_; }
+    [[nodiscard]] const Stats& get_outbound_write_stats() const noexcept { return out_write_; }
+    [[nodiscard]] const Stats& get_outbound_read_stats() const noexcept { return out_read_; }
+    // Inbound read latency (request issue to last completion) percentile
+    [[nodiscard]] sc_core::sc_time get_read_latency_percentile(double percentile);
+
+    void report(std::FILE* out);
+
+private:
+    // One link direction: TLPs serialise at the link rate
+    struct Lane {
+        sc_core::sc_time busy_until;
+        // Departure end time of a TLP of wire_bytes ready at 'ready'
+        sc_core::sc_time send(uint32_t wire_bytes, const sc_core::sc_time& ready, double bytes_per_ns) {
+            sc_core::sc_time start = ready > busy_until ? ready : busy_until;
+            busy_until = start + sc_core::sc_time(wire_bytes / bytes_per_ns, sc_core::SC_NS);
+            return busy_until;
+        }
+    };
+
+    // Receive-side credits of one end
+    struct Receiver {
+        CreditPool posted_hdr, posted_data, np_hdr;
+        CreditPool tags;                        // Tags of the requester facing this receiver
+    };
+
+    TileHarness& tile_;
+    HostSpec spec_;
+    double bytes_per_ns_;
+    FastRng rng_;
+    PayloadPool pool_;
+    Lane downstream_;                           // Host -> tile
+    Lane upstream_;                             // Tile -> host
+    Receiver tile_rx_;                          // Controller receive buffers, host tags
+    Receiver host_rx_;                          // Root port receive buffers, controller tags
+    const sc_core::sc_event* start_event_ = nullptr;
+    bool done_ = false;
+    uint64_t cursor_ = 0;
+    sc_core::sc_time first_issue_, last_completion_;
+
+    Stats in_write_, in_read_, out_write_, out_read_;
+    std::vector<uint64_t> read_latency_;        // sc_time values
+    bool latency_sorted_ = false;
+
+    void run();
+    sc_core::sc_time inbound_write(uint64_t addr, uint32_t length, sc_core::sc_time ready);
+    sc_core::sc_time inbound_read(uint64_t addr, uint32_t length, sc_core::sc_time ready);
+    static sc_core::sc_time acquire_posted(Receiver& rx, uint32_t length, sc_core::sc_time ready, Stats& stats);
+    static sc_core::sc_time acquire_np(Receiver& rx, sc_core::sc_time ready, Stats& stats);
+    // Bytes on the wire: payload (DW padded) + header + sequence/LCRC + framing
+    static uint32_t wire_bytes(uint64_t addr, uint32_t payload) {
+        const uint32_t header = addr >> 32 ? 16 : 12;
+        return ((payload + 3) & ~3u) + header + 6 + 4;
+    }
+    static uint32_t data_credits(uint32_t length) { return (length + 15) / 16; }
+};
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_HOST_MODEL_H
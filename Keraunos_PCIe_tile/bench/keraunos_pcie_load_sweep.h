@@ -0,0 +1,61 @@
+#ifndef KERAUNOS_PCIE_LOAD_SWEEP_H
+#define KERAUNOS_PCIE_LOAD_SWEEP_H
+
+// Offered-load sweep: latency vs throughput for one or more tile paths
+//
+// Runs an open-loop TrafficGenerator at a series of offered loads against
+// a TileHarness whose initiator sockets feed bandwidth-limited links, and
+// writes one CSV row per load: achieved throughput and simulated-latency
+// percentiles, ready to plot as a latency-throughput curve.
+
+#include <systemc>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "keraunos_pcie_traffic_gen.h"
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+/**
+ * Fabric behind the tile for the sweep (one DownstreamLink per socket)
+ * Text form: noc=128,smn=4,pcie=64,noc_latency=50ns,pcie_latency=250ns
+ * Bandwidths in bytes/ns (= GB/s). Defaults: PCIe Gen5 x16 (~64 GB/s per
+ * direction), a 128 GB/s NOC port and a 4 GB/s SMN port; the latencies
+ * are placeholders to be replaced by the architects' numbers.
+ * memory=1 puts SparseMemory endpoints behind the links (huge_pages=1 for
+ * THP-backed chunks).
+ */
+struct LinkSpec {
+    double noc_bytes_per_ns = 128;
+    double smn_bytes_per_ns = 4;
+    double pcie_bytes_per_ns = 64;
+    sc_core::sc_time noc_latency = sc_core::sc_time(50, sc_core::SC_NS);
+    sc_core::sc_time smn_latency = sc_core::sc_time(100, sc_core::SC_NS);
+    sc_core::sc_time pcie_latency = sc_core::sc_time(250, sc_core::SC_NS);
+    bool memories = false;
+    bool huge_pages = false;
+};
+
+bool parse_links(const std::string& text, LinkSpec& links, std::string& error);
+
+// Link parameters and, if requested, memories onto a harness (during elaboration)
+void apply_links(TileHarness& tile, const LinkSpec& links);
+
+// "a,b,c" or "start:stop:step" in bytes/ns
+bool parse_loads(const std::string& text, std::vector<double>& loads, std::string& error);
+
+// 5% .. 125% of the PCIe link bandwidth, denser around saturation
+std::vector<double> default_loads(const LinkSpec& links);
+
+// Runs the whole sweep (spec.transactions per point) and writes the CSV to
+// out; elaborates its own tile, so call it once per process from sc_main
+int run_load_sweep(const WorkloadSpec& spec, const LinkSpec& links,
+                   const std::vector<double>& loads, std::FILE* out);
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_LOAD_SWEEP_H
@@ -0,0 +1,132 @@
+#include "keraunos_pcie_multi_tile.h"
+#include <chrono>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+namespace {
+
+// Current resident set in bytes (Linux /proc; 0 if unavailable)
+uint64_t resident_bytes() {
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    unsigned long size = 0, resident = 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &size, &resident);
+    std::fclose(statm);
+    return fields == 2 ? static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * One tile count, run in its own process
+ * Elaboration time covers constructing every harness and generator plus
+ * the first sc_start, where SystemC completes binding and runs the
+ * end_of_elaboration callbacks. Resident memory is sampled before and
+ * after it; the per-tile figure is the difference over N. Host throughput
+ * is transactions over the wall time of the whole run, since all tiles
+ * share one kernel thread.
+ */
+void run_tiles(const WorkloadSpec& spec, const LinkSpec* links, unsigned tiles, std::FILE* out) {
+    const uint64_t rss_before = resident_bytes();
+    const auto elab_start = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<TileHarness>> harnesses;
+    std::vector<std::unique_ptr<TrafficGenerator>> generators;
+    harnesses.reserve(tiles);
+    generators.reserve(tiles);
+    for (unsigned i = 0; i < tiles; i++) {
+        WorkloadSpec tile_spec = spec;
+        tile_spec.seed = spec.seed + i;
+        harnesses.emplace_back(new TileHarness(("tile_" + std::to_string(i)).c_str()));
+        if (links) apply_links(*harnesses.back(), *links);
+        generators.emplace_back(new TrafficGenerator(("traffic_" + std::to_string(i)).c_str(),
+                                                     *harnesses.back(), tile_spec));
+    }
+    sc_core::sc_start(sc_core::SC_ZERO_TIME);
+
+    const double elab_seconds = seconds_since(elab_start);
+    const uint64_t rss_after = resident_bytes();
+
+    const auto run_start = std::chrono::steady_clock::now();
+    // The free-running clocks keep the kernel busy; advance until every generator is done
+    for (bool done = false; !done;) {
+        sc_core::sc_start(10, sc_core::SC_US);
+        done = true;
+        for (const auto& generator : generators) done &= generator->is_done();
+    }
+    const double run_seconds = seconds_since(run_start);
+
+    const double rss_mb = rss_after / (1024.0 * 1024.0);
+    const double rss_per_tile_kb = rss_after > rss_before ? (rss_after - rss_before) / 1024.0 / tiles : 0.0;
+    uint64_t total_issued = 0, total_errors = 0, total_bytes = 0;
+    double total_sim_gbps = 0;
+    for (unsigned i = 0; i < tiles; i++) {
+        const TrafficGenerator& generator = *generators[i];
+        const uint64_t issued = generator.get_issued();
+        const double sim_ns = generator.get_sim_elapsed().to_seconds() * 1e9;
+        const double sim_gbps = sim_ns > 0 ? generator.get_bytes() / sim_ns : 0.0;
+        std::fprintf(out, "%u,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.3f,%.3f,%.3f,%.3f,%.1f,%.1f\n",
+                     tiles, i, issued, generator.get_errors(), generator.get_bytes(),
+                     run_seconds, issued / run_seconds * 1e-3, sim_gbps,
+                     elab_seconds, rss_mb, rss_per_tile_kb);
+        total_issued += issued;
+        total_errors += generator.get_errors();
+        total_bytes += generator.get_bytes();
+        total_sim_gbps += sim_gbps;
+    }
+    std::fprintf(out, "%u,all,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.3f,%.3f,%.3f,%.3f,%.1f,%.1f\n",
+                 tiles, total_issued, total_errors, total_bytes,
+                 run_seconds, total_issued / run_seconds * 1e-3, total_sim_gbps,
+                 elab_seconds, rss_mb, rss_per_tile_kb);
+    std::fflush(out);
+    std::fprintf(stderr, "%u tiles: elaboration %.3f s, %.1f KB/tile, %.0f ktxn/s aggregate\n",
+                 tiles, elab_seconds, rss_per_tile_kb, total_issued / run_seconds * 1e-3);
+}
+
+} // namespace
+
+std::vector<unsigned> default_tile_counts() {
+    return {1, 2, 4, 8, 16, 32, 64};
+}
+
+int run_multi_tile(const WorkloadSpec& spec, const LinkSpec* links,
+                   const std::vector<unsigned>& tile_counts, std::FILE* out) {
+    std::fprintf(out, "tiles,tile,transactions,errors,bytes,wall_s,ktxn_per_s,sim_gbps,"
+                      "elab_s,rss_mb,rss_per_tile_kb\n");
+    std::fflush(out);
+    std::fflush(stderr);
+    int status = 0;
+    for (unsigned tiles : tile_counts) {
+        const pid_t child = fork();
+        if (child < 0) {
+            std::perror("fork");
+            return 2;
+        }
+        if (child == 0) {
+            run_tiles(spec, links, tiles, out);
+            std::fflush(nullptr);
+            // Skip SystemC's static teardown; the parent only needs the exit status
+            _exit(0);
+        }
+        int child_status = 0;
+        if (waitpid(child, &child_status, 0) < 0 ||
+            !WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0) {
+            std::fprintf(stderr, "%u tiles: run failed\n", tiles);
+            status = 1;
+        }
+    }
+    return status;
+}
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
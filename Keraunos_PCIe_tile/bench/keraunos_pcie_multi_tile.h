@@ -0,0 +1,34 @@
+#ifndef KERAUNOS_PCIE_MULTI_TILE_H
+#define KERAUNOS_PCIE_MULTI_TILE_H
+
+// Multi-tile scaling: N tiles with independent traffic in one kernel
+//
+// Elaborates N TileHarness + TrafficGenerator pairs (generator i seeded
+// with spec.seed + i), runs them to completion and writes one CSV row per
+// tile plus an aggregate row: throughput, elaboration time and resident
+// memory. SystemC elaborates once per process, so each tile count runs in
+// a forked child.
+
+#include <cstdio>
+#include <vector>
+#include "keraunos_pcie_traffic_gen.h"
+#include "keraunos_pcie_load_sweep.h"
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+// 1, 2, 4, ... 64
+std::vector<unsigned> default_tile_counts();
+
+// Runs every tile count in turn and writes the CSV to out; returns non-zero
+// if a child failed. links, if given, is applied to every tile. Call before
+// anything has been elaborated.
+int run_multi_tile(const WorkloadSpec& spec, const LinkSpec* links,
+                   const std::vector<unsigned>& tile_counts, std::FILE* out);
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_MULTI_TILE_H
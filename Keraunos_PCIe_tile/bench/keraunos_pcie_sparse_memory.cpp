@@ -0,0 +1,242 @@
+#include "keraunos_pcie_sparse_memory.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+SparseMemory::SparseMemory(sc_core::sc_module_name name, bool huge_pages)
+    : sc_module(name)
+    , tgt("tgt")
+    , huge_pages_(huge_pages)
+{
+    regions_.push_back({"other", 0, ~0ULL, sc_core::SC_ZERO_TIME, 0, sc_core::SC_ZERO_TIME, {}});
+    tgt.register_b_transport(this, &SparseMemory::b_transport);
+    tgt.register_get_direct_mem_ptr(this, &SparseMemory::get_direct_mem_ptr);
+    tgt.register_transport_dbg(this, &SparseMemory::transport_dbg);
+}
+
+SparseMemory::~SparseMemory() {
+    for (const auto& entry : chunks_) {
+        munmap(entry.second, CHUNK_SIZE);
+    }
+}
+
+size_t SparseMemory::add_region(const std::string& name, uint64_t base, uint64_t size,
+                                const sc_core::sc_time& latency, double bytes_per_ns) {
+    regions_.push_back({name, base, base + size - 1, latency, bytes_per_ns, sc_core::SC_ZERO_TIME, {}});
+    return regions_.size() - 1;
+}
+
+void SparseMemory::set_default_timing(const sc_core::sc_time& latency, double bytes_per_ns) {
+    regions_[OTHER_REGION].latency = latency;
+    regions_[OTHER_REGION].bytes_per_ns = bytes_per_ns;
+}
+
+// Region holding [addr, addr + length); OTHER_REGION if none holds all of it
+size_t SparseMemory::find_region(uint64_t addr, uint64_t length) {
+    const uint64_t last = addr + (length ? length - 1 : 0);
+    const Region& cached = regions_[last_region_];
+    if (last_region_ != OTHER_REGION && addr >= cached.base && last <= cached.end) {
+        return last_region_;
+    }
+    for (size_t i = 1; i < regions_.size(); i++) {
+        if (addr >= regions_[i].base && last <= regions_[i].end) {
+            last_region_ = i;
+            return i;
+        }
+    }
+    return OTHER_REGION;
+}
+
+// 2MB-aligned so transparent huge pages can back the whole chunk
+uint8_t* SparseMemory::map_chunk() const {
+    void* raw = mmap(nullptr, 2 * CHUNK_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED) throw std::bad_alloc();
+    const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned = (start + CHUNK_SIZE - 1) & ~(CHUNK_SIZE - 1);
+    if (aligned > start) munmap(raw, aligned - start);
+    if (aligned + CHUNK_SIZE < start + 2 * CHUNK_SIZE) {
+        munmap(reinterpret_cast<void*>(aligned + CHUNK_SIZE), start + 2 * CHUNK_SIZE - aligned - CHUNK_SIZE);
+    }
+    uint8_t* base = reinterpret_cast<uint8_t*>(aligned);
+#ifdef MADV_HUGEPAGE
+    madvise(base, CHUNK_SIZE, huge_pages_ ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#endif
+    return base;
+}
+
+uint8_t* SparseMemory::find_chunk(uint64_t index) const {
+    if (index == last_chunk_) return last_chunk_ptr_;
+    auto it = chunks_.find(index);
+    if (it == chunks_.end()) return nullptr;
+    last_chunk_ = index;
+    last_chunk_ptr_ = it->second;
+    return it->second;
+}
+
+uint8_t* SparseMemory::get_chunk(uint64_t index) {
+    if (uint8_t* ptr = find_chunk(index)) return ptr;
+    uint8_t* ptr = map_chunk();
+    chunks_.emplace(index, ptr);
+    last_chunk_ = index;
+    last_chunk_ptr_ = ptr;
+    return ptr;
+}
+
+void SparseMemory::copy_out(uint64_t addr, unsigned char* data, size_t length) const {
+    while (length) {
+        const uint64_t offset = addr & (CHUNK_SIZE - 1);
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(length, CHUNK_SIZE - offset));
+        if (const uint8_t* base = find_chunk(addr >> CHUNK_BITS)) {
+            std::memcpy(data, base + offset, n);
+        } else {
+            std::memset(data, 0, n);
+        }
+        addr += n;
+        data += n;
+        length -= n;
+    }
+}
+
+void SparseMemory::copy_in(uint64_t addr, const unsigned char* data, size_t length,
+                           const unsigned char* byte_enable, unsigned int byte_enable_length) {
+    size_t done = 0;
+    while (done < length) {
+        const uint64_t offset = addr & (CHUNK_SIZE - 1);
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(length - done, CHUNK_SIZE - offset));
+        uint8_t* base = get_chunk(addr >> CHUNK_BITS);
+        if (!byte_enable) {
+            std::memcpy(base + offset, data + done, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                if (byte_enable[(done + i) % byte_enable_length] == tlm::TLM_BYTE_ENABLED) {
+                    base[offset + i] = data[done + i];
+                }
+            }
+        }
+        addr += n;
+        done += n;
+    }
+}
+
+void SparseMemory::read(uint64_t addr, void* data, size_t length) const {
+    copy_out(addr, static_cast<unsigned char*>(data), length);
+}
+
+void SparseMemory::write(uint64_t addr, const void* data, size_t length) {
+    copy_in(addr, static_cast<const unsigned char*>(data), length, nullptr, 0);
+}
+
+void SparseMemory::b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
+    const uint64_t addr = trans.get_address();
+    const unsigned int length = trans.get_data_length();
+    Region& region = regions_[find_region(addr, length)];
+
+    if (strict_ && &region == &regions_[OTHER_REGION]) {
+        region.stats.errors++;
+        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        return;
+    }
+    if (trans.get_streaming_width() < length) {
+        region.stats.errors++;
+        trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+        return;
+    }
+
+    if (trans.is_read()) {
+        copy_out(addr, trans.get_data_ptr(), length);
+        region.stats.reads++;
+        region.stats.read_bytes += length;
+    } else if (trans.is_write()) {
+        copy_in(addr, trans.get_data_ptr(), length,
+                trans.get_byte_enable_ptr(), trans.get_byte_enable_length());
+        region.stats.writes++;
+        region.stats.write_bytes += length;
+    }
+
+    if (region.bytes_per_ns > 0 || region.latency != sc_core::SC_ZERO_TIME) {
+        const sc_core::sc_time now = sc_core::sc_time_stamp();
+        sc_core::sc_time start = now + delay;
+        if (region.busy_until > start) start = region.busy_until;
+        region.busy_until = start;
+        if (region.bytes_per_ns > 0) {
+            region.busy_until += sc_core::sc_time(length / region.bytes_per_ns, sc_core::SC_NS);
+        }
+        delay = region.busy_until + region.latency - now;
+    }
+    trans.set_dmi_allowed(dmi_enabled_ && region.bytes_per_ns <= 0);
+    trans.set_response_status(tlm::TLM_OK_RESPONSE);
+}
+
+bool SparseMemory::get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi) {
+    const uint64_t addr = trans.get_address();
+    const size_t index = find_region(addr, 1);
+    Region& region = regions_[index];
+
+    uint64_t start = addr & ~(CHUNK_SIZE - 1);
+    uint64_t end = start + CHUNK_SIZE - 1;
+    if (start < region.base) start = region.base;
+    if (end > region.end) end = region.end;
+    // A chunk partly inside a named region would let DMI skip its accounting
+    bool overlaps = false;
+    if (index == OTHER_REGION) {
+        for (size_t i = 1; i < regions_.size(); i++) {
+            overlaps |= regions_[i].base <= end && regions_[i].end >= start;
+        }
+    }
+    dmi.set_start_address(start);
+    dmi.set_end_address(end);
+    if (!dmi_enabled_ || region.bytes_per_ns > 0 || overlaps ||
+        (strict_ && index == OTHER_REGION)) {
+        dmi.set_granted_access(tlm::tlm_dmi::DMI_ACCESS_NONE);
+        return false;
+    }
+
+    dmi.set_dmi_ptr(get_chunk(addr >> CHUNK_BITS) + (start & (CHUNK_SIZE - 1)));
+    dmi.set_granted_access(tlm::tlm_dmi::DMI_ACCESS_READ_WRITE);
+    dmi.set_read_latency(region.latency);
+    dmi.set_write_latency(region.latency);
+    region.stats.dmi_grants++;
+    return true;
+}
+
+unsigned int SparseMemory::transport_dbg(tlm::tlm_generic_payload& trans) {
+    const unsigned int length = trans.get_data_length();
+    if (trans.is_read()) {
+        copy_out(trans.get_address(), trans.get_data_ptr(), length);
+    } else if (trans.is_write()) {
+        copy_in(trans.get_address(), trans.get_data_ptr(), length, nullptr, 0);
+    }
+    return length;
+}
+
+void SparseMemory::reset_stats() {
+    for (Region& region : regions_) {
+        region.stats = RegionStats();
+        region.busy_until = sc_core::SC_ZERO_TIME;
+    }
+}
+
+void SparseMemory::report(std::FILE* out) const {
+    std::fprintf(out, "\n%s: %zu chunks mapped (%" PRIu64 " MB reserved)\n", name(), chunks_.size(),
+                 static_cast<uint64_t>(chunks_.size()) * (CHUNK_SIZE >> 20));
+    std::fprintf(out, "  %-12s %12s %12s %14s %14s %10s %8s\n",
+                 "region", "reads", "writes", "read_bytes", "write_bytes", "dmi", "errors");
+    for (const Region& region : regions_) {
+        const RegionStats& s = region.stats;
+        if (!s.reads && !s.writes && !s.dmi_grants && !s.errors) continue;
+        std::fprintf(out, "  %-12s %12" PRIu64 " %12" PRIu64 " %14" PRIu64 " %14" PRIu64 " %10" PRIu64 " %8" PRIu64 "\n",
+                     region.name.c_str(), s.reads, s.writes, s.read_bytes, s.write_bytes,
+                     s.dmi_grants, s.errors);
+    }
+}
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
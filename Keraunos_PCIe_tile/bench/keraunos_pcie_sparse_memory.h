@@ -0,0 +1,121 @@
+#ifndef KERAUNOS_PCIE_SPARSE_MEMORY_H
+#define KERAUNOS_PCIE_SPARSE_MEMORY_H
+
+// Sparse memory endpoint for the tile initiator sockets
+//
+// Stands in for Mimir-style device memory on NOC-N, the SMN fabric and host
+// memory behind the PCIe controller, so benchmarks measure the tile against
+// a target that actually stores data rather than a logging stub.
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_target_socket.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+/**
+ * Sparse Memory
+ * - Full 64-bit address space, backed by 2MB chunks mapped on first write
+ *   (anonymous MAP_NORESERVE mmap); the kernel then populates 4KB pages on
+ *   first touch, or whole 2MB pages when huge_pages is set (THP madvise)
+ * - Reads of never-written chunks return zero without mapping anything
+ * - Named regions carry their own access latency, bandwidth (a single-server
+ *   FIFO like DownstreamLink) and statistics; accesses outside every region
+ *   use the default timing and count under "other"
+ * - DMI: grants the 2MB chunk clipped to the access's region, with the
+ *   region latency; refused for bandwidth-limited regions, whose timing
+ *   DMI would bypass
+ * Byte enables are honoured; streaming bursts are rejected.
+ */
+class SparseMemory : public sc_core::sc_module {
+public:
+    using TargetSocket = tlm_utils::simple_target_socket<SparseMemory, 64>;
+
+    struct RegionStats {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t read_bytes = 0;
+        uint64_t write_bytes = 0;
+        uint64_t dmi_grants = 0;
+        uint64_t errors = 0;
+    };
+
+    static constexpr unsigned CHUNK_BITS = 21;
+    static constexpr uint64_t CHUNK_SIZE = 1ULL << CHUNK_BITS;
+    static constexpr size_t OTHER_REGION = 0;
+
+    // For direct binding; the bench harness calls b_transport() from its sinks instead
+    TargetSocket tgt;
+
+    explicit SparseMemory(sc_core::sc_module_name name, bool huge_pages = false);
+    ~SparseMemory() override;
+
+    SparseMemory(const SparseMemory&) = delete;
+    SparseMemory& operator=(const SparseMemory&) = delete;
+
+    // Regions must not overlap; returns the region index for get_region_stats()
+    size_t add_region(const std::string& name, uint64_t base, uint64_t size,
+                      const sc_core::sc_time& latency = sc_core::SC_ZERO_TIME,
+                      double bytes_per_ns = 0);
+    void set_default_timing(const sc_core::sc_time& latency, double bytes_per_ns);
+    void set_dmi_enabled(bool enabled) noexcept { dmi_enabled_ = enabled; }
+    // Accesses outside every region fail with TLM_ADDRESS_ERROR_RESPONSE
+    void set_strict(bool strict) noexcept { strict_ = strict; }
+
+    void b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi);
+    unsigned int transport_dbg(tlm::tlm_generic_payload& trans);
+
+    // Backdoor access, no timing or statistics
+    void read(uint64_t addr, void* data, size_t length) const;
+    void write(uint64_t addr, const void* data, size_t length);
+
+    [[nodiscard]] size_t get_region_count() const noexcept { return regions_.size(); }
+    [[nodiscard]] const std::string& get_region_name(size_t index) const { return regions_[index].name; }
+    [[nodiscard]] const RegionStats& get_region_stats(size_t index) const { return regions_[index].stats; }
+    [[nodiscard]] size_t get_mapped_chunks() const noexcept { return chunks_.size(); }
+    void reset_stats();
+    void report(std::FILE* out) const;
+
+private:
+    struct Region {
+        std::string name;
+        uint64_t base;
+        uint64_t end;           // Inclusive
+        sc_core::sc_time latency;
+        double bytes_per_ns;
+        sc_core::sc_time busy_until;
+        RegionStats stats;
+    };
+
+    std::vector<Region> regions_;       // [OTHER_REGION] covers everything else
+    std::unordered_map<uint64_t, uint8_t*> chunks_;
+    bool huge_pages_;
+    bool dmi_enabled_ = true;
+    bool strict_ = false;
+    // One-entry lookup caches; sequential traffic stays within a chunk/region
+    mutable uint64_t last_chunk_ = ~0ULL;
+    mutable uint8_t* last_chunk_ptr_ = nullptr;
+    size_t last_region_ = OTHER_REGION;
+
+    size_t find_region(uint64_t addr, uint64_t length);
+    uint8_t* map_chunk() const;
+    uint8_t* find_chunk(uint64_t index) const;     // nullptr if never written
+    uint8_t* get_chunk(uint64_t index);            // Maps it on first use
+    void copy_out(uint64_t addr, unsigned char* data, size_t length) const;
+    void copy_in(uint64_t addr, const unsigned char* data, size_t length,
+                 const unsigned char* byte_enable, unsigned int byte_enable_length);
+};
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_SPARSE_MEMORY_H
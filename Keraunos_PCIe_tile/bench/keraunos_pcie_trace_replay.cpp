@@ -0,0 +1,313 @@
+/*
+ * Trace replay for Keraunos PCIe Tile
+ *
+ * Memory-maps a binary trace recorded with KERAUNOS_PCIE_TRACE=1 and injects
+ * each target-socket record into the matching tile socket of a fresh tile:
+ * - noc_target -> noc_n_target, smn_target -> smn_n_target,
+ *   pcie_target -> pcie_controller_target
+ * - signal_change drives the recorded control pin (MSI-X bits via the tile
+ *   setters), set_bus_master_enable calls the tile setter
+ * - Internal hop and initiator records are skipped; the replayed tile
+ *   regenerates them
+ *
+ * Records are injected back-to-back by default, or at their recorded
+ * simulated times (--timed, relative to the first replayed record). Write
+ * data is the first four bytes carried in the record; payloads come from
+ * a PayloadPool so the replay loop itself does not allocate.
+ *
+ * Reports throughput and every response that differs from the recorded one.
+ * --check-read-data also compares the first four bytes of read data; this
+ * is only meaningful for tile-internal registers, since the replay sinks
+ * behind the initiator sockets return no data.
+ *
+ * Usage: keraunos_pcie_trace_replay [--timed] [--reset] [--check-read-data]
+ *                                   [--max-report N] <trace.bin>
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "keraunos_pcie_bench_harness.h"
+#include "keraunos_pcie_payload_pool.h"
+#include "keraunos_pcie_trace.h"
+
+using namespace keraunos::pcie;
+
+namespace {
+
+struct ReplayOptions {
+    const char* path = nullptr;
+    bool timed = false;
+    bool reset = false;
+    bool check_read_data = false;
+    uint64_t max_report = 10;
+};
+
+ReplayOptions options;
+
+/**
+ * Read-only private mapping of the whole trace file
+ */
+class MappedFile {
+public:
+    bool open(const char* path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // The mapping keeps the file referenced
+        if (addr == MAP_FAILED) return false;
+        ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(addr);
+        size_ = static_cast<size_t>(st.st_size);
+        return true;
+    }
+    ~MappedFile() {
+        if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+
+    [[nodiscard]] const uint8_t* data() const noexcept { return data_; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+const char* response_name(int response) {
+    switch (response) {
+        case tlm::TLM_OK_RESPONSE: return "OK";
+        case tlm::TLM_INCOMPLETE_RESPONSE: return "INCOMPLETE";
+        case tlm::TLM_GENERIC_ERROR_RESPONSE: return "GENERIC_ERROR";
+        case tlm::TLM_ADDRESS_ERROR_RESPONSE: return "ADDRESS_ERROR";
+        case tlm::TLM_COMMAND_ERROR_RESPONSE: return "COMMAND_ERROR";
+        case tlm::TLM_BURST_ERROR_RESPONSE: return "BURST_ERROR";
+        case tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE: return "BYTE_ENABLE_ERROR";
+        default: return "?";
+    }
+}
+
+class ReplayHarness : public bench::TileHarness {
+public:
+    SC_HAS_PROCESS(ReplayHarness);
+
+    ReplayHarness(sc_core::sc_module_name name, const uint8_t* begin, const uint8_t* end,
+                  uint64_t resolution_fs)
+        : TileHarness(name), begin_(begin), end_(end), resolution_fs_(resolution_fs), pool_(4)
+    {
+        SC_THREAD(run);
+    }
+
+    uint64_t records = 0;
+    uint64_t transactions[3] = {0, 0, 0};   // NOC-N, SMN-N, PCIe controller
+    uint64_t signal_changes = 0;
+    uint64_t skipped = 0;
+    uint64_t response_mismatches = 0;
+    uint64_t data_mismatches = 0;
+    bool truncated = false;
+    double wall_seconds = 0;
+    sc_core::sc_time sim_elapsed;
+
+    [[nodiscard]] uint64_t total_transactions() const noexcept {
+        return transactions[0] + transactions[1] + transactions[2];
+    }
+
+private:
+    const uint8_t* begin_;
+    const uint8_t* end_;
+    uint64_t resolution_fs_;
+    PayloadPool pool_;
+    bool have_origin_ = false;
+    uint64_t origin_record_time_ = 0;
+    sc_core::sc_time origin_;
+
+    void run() {
+        if (options.reset) {
+            reset_sequence();
+        }
+        sc_core::sc_time sim_start = sc_core::sc_time_stamp();
+        auto wall_start = std::chrono::steady_clock::now();
+
+        TraceCodec codec;
+        TraceRecord rec;
+        const uint8_t* p = begin_;
+        while (codec.decode(p, end_, rec)) {
+            records++;
+            if (options.timed) wait_until_recorded(rec);
+            switch (static_cast<TraceEvent>(rec.event)) {
+                case TraceEvent::NocTarget:  inject(noc_init, 0, rec); break;
+                case TraceEvent::SmnTarget:  inject(smn_init, 1, rec); break;
+                case TraceEvent::PcieTarget: inject(pcie_init, 2, rec); break;
+                case TraceEvent::SignalChange:
+                    drive_pin(rec);
+                    // Let the tile see this value before the next record can overwrite it
+                    wait(sc_core::SC_ZERO_TIME);
+                    break;
+                case TraceEvent::SetBusMasterEnable:
+                    dut->set_bus_master_enable(rec.aux != 0);
+                    signal_changes++;
+                    break;
+                default:
+                    skipped++;
+                    break;
+            }
+        }
+        truncated = (p != end_);
+
+        wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        sim_elapsed = sc_core::sc_time_stamp() - sim_start;
+        sc_core::sc_stop();
+    }
+
+    // Recorded times are relative to the first replayed record
+    void wait_until_recorded(const TraceRecord& rec) {
+        if (!have_origin_) {
+            have_origin_ = true;
+            origin_record_time_ = rec.sim_time;
+            origin_ = sc_core::sc_time_stamp();
+            return;
+        }
+        double offset_fs = static_cast<double>(rec.sim_time - origin_record_time_) * resolution_fs_;
+        sc_core::sc_time target = origin_ + sc_core::sc_time(offset_fs, sc_core::SC_FS);
+        if (target > sc_core::sc_time_stamp()) {
+            wait(target - sc_core::sc_time_stamp());
+        }
+    }
+
+    void inject(InitiatorSocket& socket, int index, const TraceRecord& rec) {
+        tlm::tlm_command cmd = static_cast<tlm::tlm_command>(rec.command);
+        unsigned int length = rec.length ? rec.length : 4;
+        tlm::tlm_generic_payload* trans = pool_.acquire(cmd, rec.address, length);
+        unsigned char* data = trans->get_data_ptr();
+        std::memset(data, 0, length);
+        if (cmd == tlm::TLM_WRITE_COMMAND) {
+            for (unsigned int i = 0; i < length && i < 4; i++) {
+                data[i] = static_cast<unsigned char>(rec.aux >> (8 * i));
+            }
+        }
+
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        socket->b_transport(*trans, delay);
+        transactions[index]++;
+
+        int response = trans->get_response_status();
+        if (response != rec.response) {
+            response_mismatches++;
+            if (response_mismatches <= options.max_report) {
+                std::printf("mismatch #%" PRIu64 ": record %" PRIu64 " %s %s 0x%016" PRIx64
+                            " len=%u: recorded %s, replayed %s\n",
+                            response_mismatches, records, trace_event_name(rec.event),
+                            cmd == tlm::TLM_READ_COMMAND ? "RD" : "WR", rec.address, rec.length,
+                            response_name(rec.response), response_name(response));
+            }
+        } else if (options.check_read_data && cmd == tlm::TLM_READ_COMMAND &&
+                   trans->is_response_ok() && trace_data_word(*trans) != rec.aux) {
+            data_mismatches++;
+            if (data_mismatches <= options.max_report) {
+                std::printf("read data #%" PRIu64 ": record %" PRIu64 " %s 0x%016" PRIx64
+                            ": recorded 0x%08X, replayed 0x%08X\n",
+                            data_mismatches, records, trace_event_name(rec.event), rec.address,
+                            rec.aux, trace_data_word(*trans));
+            }
+        }
+        trans->release();
+    }
+
+    void drive_pin(const TraceRecord& rec) {
+        signal_changes++;
+        bool level = rec.aux != 0;
+        switch (static_cast<TracePin>(rec.address)) {
+            case TracePin::ColdResetN: cold_reset_n.write(level); break;
+            case TracePin::WarmResetN: warm_reset_n.write(level); break;
+            case TracePin::IsolateReq: isolate_req.write(level); break;
+            case TracePin::PcieControllerResetN: pcie_controller_reset_n.write(level); break;
+            case TracePin::PcieCiiHv: pcie_cii_hv.write(level); break;
+            case TracePin::PcieCiiHdrType: pcie_cii_hdr_type.write(sc_dt::sc_bv<5>(rec.aux)); break;
+            case TracePin::PcieCiiHdrAddr: pcie_cii_hdr_addr.write(sc_dt::sc_bv<12>(rec.aux)); break;
+            case TracePin::PcieFlrRequest: pcie_flr_request.write(level); break;
+            case TracePin::PcieHotReset: pcie_hot_reset.write(level); break;
+            case TracePin::PcieRasError: pcie_ras_error.write(level); break;
+            case TracePin::PcieDmaCompletion: pcie_dma_completion.write(level); break;
+            case TracePin::PcieMiscInt: pcie_misc_int.write(level); break;
+            case TracePin::MsixEnable: dut->set_msix_enable(level); break;
+            case TracePin::MsixFunctionMask: dut->set_msix_function_mask(level); break;
+            default:
+                signal_changes--;
+                skipped++;
+                break;
+        }
+    }
+};
+
+void usage() {
+    std::fprintf(stderr, "usage: keraunos_pcie_trace_replay [--timed] [--reset] [--check-read-data]"
+                         " [--max-report N] <trace.bin>\n");
+    std::exit(2);
+}
+
+} // namespace
+
+int sc_main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--timed") == 0) {
+            options.timed = true;
+        } else if (std::strcmp(argv[i], "--reset") == 0) {
+            options.reset = true;
+        } else if (std::strcmp(argv[i], "--check-read-data") == 0) {
+            options.check_read_data = true;
+        } else if (std::strcmp(argv[i], "--max-report") == 0 && i + 1 < argc) {
+            options.max_report = std::strtoull(argv[++i], nullptr, 0);
+        } else if (argv[i][0] != '-' && !options.path) {
+            options.path = argv[i];
+        } else {
+            usage();
+        }
+    }
+    if (!options.path) usage();
+    sc_core::sc_report_handler::set_actions(sc_core::SC_INFO, sc_core::SC_DO_NOTHING);
+
+    MappedFile file;
+    if (!file.open(options.path)) {
+        std::fprintf(stderr, "cannot map %s\n", options.path);
+        return 1;
+    }
+    uint64_t resolution_fs = 0;
+    if (file.size() < TRACE_HEADER_SIZE || !trace_read_header(file.data(), resolution_fs)) {
+        std::fprintf(stderr, "%s: not a version %u Keraunos PCIe trace\n",
+                     options.path, TRACE_FORMAT_VERSION);
+        return 1;
+    }
+
+    ReplayHarness replay("replay", file.data() + TRACE_HEADER_SIZE, file.data() + file.size(),
+                         resolution_fs);
+    sc_core::sc_start();
+
+    const uint64_t txns = replay.total_transactions();
+    std::printf("\n%s: %" PRIu64 " records, %" PRIu64 " transactions"
+                " (noc %" PRIu64 ", smn %" PRIu64 ", pcie %" PRIu64 "),"
+                " %" PRIu64 " signal changes, %" PRIu64 " skipped\n",
+                options.path, replay.records, txns, replay.transactions[0], replay.transactions[1],
+                replay.transactions[2], replay.signal_changes, replay.skipped);
+    std::printf("mode %s: %.3f s wall, %.0f txn/s, %s simulated\n",
+                options.timed ? "timed" : "back-to-back", replay.wall_seconds,
+                replay.wall_seconds > 0 ? txns / replay.wall_seconds : 0.0,
+                replay.sim_elapsed.to_string().c_str());
+    std::printf("response mismatches: %" PRIu64 "\n", replay.response_mismatches);
+    if (options.check_read_data) {
+        std::printf("read data mismatches: %" PRIu64 "\n", replay.data_mismatches);
+    }
+    if (replay.truncated) {
+        std::fprintf(stderr, "warning: trailing bytes after the last complete record\n");
+    }
+    return (replay.response_mismatches || replay.data_mismatches) ? 1 : 0;
+}
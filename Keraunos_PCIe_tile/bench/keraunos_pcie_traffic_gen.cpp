@@ -0,0 +1,362 @@
+#include "keraunos_pcie_traffic_gen.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+namespace {
+
+const char* const class_names[] = {
+    "inbound_app", "inbound_sys", "inbound_bypass",
+    "outbound_app", "outbound_dbi",
+    "outbound_sys", "smn_config",
+    "msi"
+};
+static_assert(sizeof(class_names) / sizeof(class_names[0]) == static_cast<size_t>(TrafficClass::Count),
+              "class_names table out of sync with TrafficClass");
+
+bool parse_u64(const std::string& text, uint64_t& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = std::strtoull(text.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+bool is_power_of_two(uint64_t v) { return v && !(v & (v - 1)); }
+
+} // namespace
+
+bool parse_sim_time(const std::string& text, sc_core::sc_time& time) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0) return false;
+    std::string unit(end);
+    if (unit == "fs") time = sc_core::sc_time(value, sc_core::SC_FS);
+    else if (unit == "ps") time = sc_core::sc_time(value, sc_core::SC_PS);
+    else if (unit == "ns" || unit.empty()) time = sc_core::sc_time(value, sc_core::SC_NS);
+    else if (unit == "us") time = sc_core::sc_time(value, sc_core::SC_US);
+    else if (unit == "ms") time = sc_core::sc_time(value, sc_core::SC_MS);
+    else if (unit == "s") time = sc_core::sc_time(value, sc_core::SC_SEC);
+    else return false;
+    return true;
+}
+
+const char* traffic_class_name(TrafficClass cls) {
+    return (cls < TrafficClass::Count) ? class_names[static_cast<size_t>(cls)] : "?";
+}
+
+bool parse_workload(const std::string& text, WorkloadSpec& spec, std::string& error) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = text.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            error = "expected key=value: " + item;
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        uint64_t n = 0;
+        bool ok = true;
+
+        size_t cls = 0;
+        while (cls < spec.weights.size() && key != class_names[cls]) cls++;
+        if (cls < spec.weights.size()) {
+            ok = parse_u64(value, n) && n <= 0xFFFF;
+            if (ok) spec.weights[cls] = static_cast<uint32_t>(n);
+        } else if (key == "locality") {
+            if (value == "sequential") spec.locality = Locality::Sequential;
+            else if (value == "strided") spec.locality = Locality::Strided;
+            else if (value == "random") spec.locality = Locality::Random;
+            else ok = false;
+        } else if (key == "stride") {
+            ok = parse_u64(value, n) && n > 0;
+            if (ok) spec.stride = n;
+        } else if (key == "size") {
+            size_t dash = value.find('-');
+            uint64_t lo = 0, hi = 0;
+            ok = parse_u64(value.substr(0, dash), lo);
+            hi = lo;
+            if (ok && dash != std::string::npos) ok = parse_u64(value.substr(dash + 1), hi);
+            ok = ok && is_power_of_two(lo) && is_power_of_two(hi) && lo <= hi && hi <= 4096;
+            if (ok) {
+                spec.size_min = static_cast<uint32_t>(lo);
+                spec.size_max = static_cast<uint32_t>(hi);
+            }
+        } else if (key == "reads") {
+            ok = parse_u64(value, n) && n <= 100;
+            if (ok) spec.read_percent = static_cast<uint32_t>(n);
+        } else if (key == "msi_vectors") {
+            ok = parse_u64(value, n) && n >= 1 && n <= 16;
+            if (ok) spec.msi_vectors = static_cast<uint16_t>(n);
+        } else if (key == "transactions") {
+            ok = parse_u64(value, spec.transactions);
+        } else if (key == "gap") {
+            ok = parse_sim_time(value, spec.gap);
+        } else if (key == "load") {
+            char* end = nullptr;
+            double rate = std::strtod(value.c_str(), &end);
+            ok = end != value.c_str() && *end == '\0' && rate >= 0;
+            if (ok) spec.offered_bytes_per_ns = rate;
+        } else if (key == "arrivals") {
+            if (value == "fixed") spec.poisson = false;
+            else if (value == "poisson") spec.poisson = true;
+            else ok = false;
+        } else if (key == "open_loop") {
+            ok = parse_u64(value, n) && n <= 1;
+            if (ok) spec.open_loop = (n != 0);
+        } else if (key == "quantum") {
+            ok = parse_sim_time(value, spec.quantum);
+        } else if (key == "batch") {
+            ok = parse_u64(value, n) && n >= 1 && n <= 0xFFFFFFFF;
+            if (ok) spec.batch = static_cast<uint32_t>(n);
+        } else if (key == "seed") {
+            ok = parse_u64(value, spec.seed);
+        } else if (key == "setup") {
+            ok = parse_u64(value, n) && n <= 1;
+            if (ok) spec.setup = (n != 0);
+        } else {
+            error = "unknown workload key: " + key;
+            return false;
+        }
+        if (!ok) {
+            error = "bad value for " + key + ": " + value;
+            return false;
+        }
+    }
+    return true;
+}
+
+TrafficGenerator::TrafficGenerator(sc_core::sc_module_name name, TileHarness& tile, const WorkloadSpec& spec)
+    : sc_module(name)
+    , tile_(tile)
+    , spec_(spec)
+    , rng_(spec.seed)
+    , pool_(4)
+{
+    // Windows match TileHarness::configure_traffic_windows()
+    windows_[static_cast<size_t>(TrafficClass::InboundApp)] =
+        {&tile_.pcie_init, 0x0ULL, 0x1000000, true, false};                // TLBAppIn0 entry 0 (16MB)
+    windows_[static_cast<size_t>(TrafficClass::InboundSys)] =
+        {&tile_.pcie_init, 0x4000000000000000ULL, 0x4000, false, false};   // TLBSysIn0 entry 0 (16KB)
+    windows_[static_cast<size_t>(TrafficClass::InboundBypass)] =
+        {&tile_.pcie_init, 0x8000000000001000ULL, 0x100000, true, false};
+    windows_[static_cast<size_t>(TrafficClass::OutboundApp)] =
+        {&tile_.noc_init, 0x1000000000000ULL, 0x100000, true, false};      // TLBAppOut0 entry 0
+    windows_[static_cast<size_t>(TrafficClass::OutboundDbi)] =
+        {&tile_.noc_init, 0x18900000ULL, 0x10000, false, false};
+    windows_[static_cast<size_t>(TrafficClass::OutboundSys)] =
+        {&tile_.smn_init, 0x18400000ULL, 0x10000, false, false};           // TLBSysOut0
+    windows_[static_cast<size_t>(TrafficClass::SmnConfig)] =
+        {&tile_.smn_init, 0x18048000ULL + 63 * 64 + 32, 0x20, false, true};  // TLBAppIn1[63] ATTR words
+    windows_[static_cast<size_t>(TrafficClass::Msi)] =
+        {&tile_.noc_init, MSI_RELAY_MSI_BASE, 0x4, false, true};
+
+    for (size_t i = 0; i < cumulative_.size(); i++) {
+        total_weight_ += spec_.weights[i];
+        cumulative_[i] = total_weight_;
+    }
+    if (total_weight_ == 0) {  // An empty mix falls back to inbound app traffic
+        spec_.weights[static_cast<size_t>(TrafficClass::InboundApp)] = 1;
+        total_weight_ = 1;
+        for (auto& c : cumulative_) c = 1;
+    }
+    while ((spec_.size_min << (size_steps_ - 1)) < spec_.size_max) size_steps_++;
+    if (spec_.record_latency && spec_.transactions) {
+        latency_samples_.reserve(spec_.transactions);
+    }
+
+    if (spec_.autostart) {
+        SC_THREAD(run);
+    }
+}
+
+uint64_t TrafficGenerator::get_issued() const noexcept {
+    uint64_t total = 0;
+    for (const auto& s : stats_) total += s.issued;
+    return total;
+}
+
+uint64_t TrafficGenerator::get_errors() const noexcept {
+    uint64_t total = 0;
+    for (const auto& s : stats_) total += s.errors;
+    return total;
+}
+
+uint64_t TrafficGenerator::get_bytes() const noexcept {
+    uint64_t total = 0;
+    for (const auto& s : stats_) total += s.bytes;
+    return total;
+}
+
+void TrafficGenerator::reset_stats() {
+    stats_.fill(ClassStats{});
+    latency_samples_.clear();
+    samples_sorted_ = false;
+    wall_seconds_ = 0;
+    sim_elapsed_ = first_issue_ = last_issue_ = last_completion_ = sc_core::SC_ZERO_TIME;
+}
+
+sc_core::sc_time TrafficGenerator::get_latency_percentile(double percentile) {
+    if (latency_samples_.empty()) return sc_core::SC_ZERO_TIME;
+    if (!samples_sorted_) {
+        std::sort(latency_samples_.begin(), latency_samples_.end());
+        samples_sorted_ = true;
+    }
+    // Nearest rank
+    double rank = percentile / 100.0 * static_cast<double>(latency_samples_.size());
+    size_t index = rank <= 1.0 ? 0 : static_cast<size_t>(std::ceil(rank)) - 1;
+    if (index >= latency_samples_.size()) index = latency_samples_.size() - 1;
+    return sc_core::sc_time::from_value(latency_samples_[index]);
+}
+
+TrafficClass TrafficGenerator::pick_class() noexcept {
+    uint32_t r = rng_.below(total_weight_);
+    size_t cls = 0;
+    while (r >= cumulative_[cls]) cls++;
+    return static_cast<TrafficClass>(cls);
+}
+
+uint32_t TrafficGenerator::pick_size(const Window& window) noexcept {
+    if (!window.data_path) return 4;
+    return spec_.size_min << (size_steps_ > 1 ? rng_.below(size_steps_) : 0);
+}
+
+uint64_t TrafficGenerator::next_offset(TrafficClass cls, uint32_t size) noexcept {
+    const Window& window = windows_[static_cast<size_t>(cls)];
+    uint64_t& cursor = cursor_[static_cast<size_t>(cls)];
+    uint64_t offset;
+    switch (spec_.locality) {
+        case Locality::Random:
+            offset = rng_.next() & (window.span - 1);
+            break;
+        case Locality::Strided:
+            offset = cursor;
+            cursor = (cursor + spec_.stride) & (window.span - 1);
+            break;
+        case Locality::Sequential:
+        default:
+            offset = cursor;
+            cursor = (cursor + size) & (window.span - 1);
+            break;
+    }
+    // Naturally aligned and inside the window
+    offset &= ~static_cast<uint64_t>(size - 1);
+    if (offset + size > window.span) offset = window.span - size;
+    return offset;
+}
+
+void TrafficGenerator::setup() {
+    tile_.reset_sequence();
+    tile_.configure_traffic_windows();
+    for (uint16_t v = 0; v < spec_.msi_vectors; v++) {
+        tile_.configure_msi_vector(v, 0x5600 + v);
+    }
+    wait(sc_core::SC_ZERO_TIME);
+}
+
+void TrafficGenerator::run() {
+    if (spec_.setup) setup();
+    ready_event_.notify(sc_core::SC_ZERO_TIME);
+    generate(spec_.transactions);
+    done_ = true;
+    done_event_.notify();
+}
+
+void TrafficGenerator::generate(uint64_t transactions) {
+    const sc_core::sc_time sim_start = sc_core::sc_time_stamp();
+    const auto wall_start = std::chrono::steady_clock::now();
+    sc_core::sc_time local_offset = sc_core::SC_ZERO_TIME;
+    uint32_t since_yield = 0;
+    bool first = true;
+
+    for (uint64_t i = 0; !stop_requested_ && (transactions == 0 || i < transactions); i++) {
+        const TrafficClass cls = pick_class();
+        const Window& window = windows_[static_cast<size_t>(cls)];
+        const uint32_t size = pick_size(window);
+        const bool read = !window.write_only && rng_.below(100) < spec_.read_percent;
+
+        tlm::tlm_generic_payload* trans = pool_.acquire(
+            read ? tlm::TLM_READ_COMMAND : tlm::TLM_WRITE_COMMAND,
+            window.base + next_offset(cls, size), size);
+        if (cls == TrafficClass::Msi) {
+            uint32_t data = msi_vector_;
+            std::memcpy(trans->get_data_ptr(), &data, sizeof(data));
+            msi_vector_ = static_cast<uint16_t>((msi_vector_ + 1) % spec_.msi_vectors);
+        }
+
+        const sc_core::sc_time arrival = sc_core::sc_time_stamp() + local_offset;
+        sc_core::sc_time delay = spec_.open_loop ? local_offset : sc_core::SC_ZERO_TIME;
+        (*window.socket)->b_transport(*trans, delay);
+        const sc_core::sc_time latency = spec_.open_loop ? delay - local_offset : delay;
+
+        if (first) {
+            first_issue_ = arrival;
+            first = false;
+        }
+        last_issue_ = arrival;
+        if (arrival + latency > last_completion_) last_completion_ = arrival + latency;
+        if (spec_.record_latency) {
+            latency_samples_.push_back(latency.value());
+            samples_sorted_ = false;
+        }
+
+        ClassStats& stats = stats_[static_cast<size_t>(cls)];
+        stats.issued++;
+        stats.bytes += size;
+        if (read) stats.reads++;
+        if (!trans->is_response_ok()) stats.errors++;
+        trans->release();
+
+        // Loosely-timed: run ahead until a quantum's worth of time is owed
+        if (!spec_.open_loop) local_offset += latency;
+        double spacing_ns = spec_.offered_bytes_per_ns > 0 ? size / spec_.offered_bytes_per_ns
+                                                           : spec_.gap.to_seconds() * 1e9;
+        if (spec_.poisson) spacing_ns *= -std::log(1.0 - rng_.uniform());
+        local_offset += sc_core::sc_time(spacing_ns, sc_core::SC_NS);
+        if (local_offset >= spec_.quantum || ++since_yield >= spec_.batch) {
+            wait(local_offset);
+            local_offset = sc_core::SC_ZERO_TIME;
+            since_yield = 0;
+        }
+    }
+    wait(local_offset);
+
+    wall_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    sim_elapsed_ += sc_core::sc_time_stamp() - sim_start;
+}
+
+void TrafficGenerator::report(std::FILE* out) const {
+    std::fprintf(out, "\n%s: %-14s %12s %12s %14s %10s\n", name(), "class", "issued", "reads", "bytes", "errors");
+    for (size_t i = 0; i < stats_.size(); i++) {
+        const ClassStats& s = stats_[i];
+        if (!s.issued) continue;
+        std::fprintf(out, "%*s  %-14s %12" PRIu64 " %12" PRIu64 " %14" PRIu64 " %10" PRIu64 "\n",
+                     static_cast<int>(std::strlen(name())), "", class_names[i],
+                     s.issued, s.reads, s.bytes, s.errors);
+    }
+    const uint64_t issued = get_issued();
+    const double sim_seconds = sim_elapsed_.to_seconds();
+    std::fprintf(out, "%" PRIu64 " transactions in %.3f s wall (%.0f txn/s), %s simulated",
+                 issued, wall_seconds_, wall_seconds_ > 0 ? issued / wall_seconds_ : 0.0,
+                 sim_elapsed_.to_string().c_str());
+    if (sim_seconds > 0) {
+        std::fprintf(out, " (%.3f Mtxn/s simulated)", issued / sim_seconds * 1e-6);
+    }
+    std::fputc('\n', out);
+}
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
@@ -0,0 +1,211 @@
+#ifndef KERAUNOS_PCIE_TRAFFIC_GEN_H
+#define KERAUNOS_PCIE_TRAFFIC_GEN_H
+
+// Synthetic mixed-traffic generator for the Keraunos PCIe tile
+//
+// Drives all three tile target sockets of a TileHarness from a workload
+// description: a weighted mix of traffic classes, address locality within
+// each class's TLB window, transfer sizes and read/write ratio. Payloads
+// come from a PayloadPool and choices from a xoshiro256** PRNG, so the
+// generator adds no allocation and little host time of its own.
+
+#include <systemc>
+#include <tlm>
+#include <array>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "keraunos_pcie_bench_harness.h"
+#include "keraunos_pcie_payload_pool.h"
+
+namespace keraunos {
+namespace pcie {
+namespace bench {
+
+enum class TrafficClass : uint8_t {
+    InboundApp, InboundSys, InboundBypass,      // PCIe controller target
+    OutboundApp, OutboundDbi,                   // NOC-N target
+    OutboundSys, SmnConfig,                     // SMN-N target
+    Msi,                                        // NOC-N target, MSI receiver
+    Count
+};
+
+enum class Locality : uint8_t { Sequential, Strided, Random };
+
+const char* traffic_class_name(TrafficClass cls);
+
+/**
+ * Workload Description
+ * Text form (comma separated key=value, see parse_workload):
+ *   inbound_app=4,outbound_app=2,msi=1,locality=random,size=64-256,reads=30
+ */
+struct WorkloadSpec {
+    std::array<uint32_t, static_cast<size_t>(TrafficClass::Count)> weights{};  // Relative share
+    Locality locality = Locality::Sequential;
+    uint64_t stride = 0x1000;                   // Locality::Strided step
+    uint32_t size_min = 4;                      // Data paths: power-of-two sizes
+    uint32_t size_max = 4;                      //   in [size_min, size_max]
+    uint32_t read_percent = 50;                 // SMN config and MSI are always writes
+    uint16_t msi_vectors = 1;                   // MSI data cycles over vectors 0..n-1
+    uint64_t transactions = 100000;             // 0: run until stop()
+    sc_core::sc_time gap = sc_core::SC_ZERO_TIME;  // Offered-load spacing per transaction
+    double offered_bytes_per_ns = 0;            // If > 0, spacing = size / rate (replaces gap)
+    bool poisson = false;                       // Exponential spacing with the same mean
+    bool open_loop = false;                     // Issue at the offered rate regardless of completions
+    bool record_latency = false;                // Keep per-transaction latency samples
+    sc_core::sc_time quantum = sc_core::sc_time(1, sc_core::SC_US);
+    uint32_t batch = 64;                        // Delta-cycle yield interval at zero time
+    uint64_t seed = 1;
+    bool setup = true;                          // Reset and configure the tile first
+    bool autostart = true;                      // Run setup + transactions in the generator's own
+                                                // thread; otherwise a driver calls setup()/generate()
+};
+
+// Returns false and sets error on an unknown key or bad value; keys not
+// given keep their current value in spec
+bool parse_workload(const std::string& text, WorkloadSpec& spec, std::string& error);
+
+// "<number><unit>" with unit fs/ps/ns/us/ms/s; a bare number is ns
+bool parse_sim_time(const std::string& text, sc_core::sc_time& time);
+
+/**
+ * xoshiro256** (Blackman/Vigna), seeded through splitmix64
+ */
+class FastRng {
+public:
+    explicit FastRng(uint64_t seed = 1) { reseed(seed); }
+
+    void reseed(uint64_t seed) noexcept {
+        for (auto& word : s_) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+    uint64_t next() noexcept {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+    // Uniform in [0, 1)
+    double uniform() noexcept { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+    // Uniform in [0, bound) by multiply-shift (bias below 2^-32 for bench use)
+    uint32_t below(uint32_t bound) noexcept {
+        return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+    }
+
+private:
+    std::array<uint64_t, 4> s_;
+    static uint64_t rotl(uint64_t x, int k) noexcept { return (x << k) | (x >> (64 - k)); }
+};
+
+/**
+ * Traffic Generator
+ * Issues spec.transactions blocking transactions (or until stop()) on the
+ * harness initiator sockets. Transactions are spaced by spec.gap (or by
+ * size / spec.offered_bytes_per_ns) in a local time offset that is
+ * synchronised once it reaches spec.quantum; with zero spacing it still
+ * yields one delta cycle every spec.batch transactions so tile processes
+ * (MSI delivery, watchdog) keep running.
+ *
+ * Closed loop (default), each transaction also waits out the previous
+ * one's annotated delay. Open loop, the local offset is passed in as the
+ * arrival time and only the spacing advances it, which models an initiator
+ * with unlimited outstanding requests; latency is then the annotated delay
+ * beyond the arrival time, including any queueing in the harness links.
+ */
+class TrafficGenerator : public sc_core::sc_module {
+public:
+    struct ClassStats {
+        uint64_t issued = 0;
+        uint64_t reads = 0;
+        uint64_t bytes = 0;
+        uint64_t errors = 0;    // Response other than OK (MSI backpressure included)
+    };
+
+    SC_HAS_PROCESS(TrafficGenerator);
+
+    TrafficGenerator(sc_core::sc_module_name name, TileHarness& tile, const WorkloadSpec& spec);
+
+    // Driver interface when spec.autostart is false (call from a thread)
+    void setup();
+    void generate(uint64_t transactions);
+    void set_offered_load(double bytes_per_ns) noexcept { spec_.offered_bytes_per_ns = bytes_per_ns; }
+    void reset_stats();
+
+    void stop() noexcept { stop_requested_ = true; }
+    [[nodiscard]] bool is_done() const noexcept { return done_; }
+    [[nodiscard]] const sc_core::sc_event& done_event() const noexcept { return done_event_; }
+    // Notified once setup() has configured the tile (autostart only)
+    [[nodiscard]] const sc_core::sc_event& ready_event() const noexcept { return ready_event_; }
+
+    [[nodiscard]] const ClassStats& get_stats(TrafficClass cls) const noexcept {
+        return stats_[static_cast<size_t>(cls)];
+    }
+    [[nodiscard]] uint64_t get_issued() const noexcept;
+    [[nodiscard]] uint64_t get_errors() const noexcept;
+    // Wall time and simulated time of the traffic phase (setup excluded)
+    [[nodiscard]] double get_wall_seconds() const noexcept { return wall_seconds_; }
+    [[nodiscard]] sc_core::sc_time get_sim_elapsed() const noexcept { return sim_elapsed_; }
+    // Absolute simulated times of the first arrival, last arrival and last completion
+    [[nodiscard]] sc_core::sc_time get_first_issue() const noexcept { return first_issue_; }
+    [[nodiscard]] sc_core::sc_time get_last_issue() const noexcept { return last_issue_; }
+    [[nodiscard]] sc_core::sc_time get_last_completion() const noexcept { return last_completion_; }
+    [[nodiscard]] uint64_t get_bytes() const noexcept;
+    // Latency percentile (0..100) over the recorded samples; needs spec.record_latency
+    [[nodiscard]] sc_core::sc_time get_latency_percentile(double percentile);
+
+    void report(std::FILE* out) const;
+
+private:
+    struct Window {
+        TileHarness::InitiatorSocket* socket;
+        uint64_t base;
+        uint64_t span;          // Power of two
+        bool data_path;         // Uses spec sizes; otherwise 4-byte accesses
+        bool write_only;
+    };
+
+    TileHarness& tile_;
+    WorkloadSpec spec_;
+    FastRng rng_;
+    PayloadPool pool_;
+    std::array<Window, static_cast<size_t>(TrafficClass::Count)> windows_;
+    std::array<uint64_t, static_cast<size_t>(TrafficClass::Count)> cursor_{};
+    std::array<uint32_t, static_cast<size_t>(TrafficClass::Count)> cumulative_{};
+    std::array<ClassStats, static_cast<size_t>(TrafficClass::Count)> stats_{};
+    uint32_t total_weight_ = 0;
+    uint32_t size_steps_ = 1;
+    bool stop_requested_ = false;
+    bool done_ = false;
+    sc_core::sc_event done_event_;
+    sc_core::sc_event ready_event_;
+    double wall_seconds_ = 0;
+    sc_core::sc_time sim_elapsed_;
+    sc_core::sc_time first_issue_;
+    sc_core::sc_time last_issue_;
+    sc_core::sc_time last_completion_;
+    uint16_t msi_vector_ = 0;
+    std::vector<uint64_t> latency_samples_;     // sc_time values
+    bool samples_sorted_ = false;
+
+    void run();
+    TrafficClass pick_class() noexcept;
+    uint32_t pick_size(const Window& window) noexcept;
+    uint64_t next_offset(TrafficClass cls, uint32_t size) noexcept;
+};
+
+} // namespace bench
+} // namespace pcie
+} // namespace keraunos
+
+#endif // KERAUNOS_PCIE_TRAFFIC_GEN_H
@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+"""
+Performance regression gate for the Keraunos PCIe Tile benchmarks
+
+Runs keraunos_pcie_bench several times (the microbenchmark suite plus a
+fixed-seed load sweep), reduces every metric to its median over the runs
+and compares it with a stored baseline JSON:
+
+  <benchmark>.ns_per_op        host time per operation (noisy)
+  <benchmark>.allocs_per_op    heap allocations per operation
+  sweep.<load>.p50_ns/p99_ns/p999_ns
+                               simulated latency at a fixed offered load
+
+All metrics are lower-is-better and all of them gate. allocs/op for the
+fixed iteration count and the fixed-seed sweep percentiles must not get
+worse than the baseline at all (a per-metric 'tolerance' in the baseline
+can relax that). ns/op regresses when its median is worse by more than
+--tolerance AND by more than three standard deviations of run-to-run noise
+(MAD-based, baseline and current combined). ns/op is only comparable on the
+host that recorded the baseline; elsewhere pass --no-wall-clock to report
+it without gating.
+
+A baseline metric whose median is null has not been recorded yet. If it
+would gate, the check stops with a setup error before running anything,
+so a check against an unrecorded baseline can never pass. make
+perf-baseline on the reference host fills in every metric.
+
+Usage:
+  perf_check.py --bench ./keraunos_pcie_bench --baseline perf_baseline.json
+  perf_check.py ... --update        # record a new baseline
+Exit status: 0 pass, 1 regression, 2 setup error.
+"""
+
+import argparse
+import csv
+import io
+import json
+import math
+import platform
+import statistics
+import subprocess
+import sys
+
+DEFAULT_SWEEP = "inbound_app=2,outbound_app=1,size=64-256,reads=30,transactions=20000,seed=7"
+DEFAULT_LOADS = "16,32,48,57.6"
+MAD_TO_SIGMA = 1.4826
+NOISE_SIGMAS = 3.0
+# Relative slack for float round-off when comparing deterministic metrics
+EXACT_EPSILON = 1e-9
+
+
+def is_wall_clock(name):
+    """Host-time metrics; everything else is exact for a fixed seed and iteration count"""
+    return name.endswith(".ns_per_op")
+
+
+def run_csv(command, header):
+    """Run a bench command and return the CSV rows after its header line as dicts"""
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stderr)
+        raise RuntimeError("'%s' exited with %d" % (" ".join(command), result.returncode))
+    # Skip the SystemC banner and anything else printed before the table
+    text = result.stdout
+    start = text.find(header + ",")
+    if start < 0:
+        raise RuntimeError("'%s' printed no CSV table" % " ".join(command))
+    return list(csv.DictReader(io.StringIO(text[start:])))
+
+
+def suite_metrics(bench, iterations):
+    metrics = {}
+    for row in run_csv([bench, "--csv", "--iterations", str(iterations)], "benchmark"):
+        if row["ok"] != "1":
+            raise RuntimeError("benchmark %s reported a functional failure" % row["benchmark"])
+        metrics[row["benchmark"] + ".ns_per_op"] = float(row["ns_per_op"])
+        metrics[row["benchmark"] + ".allocs_per_op"] = float(row["allocs_per_op"])
+    return metrics
+
+
+def sweep_metrics(bench, spec, loads):
+    metrics = {}
+    for row in run_csv([bench, "--sweep", spec, "--loads", loads], "offered_gbps"):
+        label = "sweep.%g" % float(row["offered_gbps"])
+        for key in ("p50_ns", "p99_ns", "p999_ns"):
+            metrics["%s.%s" % (label, key)] = float(row[key])
+    return metrics
+
+
+def collect(args):
+    samples = {}
+    for run in range(args.runs):
+        sys.stderr.write("run %d/%d\n" % (run + 1, args.runs))
+        metrics = suite_metrics(args.bench, args.iterations)
+        if not args.no_sweep:
+            # Simulated latency is deterministic for a fixed seed; one sweep is enough
+            if run == 0:
+                metrics.update(sweep_metrics(args.bench, args.sweep, args.loads))
+        for name, value in metrics.items():
+            samples.setdefault(name, []).append(value)
+    return samples
+
+
+def summarize(samples):
+    summary = {}
+    for name, values in samples.items():
+        median = statistics.median(values)
+        mad = statistics.median([abs(v - median) for v in values])
+        summary[name] = {"median": median, "mad": mad, "samples": values}
+    return summary
+
+
+def is_gated(name, gate_wall_clock):
+    return gate_wall_clock or not is_wall_clock(name)
+
+
+def unrecorded_gated(baseline, gate_wall_clock):
+    """Gated baseline metrics without a recorded median"""
+    return sorted(name for name, entry in baseline.items()
+                  if entry.get("median") is None and is_gated(name, gate_wall_clock))
+
+
+def compare(current, baseline, wall_clock_tolerance, gate_wall_clock):
+    """Returns (rows, regressions); a row is (name, base, cur, change, verdict)"""
+    rows = []
+    regressions = 0
+    for name in sorted(set(baseline) | set(current)):
+        gated = is_gated(name, gate_wall_clock)
+        if name not in current:
+            rows.append((name, baseline[name]["median"], None, None, "MISSING" if gated else "info"))
+            if gated:
+                regressions += 1
+            continue
+        if name not in baseline:
+            rows.append((name, None, current[name]["median"], None, "new"))
+            continue
+        base = baseline[name]["median"]
+        cur = current[name]["median"]
+        if base is None:
+            # Only ungated metrics get here (unrecorded_gated() stops the check)
+            rows.append((name, None, cur, None, "unrecorded (info)"))
+            continue
+        if is_wall_clock(name):
+            tolerance = baseline[name].get("tolerance", wall_clock_tolerance)
+            noise = NOISE_SIGMAS * MAD_TO_SIGMA * math.hypot(baseline[name].get("mad", 0.0),
+                                                             current[name]["mad"])
+        else:
+            tolerance = baseline[name].get("tolerance", EXACT_EPSILON)
+            noise = 0.0
+        delta = cur - base
+        if base > 0:
+            change = delta / base
+        else:
+            change = 0.0 if cur == 0 else math.inf
+        if change > tolerance and delta > noise:
+            if gated:
+                verdict = "REGRESSION"
+                regressions += 1
+            else:
+                verdict = "slower (info)"
+        elif change < -tolerance and -delta > noise:
+            verdict = "improved"
+        else:
+            verdict = "ok"
+        rows.append((name, base, cur, change, verdict))
+    return rows, regressions
+
+
+def print_rows(rows):
+    def fmt(v):
+        return "-" if v is None else "%.3f" % v
+    print("%-48s %14s %14s %9s  %s" % ("metric", "baseline", "current", "change", "verdict"))
+    for name, base, cur, change, verdict in rows:
+        change_text = "-" if change is None else ("inf" if math.isinf(change) else "%+.1f%%" % (100 * change))
+        print("%-48s %14s %14s %9s  %s" % (name, fmt(base), fmt(cur), change_text, verdict))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Keraunos PCIe Tile performance regression gate")
+    parser.add_argument("--bench", default="./keraunos_pcie_bench", help="benchmark executable")
+    parser.add_argument("--baseline", default="perf_baseline.json", help="baseline JSON")
+    parser.add_argument("--runs", type=int, default=5, help="repeated runs per metric")
+    parser.add_argument("--iterations", type=int, default=200000, help="suite iterations per run")
+    parser.add_argument("--tolerance", type=float, default=0.05,
+                        help="allowed relative ns/op slowdown "
+                             "(per-metric 'tolerance' in the baseline wins)")
+    parser.add_argument("--no-wall-clock", action="store_true",
+                        help="report ns/op without gating it (hosts other than the baseline's)")
+    parser.add_argument("--sweep", default=DEFAULT_SWEEP, help="workload for the latency metrics")
+    parser.add_argument("--loads", default=DEFAULT_LOADS, help="offered loads (GB/s) for the latency metrics")
+    parser.add_argument("--no-sweep", action="store_true", help="skip the latency metrics")
+    parser.add_argument("--update", action="store_true", help="write the baseline instead of checking")
+    args = parser.parse_args()
+    if args.runs < 1:
+        parser.error("--runs must be at least 1")
+
+    gate_wall_clock = not args.no_wall_clock
+    if not args.update:
+        # Setup errors first: no point running the bench against an unusable baseline
+        try:
+            with open(args.baseline) as f:
+                document = json.load(f)
+        except (OSError, ValueError) as error:
+            sys.stderr.write("perf_check: cannot read baseline %s: %s\n"
+                             "record one on the reference host with --update (make perf-baseline)\n"
+                             % (args.baseline, error))
+            return 2
+        baseline = document.get("metrics", {})
+        if document.get("iterations") not in (None, args.iterations):
+            sys.stderr.write("perf_check: baseline was recorded with --iterations %s, not %d; "
+                             "allocs/op is not comparable\n" % (document["iterations"], args.iterations))
+            return 2
+        if args.no_sweep:
+            baseline = {k: v for k, v in baseline.items() if not k.startswith("sweep.")}
+        unrecorded = unrecorded_gated(baseline, gate_wall_clock)
+        if unrecorded:
+            sys.stderr.write("perf_check: %d gated metric(s) in %s have no recorded median:\n"
+                             % (len(unrecorded), args.baseline))
+            for name in unrecorded:
+                sys.stderr.write("  %s\n" % name)
+            sys.stderr.write("record them on the reference host with --update (make perf-baseline)\n")
+            return 2
+
+    try:
+        current = summarize(collect(args))
+    except (OSError, RuntimeError) as error:
+        sys.stderr.write("perf_check: %s\n" % error)
+        return 2
+
+    if args.update:
+        document = {
+            "schema": 2,
+            "host": platform.node(),
+            "machine": platform.machine(),
+            "runs": args.runs,
+            "iterations": args.iterations,
+            "sweep": None if args.no_sweep else {"workload": args.sweep, "loads": args.loads},
+            "metrics": {name: {"median": m["median"], "mad": m["mad"]} for name, m in current.items()},
+        }
+        with open(args.baseline, "w") as out:
+            json.dump(document, out, indent=2, sort_keys=True)
+            out.write("\n")
+        print("wrote %d metrics to %s" % (len(current), args.baseline))
+        return 0
+
+    rows, regressions = compare(current, baseline, args.tolerance, gate_wall_clock)
+    print_rows(rows)
+    if regressions:
+        print("\n%d metric(s) regressed" % regressions)
+        return 1
+    print("\nno regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
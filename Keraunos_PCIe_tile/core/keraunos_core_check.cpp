@@ -0,0 +1,164 @@
+/*
+ * Core-only functional check for libkeraunos_core
+ *
+ * Drives the components the way a functional simulator or firmware unit
+ * test would: plain Transaction/SimTime calls, no SystemC kernel, no TLM.
+ * Linked against libkeraunos_core.a only, so it also catches a core source
+ * picking up a SystemC dependency.
+ *
+ * - Inbound: TLBAppIn1 translates and hands off to NocIoSwitch::route_from_tlb,
+ *   which writes into a NOC-N memory stand-in; a miss answers AddressError
+ * - MSI: a receiver write routed by NocIoSwitch::route_from_noc reaches
+ *   MsiRelayUnit, which (once process_pending_msis() runs) sends the MSI
+ *   write back out through the switch to NOC-N
+ * - Receiver errors: out-of-range vectors, egress backpressure, isolation
+ *
+ * Usage: keraunos_core_check   (exit status 0 pass, 1 failure)
+ */
+
+#include "keraunos_pcie_noc_io_switch.h"
+#include "keraunos_pcie_inbound_tlb.h"
+#include "keraunos_pcie_msi_relay.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <map>
+
+using namespace keraunos::pcie;
+
+namespace {
+
+int checks = 0;
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    checks++;
+    if (!condition) {
+        failures++;
+        std::printf("FAIL: %s\n", what);
+    }
+}
+
+// NOC-N stand-in: 32-bit words by address, fixed access latency
+struct NocMemory {
+    std::map<uint64_t, uint32_t> words;
+    SimTime latency = 0;
+
+    void access(Transaction& trans, SimTime& delay) {
+        uint32_t word = 0;
+        if (trans.is_write()) {
+            std::memcpy(&word, trans.get_data_ptr(), sizeof(word));
+            words[trans.get_address()] = word;
+        } else {
+            auto it = words.find(trans.get_address());
+            word = (it != words.end()) ? it->second : 0;
+            std::memcpy(trans.get_data_ptr(), &word, sizeof(word));
+        }
+        delay += latency;
+        trans.set_response_status(Response::Ok);
+    }
+};
+
+Response write32(NocIoSwitch& sw, uint64_t address, uint32_t value, SimTime& delay) {
+    Transaction trans(Command::Write, address, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+    sw.route_from_noc(trans, delay);
+    return trans.get_response_status();
+}
+
+void check_inbound_tlb(NocIoSwitch& noc_io, NocMemory& noc_n) {
+    TLBAppIn1 tlb;
+    tlb.set_translated_output([&noc_io](Transaction& t, SimTime& d) { noc_io.route_from_tlb(t, d); });
+
+    // Entry 1: 8 GB page at 0x4_0000_0000 (ADDR[51:33] from the entry)
+    TlbEntry entry;
+    entry.valid = true;
+    entry.addr = 0x400000000ULL >> 12;
+    tlb.configure_entry(1, entry);
+
+    uint32_t value = 0xC0DE0001;
+    SimTime delay = 0;
+    Transaction hit(Command::Write, (1ULL << 33) | 0x40, reinterpret_cast<uint8_t*>(&value), 4);
+    tlb.process_inbound_traffic(hit, delay);
+    check(hit.is_response_ok(), "inbound write through TLBAppIn1 entry 1 completes");
+    check(hit.get_address() == 0x400000040ULL, "TLB translated the address in place");
+    check(noc_n.words[0x400000040ULL] == value, "translated write reached NOC-N");
+    check(delay == noc_n.latency, "NOC-N latency annotated on the inbound write");
+
+    Transaction miss(Command::Write, (5ULL << 33) | 0x40, reinterpret_cast<uint8_t*>(&value), 4);
+    tlb.process_inbound_traffic(miss, delay);
+    check(miss.get_response_status() == Response::AddressError, "invalid TLB entry answers AddressError");
+
+    uint32_t readback = 0;
+    Transaction read(Command::Read, (1ULL << 33) | 0x40, reinterpret_cast<uint8_t*>(&readback), 4);
+    tlb.process_inbound_traffic(read, delay);
+    check(read.is_response_ok() && readback == value, "inbound read returns the written word");
+}
+
+void check_msi_relay(NocIoSwitch& noc_io, NocMemory& noc_n) {
+    MsiRelayUnit relay(32, 2);
+    int notifications = 0;
+    noc_io.set_msi_relay_output([&relay](Transaction& t, SimTime& d) { relay.process_msi_input(t, d); });
+    relay.set_msi_output_callback([&noc_io](Transaction& t, SimTime& d) { noc_io.route_from_noc(t, d); });
+    relay.set_deliverable_callback([&notifications]() { notifications++; });
+
+    const uint16_t vec = 3;
+    const uint64_t target = 0x30000300;
+    relay.write_msix_table(vec, target, 0xAB, false, 1);
+    relay.set_msix_enable(true);
+    relay.set_msix_mask(false);
+
+    // Receiver write for PF1 vector 3 (receiver window 0x18800000 + pf * 0x4000)
+    SimTime delay = 0;
+    check(write32(noc_io, 0x18804000, vec, delay) == Response::Ok, "MSI receiver write accepted");
+    check(relay.is_pending(1, vec) && notifications == 1, "vector pending, owner notified once");
+    check(noc_n.words.count(target) == 0, "nothing sent before process_pending_msis()");
+    relay.process_pending_msis(0);
+    check(noc_n.words[target] == 0xAB, "MSI write delivered to NOC-N");
+    check(!relay.is_pending(1, vec) && !relay.has_deliverable(), "PBA bit cleared by delivery");
+
+    // Out-of-range vector / PF: decode error, never backpressure
+    check(write32(noc_io, 0x18804000, 32, delay) == Response::AddressError, "out-of-range vector rejected");
+    check(write32(noc_io, 0x18808000, vec, delay) == Response::AddressError, "unpopulated PF rejected");
+    check(relay.get_backpressure_count() == 0, "range errors not counted as backpressure");
+
+    // Egress FIFO of one with a slow NOC-N: the second new vector is pushed back
+    relay.set_egress_limits(1, 1);
+    relay.write_msix_table(4, target + 0x10, 0xAC, false, 1);
+    noc_n.latency = 10000000;   // 10 us
+    check(write32(noc_io, 0x18804000, vec, delay) == Response::Ok, "first MSI of the slow batch accepted");
+    relay.process_pending_msis(0);
+    check(relay.get_in_flight() == 1 && relay.get_next_wakeup_tick() != MsiRelayUnit::NO_WAKEUP,
+          "MSI write in flight until its completion tick");
+    check(write32(noc_io, 0x18804000, 4, delay) == Response::GenericError, "full egress FIFO pushes back");
+    check(relay.get_backpressure_count() == 1, "backpressure counted");
+    relay.process_pending_msis(relay.get_next_wakeup_tick());
+    check(relay.get_egress_occupancy() == 0, "completion retires the in-flight MSI");
+    check(write32(noc_io, 0x18804000, 4, delay) == Response::Ok, "receiver accepts once drained");
+    noc_n.latency = 0;
+
+    // Isolation: the MSI write fails and the vector stays pending until released
+    relay.process_pending_msis(relay.get_next_wakeup_tick());
+    noc_n.words.erase(target);
+    check(write32(noc_io, 0x18804000, vec, delay) == Response::Ok, "receiver write before isolation");
+    noc_io.set_isolate_req(true);
+    relay.process_pending_msis(relay.get_next_wakeup_tick());
+    check(relay.is_pending(1, vec) && noc_n.words.count(target) == 0, "isolated MSI stays pending");
+    noc_io.set_isolate_req(false);
+    noc_io.set_timeout_write(false);
+    relay.process_pending_msis(relay.get_next_wakeup_tick());
+    check(noc_n.words[target] == 0xAB && !relay.is_pending(1, vec), "pending MSI delivered after isolation");
+}
+
+} // namespace
+
+int main() {
+    NocMemory noc_n;
+    NocIoSwitch noc_io;
+    noc_io.set_noc_n_output([&noc_n](Transaction& t, SimTime& d) { noc_n.access(t, d); });
+
+    check_inbound_tlb(noc_io, noc_n);
+    check_msi_relay(noc_io, noc_n);
+
+    std::printf("%d checks, %d failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
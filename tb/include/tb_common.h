@@ -4,7 +4,9 @@
 #include <systemc>
 #include <tlm>
 #include <scml2.h>
+#include "keraunos_pcie_payload_pool.h"
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <map>
@@ -53,49 +55,32 @@ protected:
 };
 
 // Transaction generator helper
+// Payloads and data buffers come from a shared PayloadPool; release_transaction()
+// drops the generator's reference and the payload returns to the pool.
 class TransactionGenerator {
 public:
     static tlm::tlm_generic_payload* create_read_transaction(
         uint64_t addr, unsigned int length = 4) {
-        tlm::tlm_generic_payload* trans = new tlm::tlm_generic_payload();
-        uint8_t* data = new uint8_t[length];
-        
-        trans->set_command(tlm::TLM_READ_COMMAND);
-        trans->set_address(addr);
-        trans->set_data_ptr(data);
-        trans->set_data_length(length);
-        trans->set_streaming_width(length);
-        trans->set_byte_enable_ptr(nullptr);
-        trans->set_dmi_allowed(false);
-        trans->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
-        
-        return trans;
+        return pool().acquire(tlm::TLM_READ_COMMAND, addr, length);
     }
     
     static tlm::tlm_generic_payload* create_write_transaction(
         uint64_t addr, const uint8_t* data, unsigned int length = 4) {
-        tlm::tlm_generic_payload* trans = new tlm::tlm_generic_payload();
-        uint8_t* trans_data = new uint8_t[length];
-        memcpy(trans_data, data, length);
-        
-        trans->set_command(tlm::TLM_WRITE_COMMAND);
-        trans->set_address(addr);
-        trans->set_data_ptr(trans_data);
-        trans->set_data_length(length);
-        trans->set_streaming_width(length);
-        trans->set_byte_enable_ptr(nullptr);
-        trans->set_dmi_allowed(false);
-        trans->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
-        
+        tlm::tlm_generic_payload* trans = pool().acquire(tlm::TLM_WRITE_COMMAND, addr, length);
+        memcpy(trans->get_data_ptr(), data, length);
         return trans;
     }
     
     static void release_transaction(tlm::tlm_generic_payload* trans) {
         if (trans) {
-            delete[] trans->get_data_ptr();
-            delete trans;
+            trans->release();
         }
     }
+    
+    static PayloadPool& pool() {
+        static PayloadPool payload_pool;
+        return payload_pool;
+    }
 };
 
 // TransactionMonitor is defined in tb_monitor.h as a SystemC module